@@ -0,0 +1,46 @@
+#ifndef _alarm_state_H_
+#define _alarm_state_H_
+
+#include <stdint.h>
+
+namespace sensesp {
+
+/**
+ * @brief Debounce and hysteresis of one alarm rule
+ *
+ * The alarm flips after `debounce` consecutive samples on the other side:
+ * beyond the threshold to raise it, back past threshold -/+ hysteresis to
+ * clear it. A sample in between starts the count again.
+ *
+ * No Arduino dependency, so it can be tested on a host.
+ */
+struct AlarmState {
+  bool active = false;
+  uint8_t count = 0;
+
+  /// One sample; true if the alarm flipped with it
+  bool update(float value, bool above, float threshold, float hysteresis,
+              uint8_t debounce) {
+    bool beyond = above ? value > threshold : value < threshold;
+    bool back = above ? value < threshold - hysteresis
+                      : value > threshold + hysteresis;
+    if (!(active ? back : beyond)) {
+      count = 0;
+      return false;
+    }
+    if (++count < debounce) {
+      return false;
+    }
+    set(!active);
+    return true;
+  }
+
+  void set(bool alarm) {
+    active = alarm;
+    count = 0;
+  }
+};
+
+}  // namespace sensesp
+
+#endif
@@ -0,0 +1,242 @@
+#include "engine/burst_recorder.h"
+
+#include <ESPAsyncWebServer.h>
+#include <SPIFFS.h>
+#include <time.h>
+
+#include "sensesp.h"
+#include "system/phase_scheduler.h"
+
+// anything before this and the clock hasn't been set
+#define CLOCK_VALID_EPOCH 1600000000UL
+
+namespace sensesp {
+
+// units of the stored samples: 10 mV and 10 mA
+static const float VOLTS_LSB = 0.01f;
+static const float AMPS_LSB = 0.01f;
+
+BurstRecorder* BurstRecorder::recorders[MAX_ENGINES] = {};
+AsyncWebServer* BurstRecorder::server = nullptr;
+
+static int16_t to_lsb(float value, float lsb) {
+  return (int16_t)constrain(lroundf(value / lsb), -32768L, 32767L);
+}
+
+BurstRecorder::BurstRecorder(uint8_t engine, INA226* ina226, EdgeTimer* edges,
+                             uint16_t interval_ms, String config_path)
+    : Configurable(config_path),
+      engine{engine},
+      ina226{ina226},
+      edges{edges},
+      interval_ms{interval_ms} {
+  load_configuration();
+  if (engine < MAX_ENGINES) {
+    recorders[engine] = this;
+  }
+  task = PhaseScheduler::add("burst recorder", this->interval_ms,
+                             [this]() { this->sample(); });
+}
+
+String BurstRecorder::file_path(uint8_t engine, uint8_t slot) {
+  char path[16];
+  snprintf(path, sizeof(path), "/burst%u%u.bin", engine, slot);
+  return path;
+}
+
+void BurstRecorder::sample() {
+  if (state == State::freezing) {
+    freeze();
+    return;
+  }
+  if (parked) {
+    return;
+  }
+
+  BurstSample& s = ring[head];
+  s.volts = to_lsb(ina226->readBusVoltage(), VOLTS_LSB);
+  s.amps = to_lsb(ina226->readShuntCurrent(), AMPS_LSB);
+  s.period_us = (uint16_t)min(edges->get_period_us(), (uint32_t)0xFFFF);
+  head = (head + 1) % BURST_SAMPLES;
+  if (filled < BURST_SAMPLES) {
+    filled++;
+  }
+
+  if (state == State::post_trigger && --remaining == 0) {
+    // the ring now holds the pre trigger samples followed by the rest
+    header.samples = filled;
+    header.trigger = filled - BURST_POST_SAMPLES;
+    path = file_path(engine, captures % BURST_FILES);
+    written = 0;
+    state = State::freezing;
+  }
+}
+
+void BurstRecorder::set_parked(bool parked) {
+  if (parked == this->parked) {
+    return;
+  }
+  this->parked = parked;
+  PhaseScheduler::set_period(task, parked ? BURST_PARKED_MS : interval_ms);
+  if (!parked) {
+    // what the ring holds is from before parking, no use before a trigger
+    head = 0;
+    filled = 0;
+  }
+}
+
+void BurstRecorder::set_input(float revs, uint8_t input_channel) {
+  bool now_running = revs > 0;
+  if (now_running == running) {
+    return;
+  }
+  running = now_running;
+  trigger(running ? BurstEvent::start : BurstEvent::stop);
+}
+
+void BurstRecorder::trigger(BurstEvent event) {
+  if (state != State::armed) {
+    ignored++;
+    return;
+  }
+  memcpy(header.magic, "BRST", 4);
+  header.version = 1;
+  header.event = (uint8_t)event;
+  header.engine = engine;
+  header.reserved = 0;
+  time_t now = time(nullptr);
+  header.epoch = now > (time_t)CLOCK_VALID_EPOCH ? (uint32_t)now : 0;
+  header.uptime_ms = millis();
+  header.interval_ms = interval_ms;
+  header.reserved2 = 0;
+  header.volts_lsb = VOLTS_LSB;
+  header.amps_lsb = AMPS_LSB;
+  remaining = BURST_POST_SAMPLES;
+  state = State::post_trigger;
+}
+
+// Write the next chunk of the frozen ring, oldest sample first. Sampling
+// stops until the whole capture is on flash.
+void BurstRecorder::freeze() {
+  File file = SPIFFS.open(path, written == 0 ? FILE_WRITE : FILE_APPEND);
+  if (!file) {
+    debugE("Burst recorder: can't open %s", path.c_str());
+    state = State::armed;
+    return;
+  }
+  if (written == 0) {
+    file.write((const uint8_t*)&header, sizeof(header));
+  }
+  uint16_t oldest = (head + BURST_SAMPLES - filled) % BURST_SAMPLES;
+  uint16_t end = min((uint16_t)(written + BURST_WRITE_CHUNK), filled);
+  while (written < end) {
+    // up to the end of the chunk, or of the ring
+    uint16_t pos = (oldest + written) % BURST_SAMPLES;
+    uint16_t count = min((uint16_t)(end - written),
+                         (uint16_t)(BURST_SAMPLES - pos));
+    file.write((const uint8_t*)&ring[pos], count * sizeof(BurstSample));
+    written += count;
+  }
+  file.close();
+
+  if (written == filled) {
+    debugI("Burst recorder: %s captured to %s",
+           header.event == (uint8_t)BurstEvent::start ? "start" : "stop",
+           path.c_str());
+    captures++;
+    save_configuration();
+    // the next capture needs a full set of pre trigger samples of its own
+    filled = 0;
+    state = State::armed;
+  }
+}
+
+void BurstRecorder::serve(uint16_t port) {
+  if (server != nullptr) {
+    return;
+  }
+  server = new AsyncWebServer(port);
+
+  server->on("/bursts", HTTP_GET, [](AsyncWebServerRequest* request) {
+    String list = "[";
+    char item[96];
+    for (uint8_t e = 0; e < MAX_ENGINES; e++) {
+      if (recorders[e] == nullptr) {
+        continue;
+      }
+      for (uint8_t slot = 0; slot < BURST_FILES; slot++) {
+        String path = file_path(e, slot);
+        if (!SPIFFS.exists(path)) {
+          continue;
+        }
+        File file = SPIFFS.open(path, FILE_READ);
+        BurstHeader header;
+        size_t bytes = file.read((uint8_t*)&header, sizeof(header));
+        file.close();
+        if (bytes != sizeof(header)) {
+          continue;
+        }
+        snprintf(item, sizeof(item),
+                 "%s{\"engine\":%u,\"slot\":%u,\"event\":\"%s\",\"epoch\":%u,"
+                 "\"samples\":%u}",
+                 list.length() > 1 ? "," : "", e, slot,
+                 header.event == (uint8_t)BurstEvent::start ? "start" : "stop",
+                 header.epoch, header.samples);
+        list += item;
+      }
+    }
+    list += "]";
+    request->send(200, "application/json", list);
+  });
+
+  server->on("/burst", HTTP_GET, [](AsyncWebServerRequest* request) {
+    if (!request->hasParam("engine") || !request->hasParam("slot")) {
+      request->send(400, "text/plain", "engine and slot required");
+      return;
+    }
+    long e = request->getParam("engine")->value().toInt();
+    long slot = request->getParam("slot")->value().toInt();
+    if (e < 0 || e >= MAX_ENGINES || slot < 0 || slot >= BURST_FILES ||
+        !SPIFFS.exists(file_path(e, slot))) {
+      request->send(404, "text/plain", "no such capture");
+      return;
+    }
+    request->send(SPIFFS, file_path(e, slot), "application/octet-stream",
+                  true);
+  });
+
+  server->begin();
+}
+
+void BurstRecorder::get_configuration(JsonObject& root) {
+  root["interval"] = interval_ms;
+  root["captures"] = captures;
+  root["ignored"] = ignored;
+}
+
+static const char SCHEMA[] PROGMEM = R"###({
+    "type": "object",
+    "properties": {
+        "interval": { "title": "Sample interval", "type": "integer", "description": "Time between samples, in milliseconds; a capture covers 256 samples (applied after a restart)" },
+        "captures": { "title": "Captures taken", "type": "integer", "readOnly": true },
+        "ignored": { "title": "Edges ignored, capture under way", "type": "integer", "readOnly": true }
+    }
+  })###";
+
+String BurstRecorder::get_config_schema() { return FPSTR(SCHEMA); }
+
+bool BurstRecorder::set_configuration(const JsonObject& config) {
+  String expected[] = {"interval"};
+  for (auto str : expected) {
+    if (!config.containsKey(str)) {
+      return false;
+    }
+  }
+  interval_ms = config["interval"];
+  if (config.containsKey("captures")) {
+    captures = config["captures"];
+  }
+  return true;
+}
+
+}  // namespace sensesp
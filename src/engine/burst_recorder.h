@@ -0,0 +1,134 @@
+#ifndef _burst_recorder_H_
+#define _burst_recorder_H_
+
+#include <Wire.h>
+
+#include "engine/engine_instance.h"
+#include "sensesp/system/configurable.h"
+#include "sensesp/system/valueconsumer.h"
+#include "sensori/INA226.h"
+#include "sensori/edge_timer.h"
+#include "system/config_store.h"
+
+// samples kept before the trigger, and taken after it
+#define BURST_PRE_SAMPLES 128
+#define BURST_POST_SAMPLES 128
+#define BURST_SAMPLES (BURST_PRE_SAMPLES + BURST_POST_SAMPLES)
+// captures kept on flash per engine, the oldest one is overwritten
+#define BURST_FILES 4
+// samples written to flash per sample period while freezing
+#define BURST_WRITE_CHUNK 32
+// period of the sampling task while parked, when it doesn't sample
+#define BURST_PARKED_MS 1000
+
+class AsyncWebServer;
+
+namespace sensesp {
+
+/// What set off a capture
+enum class BurstEvent : uint8_t { stop = 0, start = 1 };
+
+/// Start of a capture file, 32 bytes, little endian
+struct BurstHeader {
+  char magic[4];         // "BRST"
+  uint8_t version;       // 1
+  uint8_t event;         // BurstEvent
+  uint8_t engine;        // EngineInstance index
+  uint8_t reserved;
+  uint32_t epoch;        // time of the trigger, 0 if the clock wasn't set
+  uint32_t uptime_ms;    // millis() at the trigger
+  uint16_t interval_ms;  // time between samples
+  uint16_t samples;      // samples following the header
+  uint16_t trigger;      // index of the first sample after the trigger
+  uint16_t reserved2;
+  float volts_lsb;       // BurstSample::volts unit, in V
+  float amps_lsb;        // BurstSample::amps unit, in A
+};
+
+/// One sample, 6 bytes
+struct BurstSample {
+  int16_t volts;       // alternator bus voltage, in volts_lsb
+  int16_t amps;        // alternator current, in amps_lsb
+  uint16_t period_us;  // latest W terminal pulse period, 0 when stopped
+};
+
+/**
+ * @brief Record alternator and RPM detail around engine starts and stops
+ *
+ * Every interval_ms the INA226 bus voltage and current and the latest pulse
+ * period of the EdgeTimer go into a fixed ring of BURST_SAMPLES samples, so
+ * the last BURST_PRE_SAMPLES are always at hand when the engine speed, fed to
+ * set_input(), goes from 0 to running or back. After BURST_POST_SAMPLES more
+ * the ring is frozen to /burst<engine><slot>.bin on SPIFFS, BURST_WRITE_CHUNK
+ * samples per period, so the file write doesn't hold up the other reactions.
+ * An edge that comes while a capture is still under way is counted and
+ * otherwise ignored.
+ *
+ * The recorder reads the INA226 registers itself, independent of the
+ * INA226value read delays, but only while running or idle, when the INA226
+ * converts continuously. Parked (see PowerManager) it neither reads nor
+ * starts conversions, so the chip stays powered down between the parked
+ * profile's readings, and its task runs once a second only.
+ *
+ * serve() makes the captures available over HTTP, on a port of their own:
+ *
+ *   GET /bursts                      list of captures, JSON
+ *   GET /burst?engine=0&slot=1       one capture, BurstHeader + samples
+ */
+class BurstRecorder : public FloatConsumer, public Configurable {
+ public:
+  BurstRecorder(uint8_t engine, INA226* ina226, EdgeTimer* edges,
+                uint16_t interval_ms = 50, String config_path = "");
+
+  /// Engine speed, in any unit, 0 when stopped
+  virtual void set_input(float revs, uint8_t input_channel = 0) override;
+
+  /// Stop or resume sampling, for the parked power profile
+  void set_parked(bool parked);
+
+  /// Serve the captures of all recorders; needs the SensESP app
+  static void serve(uint16_t port);
+
+  virtual void load_configuration() override { ConfigStore::load(this); }
+  virtual void save_configuration() override { ConfigStore::save(this); }
+  virtual void get_configuration(JsonObject& root) override;
+  virtual bool set_configuration(const JsonObject& config) override;
+  virtual String get_config_schema() override;
+
+ private:
+  enum class State : uint8_t { armed, post_trigger, freezing };
+
+  uint8_t engine;
+  INA226* ina226;
+  EdgeTimer* edges;
+  uint16_t interval_ms;
+  int task = -1;
+  bool parked = false;
+
+  BurstSample ring[BURST_SAMPLES];
+  uint16_t head = 0;   // next slot to fill
+  uint16_t filled = 0;
+  State state = State::armed;
+  bool running = false;
+
+  BurstHeader header;
+  uint16_t remaining = 0;  // post trigger samples still to take
+  uint16_t written = 0;    // samples frozen so far
+  String path;
+
+  uint32_t captures = 0;  // also picks the slot for the next one
+  uint32_t ignored = 0;
+
+  void sample();
+  void trigger(BurstEvent event);
+  void freeze();
+
+  static String file_path(uint8_t engine, uint8_t slot);
+
+  static BurstRecorder* recorders[MAX_ENGINES];
+  static AsyncWebServer* server;
+};
+
+}  // namespace sensesp
+
+#endif
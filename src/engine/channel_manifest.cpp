@@ -0,0 +1,22 @@
+#include "engine/channel_manifest.h"
+
+#include "system/boot_arena.h"
+
+namespace sensesp {
+
+String expand(const char* pattern, const char* engine) {
+  char buffer[64];
+  snprintf(buffer, sizeof(buffer), pattern, engine);
+  return String(buffer);
+}
+
+SKOutputFloat* make_sk_output(Channel channel, const char* engine) {
+  const ChannelSpec& spec = channel_spec(channel);
+  auto metadata = BootArena::make<SKMetadata>(
+      Subsystem::signalk, spec.units, expand(spec.display_name, engine),
+      spec.description, spec.short_name, spec.timeout);
+  return BootArena::make<TracedSKOutput>(
+      Subsystem::signalk, expand(spec.sk_path, engine), metadata);
+}
+
+}  // namespace sensesp
@@ -0,0 +1,208 @@
+#ifndef _channel_manifest_H_
+#define _channel_manifest_H_
+
+#include <Arduino.h>
+
+#include "sensesp/signalk/signalk_metadata.h"
+#include "sensesp/signalk/signalk_output.h"
+#include "system/latency_trace.h"
+
+namespace sensesp {
+
+/// Where a channel goes on the NMEA 2000 bus
+enum class N2kField : uint8_t {
+  none,
+  oil_temperature,      // PGN 127489 Engine Parameters, Dynamic
+  coolant_temperature,  // PGN 127489
+  alternator_voltage,   // PGN 127489
+  engine_hours,         // PGN 127489, from seconds
+  fuel_rate,            // PGN 127489, from m3/s
+  engine_speed,         // PGN 127488 Engine Parameters, Rapid, from rev/s
+  exhaust_temperature   // PGN 130312 Temperature, exhaust gas source
+};
+
+enum class Channel : uint8_t;
+
+/**
+ * @brief Everything there is to know about one engine channel
+ *
+ * Text fields marked as a pattern contain a single %s, which is replaced by the
+ * engine name. All of it is constant data, so it stays in flash.
+ */
+struct ChannelSpec {
+  Channel id;                 // its own index in CHANNELS
+  const char* units;          // Signal K units
+  const char* display_name;   // pattern
+  const char* description;
+  const char* short_name;
+  float timeout;              // seconds
+  const char* sk_path;        // pattern
+  const char* config_path;    // pattern for the source's web UI config, nullptr if none
+  N2kField n2k;
+  int8_t display_row;         // OLED text row, -1 if not shown
+  const char* display_label;
+  float display_scale;        // applied after the temperature unit conversion
+  uint8_t display_field;      // 1 for the second value of a shared row
+};
+
+enum class Channel : uint8_t {
+  oil_temperature,
+  coolant_temperature,
+  engine_temperature,
+  exhaust_temperature,
+  alternator_temperature,
+  alternator_voltage,
+  alternator_current,
+  alternator_power,
+  engine_runtime,
+  engine_revs,
+  alternator_alert,
+  alternator_ripple,
+  engine_roughness,
+  fuel_rate,
+  fuel_used,
+  oil_trend,
+  oil_time_to_limit,
+  coolant_trend,
+  coolant_time_to_limit,
+  exhaust_trend,
+  exhaust_time_to_limit,
+  alternator_trend,
+  alternator_time_to_limit,
+  ecu_coolant_deviation,
+  charging_voltage_drop,
+  count
+};
+
+constexpr size_t CHANNEL_COUNT = (size_t)Channel::count;
+
+// In the order of the Channel enum
+constexpr ChannelSpec CHANNELS[CHANNEL_COUNT] = {
+    {Channel::oil_temperature, "K", "%s Oil Temperature", "Engine Oil Temperature", "Oil Temp", 10.,
+     "propulsion.%s.oilTemperature", "/%sEngineOilTemp/oneWire",
+     N2kField::oil_temperature, 1, "Oil", 1.},
+    {Channel::coolant_temperature, "K", "%s Coolant Temperature", "Engine Coolant Temperature", "Coolant Temp", 10.,
+     "propulsion.%s.coolantTemperature", "/%sEngineCoolantTemp/oneWire",
+     N2kField::coolant_temperature, 2, "Coolant", 1.},
+    // the coolant temperature doubles as the overall engine temperature
+    {Channel::engine_temperature, "K", "%s Temperature", "Engine Temperature", "Engine Temp", 10.,
+     "propulsion.%s.temperature", nullptr,
+     N2kField::none, -1, nullptr, 1.},
+    // propulsion.*.exhaustTemperature is a standard path, we use it for the wet exhaust
+    {Channel::exhaust_temperature, "K", "%s Exhaust Temperature", "Wet Exhaust Temperature", "Exhaust Temp", 10.,
+     "propulsion.%s.exhaustTemperature", "/%sEngineWetExhaustTemp/oneWire",
+     N2kField::exhaust_temperature, 3, "Exhaust", 1.},
+    {Channel::alternator_temperature, "K", "%s Alternator Temperature", "Alternator Temperature", "Alternator Temp", 10.,
+     "electrical.%s.alternators.temperature", "/%sAlternatorTemp/oneWire",
+     N2kField::none, 4, "Alternator", 1.},
+    {Channel::alternator_voltage, "V", "%s Alternator Voltage", "Alternator Output Voltage", "Alternator V", 10.,
+     "electrical.alternators.%s.voltage", "/%s_Alternator/Electrics/Voltage",
+     N2kField::alternator_voltage, 5, "AltV", 1.},
+    {Channel::alternator_current, "A", "%s Alternator Current", "Alternator Output Current", "Alternator A", 10.,
+     "electrical.alternators.%s.current", "/%s_Alternator/Electrics/Current",
+     N2kField::none, 5, "AltA", 1., 1},
+    {Channel::alternator_power, "W", "%s Alternator Power", "Alternator Output Power", "Alternator W", 10.,
+     "electrical.alternators.%s.power", "/%s_Alternator/Electrics/Power",
+     N2kField::none, -1, nullptr, 1.},
+    // Total running time for engine (Engine Hours in seconds), displayed in hours
+    {Channel::engine_runtime, "s", "%s Engine Runtime", "Total hrs running", "Engine hrs", 10.,
+     "propulsion.%s.runTime", "/%s_engine_hrs/begin_value",
+     N2kField::engine_hours, 7, "Hours", 1. / 3600.},
+    // Signal K wants revolutions in Hz, displayed in RPM
+    {Channel::engine_revs, "Hz", "%s Engine speed", "Engine revs", "Speed", 10.,
+     "propulsion.%s.revolutions", "/%s_engine_rpm/calibrate",
+     N2kField::engine_speed, 6, "RPM", 60.},
+    // 1 while the INA226 comparator reports an alert, see INA226Alert
+    {Channel::alternator_alert, "", "%s Alternator Alert", "Alternator hardware alert", "Alternator alert", 10.,
+     "electrical.alternators.%s.hardwareAlert", "/%s_Alternator/Electrics/Alert",
+     N2kField::none, -1, nullptr, 1.},
+    // diode/stator health, see AlternatorRipple
+    {Channel::alternator_ripple, "ratio", "%s Alternator Ripple", "Alternator ripple at 1x and 2x over 6x the electrical frequency", "Alternator ripple", 300.,
+     "electrical.alternators.%s.rippleRatio", "/%s_Alternator/Ripple",
+     N2kField::none, -1, nullptr, 1.},
+    // crank speed variation, see EdgeTimer; its config is the RPM input's
+    {Channel::engine_roughness, "ratio", "%s Engine Roughness", "Crank speed variation within and between revolutions", "Roughness", 10.,
+     "propulsion.%s.roughness", "/%s_engine_rpm/edges",
+     N2kField::none, -1, nullptr, 1.},
+    // estimated from RPM and the consumption table, see FuelRate
+    {Channel::fuel_rate, "m3/s", "%s Fuel Rate", "Estimated fuel rate", "Fuel rate", 10.,
+     "propulsion.%s.fuel.rate", "/%s_engine_fuel/rate",
+     N2kField::fuel_rate, -1, nullptr, 1.},
+    {Channel::fuel_used, "m3", "%s Fuel Used", "Estimated fuel used", "Fuel used", 10.,
+     "propulsion.%s.fuel.used", "/%s_engine_fuel/used",
+     N2kField::none, -1, nullptr, 1.},
+    // temperature trends and the time until the alarm threshold at that
+    // rate, see TemperatureTrend; the trend's config covers both
+    {Channel::oil_trend, "K/s", "%s Oil Temperature Trend", "Engine oil temperature rate of change", "Oil trend", 10.,
+     "propulsion.%s.oilTemperatureTrend", "/%sEngineOilTemp/trend",
+     N2kField::none, -1, nullptr, 1.},
+    {Channel::oil_time_to_limit, "s", "%s Oil Time To Limit", "Time until the oil temperature alarm at the current trend", "Oil to limit", 10.,
+     "propulsion.%s.oilTemperatureTimeToLimit", nullptr,
+     N2kField::none, -1, nullptr, 1.},
+    {Channel::coolant_trend, "K/s", "%s Coolant Temperature Trend", "Engine coolant temperature rate of change", "Coolant trend", 10.,
+     "propulsion.%s.coolantTemperatureTrend", "/%sEngineCoolantTemp/trend",
+     N2kField::none, -1, nullptr, 1.},
+    {Channel::coolant_time_to_limit, "s", "%s Coolant Time To Limit", "Time until the coolant temperature alarm at the current trend", "Coolant to limit", 10.,
+     "propulsion.%s.coolantTemperatureTimeToLimit", nullptr,
+     N2kField::none, -1, nullptr, 1.},
+    {Channel::exhaust_trend, "K/s", "%s Exhaust Temperature Trend", "Wet exhaust temperature rate of change", "Exhaust trend", 10.,
+     "propulsion.%s.exhaustTemperatureTrend", "/%sEngineWetExhaustTemp/trend",
+     N2kField::none, -1, nullptr, 1.},
+    {Channel::exhaust_time_to_limit, "s", "%s Exhaust Time To Limit", "Time until the wet exhaust temperature alarm at the current trend", "Exhaust to limit", 10.,
+     "propulsion.%s.exhaustTemperatureTimeToLimit", nullptr,
+     N2kField::none, -1, nullptr, 1.},
+    {Channel::alternator_trend, "K/s", "%s Alternator Temperature Trend", "Alternator temperature rate of change", "Alternator trend", 10.,
+     "electrical.%s.alternators.temperatureTrend", "/%sAlternatorTemp/trend",
+     N2kField::none, -1, nullptr, 1.},
+    {Channel::alternator_time_to_limit, "s", "%s Alternator Time To Limit", "Time until the alternator temperature alarm at the current trend", "Alternator to limit", 10.,
+     "electrical.%s.alternators.temperatureTimeToLimit", nullptr,
+     N2kField::none, -1, nullptr, 1.},
+    // cross-checks against other nodes on the N2K bus, see N2kRx: our coolant
+    // temperature minus the ECU's, and our alternator voltage minus the
+    // voltage of the battery it charges, i.e. the loss in the charging path
+    {Channel::ecu_coolant_deviation, "K", "%s ECU Coolant Deviation", "Coolant temperature here minus the engine ECU's", "ECU coolant dev", 10.,
+     "propulsion.%s.coolantTemperatureEcuDeviation", nullptr,
+     N2kField::none, -1, nullptr, 1.},
+    {Channel::charging_voltage_drop, "V", "%s Charging Voltage Drop", "Alternator voltage minus the battery voltage", "Charge drop", 10.,
+     "electrical.alternators.%s.chargingVoltageDrop", nullptr,
+     N2kField::none, -1, nullptr, 1.},
+};
+
+constexpr bool channels_in_order(size_t i = 0) {
+  return i == CHANNEL_COUNT ||
+         (CHANNELS[i].id == (Channel)i && channels_in_order(i + 1));
+}
+
+static_assert(channels_in_order(),
+              "CHANNELS is not in the order of the Channel enum");
+
+constexpr const ChannelSpec& channel_spec(Channel channel) {
+  return CHANNELS[(size_t)channel];
+}
+
+constexpr bool is_kelvin(const char* units) {
+  return units[0] == 'K' && units[1] == '\0';
+}
+
+/// Fill in the engine name in one of the manifest's patterns
+String expand(const char* pattern, const char* engine);
+
+/// The Signal K output of a channel, recording the age of every value it is
+/// handed with LatencyTrace
+class TracedSKOutput : public SKOutputFloat {
+ public:
+  TracedSKOutput(String sk_path, SKMetadata* meta)
+      : SKOutputFloat(sk_path, "", meta) {}
+
+  virtual void set_input(float value, uint8_t input_channel = 0) override {
+    LatencyTrace::record(LatencySink::signalk, LatencyTrace::current());
+    SKOutputFloat::set_input(value, input_channel);
+  }
+};
+
+/// Create the Signal K metadata and output for a channel, in the boot arena
+SKOutputFloat* make_sk_output(Channel channel, const char* engine);
+
+}  // namespace sensesp
+
+#endif
@@ -0,0 +1,133 @@
+#include "engine/engine_alarms.h"
+
+#include "system/boot_arena.h"
+
+namespace sensesp {
+
+EngineAlarms::EngineAlarms(const char* engine, String config_path)
+    : Configurable(config_path), engine{engine} {
+  char path[64];
+  for (size_t i = 0; i < ALARM_RULE_COUNT; i++) {
+    thresholds[i] = ALARM_RULES[i].threshold;
+    snprintf(path, sizeof(path), "notifications.propulsion.%s.%s", engine,
+             ALARM_RULES[i].id);
+    notifications[i] =
+        BootArena::make<SKOutputRawJson>(Subsystem::signalk, path, "");
+  }
+  load_configuration();
+}
+
+bool EngineAlarms::watches(Channel channel) {
+  for (const AlarmRule& rule : ALARM_RULES) {
+    if (rule.channel == channel) {
+      return true;
+    }
+  }
+  return false;
+}
+
+float EngineAlarms::high_threshold(Channel channel) const {
+  for (size_t i = 0; i < ALARM_RULE_COUNT; i++) {
+    if (ALARM_RULES[i].channel == channel && ALARM_RULES[i].above) {
+      return thresholds[i];
+    }
+  }
+  return NAN;
+}
+
+bool EngineAlarms::evaluate(Channel channel, float value) {
+  bool changed = false;
+  for (size_t i = 0; i < ALARM_RULE_COUNT; i++) {
+    const AlarmRule& rule = ALARM_RULES[i];
+    if (rule.channel != channel || (rule.when_running && !running)) {
+      continue;
+    }
+    if (states[i].update(value, rule.above, thresholds[i], rule.hysteresis,
+                         rule.debounce)) {
+      changed |= set_active(i, states[i].active);
+    }
+  }
+  return changed;
+}
+
+bool EngineAlarms::set_running(bool now_running) {
+  if (now_running == running) {
+    return false;
+  }
+  running = now_running;
+  bool changed = false;
+  if (!running) {
+    // what only matters while running can't stay raised with the engine off
+    for (size_t i = 0; i < ALARM_RULE_COUNT; i++) {
+      if (ALARM_RULES[i].when_running && states[i].active) {
+        changed |= set_active(i, false);
+      }
+    }
+  }
+  return changed;
+}
+
+bool EngineAlarms::set_active(size_t rule, bool alarm) {
+  states[rule].set(alarm);
+
+  // alarms change rarely, building the notification may allocate
+  char message[64];
+  snprintf(message, sizeof(message), ALARM_RULES[rule].message, engine);
+  char json[160];
+  snprintf(json, sizeof(json),
+           R"({"state":"%s","method":["visual","sound"],"message":"%s"})",
+           alarm ? "alarm" : "normal", message);
+  notifications[rule]->set_input(json);
+
+  uint32_t previous = status;
+  status = combined_status();
+  return status != previous;
+}
+
+// several rules may share a bit, it is set while any of them is active
+uint32_t EngineAlarms::combined_status() const {
+  uint32_t bits = 0;
+  for (size_t i = 0; i < ALARM_RULE_COUNT; i++) {
+    if (states[i].active) {
+      bits |= 1UL << ALARM_RULES[i].status_bit;
+    }
+  }
+  return bits;
+}
+
+void EngineAlarms::get_configuration(JsonObject& root) {
+  for (size_t i = 0; i < ALARM_RULE_COUNT; i++) {
+    if (ALARM_RULES[i].channel != Channel::alternator_alert) {
+      root[ALARM_RULES[i].id] = thresholds[i];
+    }
+  }
+}
+
+static const char SCHEMA[] PROGMEM = R"###({
+    "type": "object",
+    "properties": {
+        "coolantHigh": { "title": "Coolant temperature high", "type": "number", "description": "Kelvin" },
+        "oilHigh": { "title": "Oil temperature high", "type": "number", "description": "Kelvin" },
+        "exhaustHigh": { "title": "Wet exhaust temperature high", "type": "number", "description": "Kelvin, only while running" },
+        "chargeLow": { "title": "Alternator voltage low", "type": "number", "description": "Volts, only while running" },
+        "alternatorHigh": { "title": "Alternator temperature high", "type": "number", "description": "Kelvin" },
+        "coolantRising": { "title": "Coolant time to limit", "type": "number", "description": "Seconds until the coolant alarm at the current trend, only while running" },
+        "oilRising": { "title": "Oil time to limit", "type": "number", "description": "Seconds until the oil alarm at the current trend, only while running" },
+        "exhaustRising": { "title": "Wet exhaust time to limit", "type": "number", "description": "Seconds until the wet exhaust alarm at the current trend, only while running" },
+        "alternatorRising": { "title": "Alternator time to limit", "type": "number", "description": "Seconds until the alternator alarm at the current trend, only while running" }
+    }
+  })###";
+
+String EngineAlarms::get_config_schema() { return FPSTR(SCHEMA); }
+
+// rules that are not in the schema keep their default threshold
+bool EngineAlarms::set_configuration(const JsonObject& config) {
+  for (size_t i = 0; i < ALARM_RULE_COUNT; i++) {
+    if (config.containsKey(ALARM_RULES[i].id)) {
+      thresholds[i] = config[ALARM_RULES[i].id];
+    }
+  }
+  return true;
+}
+
+}  // namespace sensesp
@@ -0,0 +1,116 @@
+#ifndef _engine_alarms_H_
+#define _engine_alarms_H_
+
+#include "engine/alarm_state.h"
+#include "engine/channel_manifest.h"
+#include "sensesp/signalk/signalk_output.h"
+#include "sensesp/system/configurable.h"
+#include "system/config_store.h"
+
+namespace sensesp {
+
+/**
+ * @brief A threshold on one channel that sets an Engine Discrete Status bit
+ *
+ * The alarm is raised after `debounce` consecutive samples beyond the
+ * threshold and cleared after as many samples back on the right side of
+ * threshold -/+ hysteresis. With a debounce of 1, an alarm reaches the bus
+ * with the sample that crossed the threshold.
+ */
+struct AlarmRule {
+  const char* id;       // config key and last part of the SK notification path
+  Channel channel;
+  bool above;           // alarm above the threshold, otherwise below it
+  float threshold;      // default, in the channel's Signal K units
+  float hysteresis;
+  uint8_t debounce;     // consecutive samples to raise or clear
+  bool when_running;    // only evaluated while the engine runs
+  uint8_t status_bit;   // 0-15 Discrete Status 1, 16-31 Discrete Status 2
+  const char* message;  // pattern, %s = engine name
+};
+
+// Bit numbers in PGN 127489 Engine Discrete Status 1 and (+16) Status 2
+#define N2K_STATUS_OVER_TEMPERATURE 1
+#define N2K_STATUS_WATER_FLOW 7
+#define N2K_STATUS_CHARGE_INDICATOR 9
+#define N2K_STATUS_WARNING_LEVEL_1 16
+#define N2K_STATUS_WARNING_LEVEL_2 17
+
+constexpr AlarmRule ALARM_RULES[] = {
+    {"coolantHigh", Channel::coolant_temperature, true, 368.15, 3., 1, false,
+     N2K_STATUS_OVER_TEMPERATURE, "%s engine coolant over temperature"},
+    {"oilHigh", Channel::oil_temperature, true, 393.15, 3., 1, false,
+     N2K_STATUS_OVER_TEMPERATURE, "%s engine oil over temperature"},
+    // a hot wet exhaust means too little raw water
+    {"exhaustHigh", Channel::exhaust_temperature, true, 343.15, 5., 1, true,
+     N2K_STATUS_WATER_FLOW, "%s engine wet exhaust hot, check raw water flow"},
+    {"chargeLow", Channel::alternator_voltage, false, 13.0, 0.3, 3, true,
+     N2K_STATUS_CHARGE_INDICATOR, "%s alternator not charging"},
+    {"alternatorHigh", Channel::alternator_temperature, true, 373.15, 5., 1,
+     false, N2K_STATUS_WARNING_LEVEL_1, "%s alternator over temperature"},
+    // early warnings: the temperature trend reaches the threshold above
+    // within the time given here, in seconds
+    {"coolantRising", Channel::coolant_time_to_limit, false, 600., 60., 3, true,
+     N2K_STATUS_WARNING_LEVEL_1, "%s engine coolant rising fast, check raw water"},
+    {"oilRising", Channel::oil_time_to_limit, false, 600., 60., 3, true,
+     N2K_STATUS_WARNING_LEVEL_1, "%s engine oil temperature rising fast"},
+    {"exhaustRising", Channel::exhaust_time_to_limit, false, 300., 60., 3, true,
+     N2K_STATUS_WARNING_LEVEL_1, "%s wet exhaust rising fast, check raw water flow"},
+    {"alternatorRising", Channel::alternator_time_to_limit, false, 600., 60., 3,
+     true, N2K_STATUS_WARNING_LEVEL_1, "%s alternator temperature rising fast"},
+    // raised by the INA226 comparator itself, the threshold is not configurable
+    {"alternatorAlert", Channel::alternator_alert, true, 0.5, 0., 1, false,
+     N2K_STATUS_WARNING_LEVEL_2, "%s alternator alert, check the regulator"},
+};
+
+constexpr size_t ALARM_RULE_COUNT = sizeof(ALARM_RULES) / sizeof(ALARM_RULES[0]);
+
+/**
+ * @brief Alarm rules of one engine, evaluated in the sample path
+ *
+ * evaluate() only looks at the rules of the channel that was updated and
+ * keeps the combined Discrete Status bits up to date, so the caller can send
+ * PGN 127489 right away when they change. Each rule also raises and clears a
+ * Signal K notification on notifications.propulsion.<engine>.<id>.
+ * Thresholds are configurable in the web UI.
+ */
+class EngineAlarms : public Configurable {
+ public:
+  EngineAlarms(const char* engine, String config_path = "");
+
+  /// Whether any rule looks at this channel
+  static bool watches(Channel channel);
+
+  /// The configured threshold of the channel's first high alarm, NAN if none
+  float high_threshold(Channel channel) const;
+
+  /// New value for a channel; true if the status bits changed
+  bool evaluate(Channel channel, float value);
+
+  /// Engine running or not; true if the status bits changed
+  bool set_running(bool running);
+
+  uint16_t get_status1() const { return status & 0xFFFF; }
+  uint16_t get_status2() const { return status >> 16; }
+
+  virtual void load_configuration() override { ConfigStore::load(this); }
+  virtual void save_configuration() override { ConfigStore::save(this); }
+  virtual void get_configuration(JsonObject& doc) override;
+  virtual bool set_configuration(const JsonObject& config) override;
+  virtual String get_config_schema() override;
+
+ private:
+  const char* engine;
+  bool running = false;
+  uint32_t status = 0;
+  float thresholds[ALARM_RULE_COUNT];
+  AlarmState states[ALARM_RULE_COUNT];
+  SKOutputRawJson* notifications[ALARM_RULE_COUNT];
+
+  bool set_active(size_t rule, bool alarm);
+  uint32_t combined_status() const;
+};
+
+}  // namespace sensesp
+
+#endif
@@ -0,0 +1,409 @@
+#include "engine/engine_instance.h"
+
+#include <N2kMessages.h>
+
+#include "engine/burst_recorder.h"
+#include "engine/sk_store_forward.h"
+#include "engine/udp_broadcast.h"
+#include "sensesp/system/lambda_consumer.h"
+#include "sensori/activity_timer.h"
+#include "sensori/alternator_ripple.h"
+#include "sensori/combiner.h"
+#include "sensori/difference.h"
+#include "sensori/edge_timer.h"
+#include "sensori/fuel_rate.h"
+#include "sensori/fuel_used.h"
+#include "sensori/ina226_alert.h"
+#include "sensori/ina226value.h"
+#include "sensori/phased_onewire.h"
+#include "sensori/pipeline.h"
+#include "sensori/temperature_trend.h"
+#include "sensori/window_stats.h"
+#include "system/boot_arena.h"
+#include "system/boot_profiler.h"
+#include "system/latency_trace.h"
+#include "system/n2k_rx.h"
+#include "system/phase_scheduler.h"
+
+// how often pending Engine Dynamic Parameters are sent, for all engines
+#define N2K_DYNAMIC_PERIOD_MS 100
+
+namespace sensesp {
+
+EngineInstance* EngineInstance::instances[MAX_ENGINES] = {};
+size_t EngineInstance::instance_count = 0;
+
+EngineInstance::EngineInstance(const EngineConfig& config, EngineBus& bus)
+    : config{config}, index{(uint8_t)instance_count}, bus{bus} {
+  if (instance_count < MAX_ENGINES) {
+    instances[instance_count++] = this;
+  } else {
+    debugE("FATAL: more than %d engines", MAX_ENGINES);
+  }
+}
+
+void EngineInstance::begin_io() {
+  // start the INA266 current & voltage measurements for the alternator
+  ina226 = BootArena::make<INA226>(Subsystem::io, bus.i2c);
+  ina226->begin(config.ina226_address);
+  ina226->configure(INA226_AVERAGES_1, INA226_BUS_CONV_TIME_1100US,
+                    INA226_SHUNT_CONV_TIME_1100US, INA226_MODE_SHUNT_BUS_CONT);
+  ina226->calibrate(0.01, 4);
+  // Now the INA226 is ready for reading, which will be done by the INA226value class.
+}
+
+void EngineInstance::build() {
+  const char* engine = config.name;
+
+  // four 1-Wire temperature sensors on the shared bus, they update every
+  // 1000 ms, each at its own phase, and each has its own web UI
+  // configuration path
+  const Channel onewire_channels[] = {
+      Channel::oil_temperature, Channel::coolant_temperature,
+      Channel::exhaust_temperature, Channel::alternator_temperature};
+  for (auto ch : onewire_channels) {
+    sources[(size_t)ch] = BootArena::make<PhasedOneWireTemperature>(
+        Subsystem::sensors, bus.onewire, 1000, channel_spec(ch).short_name,
+        expand(channel_spec(ch).config_path, engine));
+#ifdef LATENCY_TRACE
+    // the 1-Wire sensor is library code, its chains start on the way out
+    sources[(size_t)ch] = sources[(size_t)ch]->connect_to(
+        BootArena::make<LatencyOrigin>(Subsystem::transforms));
+#endif
+  }
+  // transmit coolant temperature as overall engine temperature as well
+  sources[(size_t)Channel::engine_temperature] =
+      sources[(size_t)Channel::coolant_temperature];
+
+  // RPM from the alternator W terminal, 13.23 pulses per crank revolution
+  // (6 pole pairs x 2.2044 pulley ratio). SignalK wants Hz, the display and
+  // N2K use the same calibrated value, the manifest scales it back to RPM.
+  const float pulses_per_rev = 13.23;
+  const float rpm_multiplier = 60.0 / pulses_per_rev;
+  // The counter also times every edge for the roughness index.
+  auto* dic = BootArena::make<EdgeTimer>(
+      Subsystem::sensors, config.rpm_pin, INPUT_PULLUP, RISING, 200U,
+      (uint8_t)(pulses_per_rev + 0.5f),
+      expand(channel_spec(Channel::engine_roughness).config_path, engine));
+  edges = dic;
+  sources[(size_t)Channel::engine_roughness] = &dic->roughness();
+  sources[(size_t)Channel::engine_revs] =
+      dic->connect_to(BootArena::make<Pipe<int, FrequencyStage>>(
+          Subsystem::transforms,
+          FrequencyStage::Params{
+              rpm_multiplier / 60.0f,
+              expand(channel_spec(Channel::engine_revs).config_path, engine)}));
+
+  // the hour meter runs while there are RPM's, SK wants seconds
+  timer = BootArena::make<ActivityTimer>(
+      Subsystem::transforms, 1.0,
+      expand(channel_spec(Channel::engine_runtime).config_path, engine));
+  dic->connect_to(timer);
+  sources[(size_t)Channel::engine_runtime] =
+      timer->connect_to(BootArena::make<Pipe<float, LinearStage>>(
+          Subsystem::transforms, LinearStage::Params{3600.0, 0.0, ""}));
+
+  volts = BootArena::make<INA226value>(
+      Subsystem::sensors, ina226, bus_voltage, 1000U,
+      expand(channel_spec(Channel::alternator_voltage).config_path, engine));
+  amps = BootArena::make<INA226value>(
+      Subsystem::sensors, ina226, current, 1000U,
+      expand(channel_spec(Channel::alternator_current).config_path, engine));
+  sources[(size_t)Channel::alternator_voltage] = volts;
+  sources[(size_t)Channel::alternator_current] = amps;
+
+  // alternator output power, combine volts and amps that are at most 1.5 s apart
+  auto* power = BootArena::make<Combiner<2>>(
+      Subsystem::transforms,
+      [](const std::array<float, 2>& in) { return in[0] * in[1]; },
+      CombinerPolicy::any_update, 1500U, 1000U,
+      expand(channel_spec(Channel::alternator_power).config_path, engine));
+  volts->connect_to(power, 0);
+  amps->connect_to(power, 1);
+  sources[(size_t)Channel::alternator_power] = power;
+
+  alarms = BootArena::make<EngineAlarms>(
+      Subsystem::consumers, engine, expand("/%sEngineAlarms", engine));
+
+  // how fast the temperatures rise, and how long until their alarm threshold
+  // at that rate: a failing impeller shows long before the coolant alarm
+  const Channel trend_channels[][3] = {
+      {Channel::oil_temperature, Channel::oil_trend,
+       Channel::oil_time_to_limit},
+      {Channel::coolant_temperature, Channel::coolant_trend,
+       Channel::coolant_time_to_limit},
+      {Channel::exhaust_temperature, Channel::exhaust_trend,
+       Channel::exhaust_time_to_limit},
+      {Channel::alternator_temperature, Channel::alternator_trend,
+       Channel::alternator_time_to_limit}};
+  for (auto& ch : trend_channels) {
+    // the threshold as configured now, not as it was at boot
+    EngineAlarms* limits = alarms;
+    Channel channel = ch[0];
+    auto* trend = BootArena::make<TemperatureTrend>(
+        Subsystem::transforms,
+        [limits, channel]() { return limits->high_threshold(channel); },
+        (uint8_t)120, 5.0f, expand(channel_spec(ch[1]).config_path, engine));
+    sources[(size_t)ch[0]]->connect_to(trend);
+    sources[(size_t)ch[1]] = trend;
+    sources[(size_t)ch[2]] = &trend->time_to_limit();
+  }
+
+  // fuel rate from RPM and the consumption table, and the total used
+  auto* rate = BootArena::make<FuelRate>(
+      Subsystem::transforms, 3600.0,
+      expand(channel_spec(Channel::fuel_rate).config_path, engine));
+  sources[(size_t)Channel::engine_revs]->connect_to(rate);
+  sources[(size_t)Channel::fuel_rate] = rate;
+  sources[(size_t)Channel::fuel_used] =
+      rate->connect_to(BootArena::make<FuelUsed>(
+          Subsystem::transforms, 0.01,
+          expand(channel_spec(Channel::fuel_used).config_path, engine)));
+
+  // bus voltage ripple bursts, paced by the engine speed updates
+  auto* ripple = BootArena::make<AlternatorRipple>(
+      Subsystem::transforms, ina226, pulses_per_rev, 60000U,
+      expand(channel_spec(Channel::alternator_ripple).config_path, engine));
+  sources[(size_t)Channel::engine_revs]->connect_to(ripple);
+  sources[(size_t)Channel::alternator_ripple] = ripple;
+
+  // alternator and RPM detail from just before to just after a start or stop
+  burst = BootArena::make<BurstRecorder>(Subsystem::consumers, index, ina226,
+                                         dic, (uint16_t)50,
+                                         expand("/%sBurstRecorder", engine));
+  sources[(size_t)Channel::engine_revs]->connect_to(burst);
+
+  // the INA226 comparator catches what the 1 s readings miss, e.g. a load dump
+  if (config.ina226_alert_pin >= 0) {
+    sources[(size_t)Channel::alternator_alert] = BootArena::make<INA226Alert>(
+        Subsystem::sensors, ina226, config.ina226_alert_pin,
+        INA226AlertFunction::bus_over, 15.5, 5000U,
+        expand(channel_spec(Channel::alternator_alert).config_path, engine));
+  }
+
+  // what the engine's ECU and the battery monitor report on N2K, against our
+  // own readings
+  if (bus.n2k_rx != nullptr) {
+    uint8_t instance = config.n2k_instance;
+    auto* ecu_coolant =
+        BootArena::make<ObservableValue<float>>(Subsystem::sensors);
+    bus.n2k_rx->subscribe<N2kEngineDynamic>(
+        [ecu_coolant, instance](const N2kEngineDynamic& ecu) {
+          if (ecu.instance == instance && !N2kIsNA(ecu.coolant_temperature)) {
+            LatencyChain chain;
+            ecu_coolant->set(ecu.coolant_temperature);
+          }
+        });
+    auto* coolant_deviation =
+        BootArena::make<Difference>(Subsystem::transforms, 1.0f, 1.0f);
+    sources[(size_t)Channel::coolant_temperature]->connect_to(coolant_deviation);
+    ecu_coolant->connect_to(coolant_deviation, 1);
+    sources[(size_t)Channel::ecu_coolant_deviation] = coolant_deviation;
+
+    if (config.battery_instance >= 0) {
+      uint8_t battery_instance = config.battery_instance;
+      auto* battery_volts =
+          BootArena::make<ObservableValue<float>>(Subsystem::sensors);
+      bus.n2k_rx->subscribe<N2kBatteryStatus>(
+          [battery_volts, battery_instance](const N2kBatteryStatus& battery) {
+            if (battery.instance == battery_instance &&
+                !N2kIsNA(battery.voltage)) {
+              LatencyChain chain;
+              battery_volts->set(battery.voltage);
+            }
+          });
+      auto* voltage_drop =
+          BootArena::make<Difference>(Subsystem::transforms, 1.0f, 1.0f);
+      volts->connect_to(voltage_drop);
+      battery_volts->connect_to(voltage_drop, 1);
+      sources[(size_t)Channel::charging_voltage_drop] = voltage_drop;
+    }
+  }
+
+  // a summary of the slow channels every 10 samples, over the last 60, so
+  // their Signal K rate can come down without losing the extremes
+  const Channel stats_channels[] = {
+      Channel::oil_temperature, Channel::coolant_temperature,
+      Channel::exhaust_temperature, Channel::alternator_temperature,
+      Channel::alternator_voltage, Channel::alternator_current};
+  for (auto ch : stats_channels) {
+    const ChannelSpec& spec = channel_spec(ch);
+    sources[(size_t)ch]
+        ->connect_to(BootArena::make<WindowStats>(
+            Subsystem::transforms, (uint8_t)60, (uint8_t)10,
+            expand(spec.config_path, engine) + "/stats"))
+        ->connect_to(BootArena::make<SKOutputRawJson>(
+            Subsystem::signalk, expand(spec.sk_path, engine) + "Stats", ""));
+  }
+
+  // Now wire every channel from the manifest: its Signal K output, and a
+  // single consumer that updates the display row, the N2K field, the alarms
+  // and the other sinks on the bus.
+  for (size_t i = 0; i < CHANNEL_COUNT; i++) {
+    const ChannelSpec* spec = &CHANNELS[i];
+    if (sources[i] == nullptr) {
+      continue;
+    }
+    sources[i]->connect_to(make_sk_output((Channel)i, engine));
+    sources[i]->connect_to(BootArena::make<LambdaConsumer<float>>(
+        Subsystem::consumers,
+        [this, spec](float value) { this->update(*spec, value); }));
+  }
+}
+
+void EngineInstance::update(const ChannelSpec& spec, float value) {
+  // when the value was acquired, kept with it where it waits to be sent;
+  // Signal K records its own, see make_sk_output()
+  acquired_us = LatencyTrace::current();
+  if (config.on_display && spec.display_row >= 0) {
+    // its latency is recorded when the page has gone out, see OledPages
+    bus.show(spec, value);
+  }
+  Channel channel = (Channel)(&spec - CHANNELS);
+  if (bus.store_forward != nullptr) {
+    bus.store_forward->record(index, channel, value);
+  }
+  if (bus.udp != nullptr) {
+    bus.udp->publish(index, channel, value);
+  }
+  bool alarm_changed = alarms->evaluate(channel, value);
+  if (channel == Channel::engine_revs) {
+    alarm_changed |= alarms->set_running(value > 0);
+  }
+  switch (spec.n2k) {
+    case N2kField::oil_temperature:
+      set_dynamic(oil_temperature, value);
+      break;
+    case N2kField::coolant_temperature:
+      set_dynamic(coolant_temperature, value);
+      break;
+    case N2kField::alternator_voltage:
+      set_dynamic(alternator_volts, value);
+      break;
+    case N2kField::fuel_rate:
+      set_dynamic(fuel_rate, value * 3600000.0);  // l/h
+      break;
+    case N2kField::engine_hours:
+      set_dynamic(engine_runtime, value);
+      break;
+    case N2kField::engine_speed:
+      send_speed(value * 60.0f);
+      break;
+    case N2kField::exhaust_temperature:
+      send_exhaust(value);
+      break;
+    default:
+      break;
+  }
+  if (alarm_changed) {
+    send_dynamic();
+  }
+}
+
+bool EngineInstance::is_running() const {
+  return timer != nullptr && timer->isActive();
+}
+
+void EngineInstance::set_ina226_profile(uint read_delay, bool power_down) {
+  if (volts == nullptr) {
+    return;
+  }
+  volts->set_read_delay(read_delay);
+  amps->set_read_delay(read_delay);
+  // the recorder's 50 ms reads would keep the chip, and the CPU, awake
+  if (burst != nullptr) {
+    burst->set_parked(power_down);
+  }
+  if (power_down) {
+    // convert once per read, asleep in between; INA226value triggers the next
+    ina226->setMode(INA226_MODE_SHUNT_BUS_TRIG);
+    ina226->triggerConversion();
+  } else {
+    ina226->setMode(INA226_MODE_SHUNT_BUS_CONT);
+  }
+}
+
+void EngineInstance::count_rpm_edge() {
+  if (edges != nullptr) {
+    edges->count_edge();
+  }
+}
+
+EngineInstance* EngineInstance::get(size_t index) {
+  return index < instance_count ? instances[index] : nullptr;
+}
+
+// A field of the Engine Dynamic Parameters, sent by the scheduler. The
+// message is as old as the oldest value it carries.
+void EngineInstance::set_dynamic(double& field, double value) {
+  field = value;
+  if (!dynamic_pending) {
+    dynamic_pending = true;
+    dynamic_acquired_us = acquired_us;
+  }
+}
+
+void EngineInstance::start_n2k_scheduler() {
+  PhaseScheduler::add("N2K dynamic", N2K_DYNAMIC_PERIOD_MS, []() {
+    for (size_t i = 0; i < instance_count; i++) {
+      if (instances[i]->dynamic_pending) {
+        instances[i]->send_dynamic();
+      }
+    }
+  });
+}
+
+/**
+ * @brief Send Engine Dynamic Parameter data
+ *
+ * All unused fields are sent with undefined value. The status bit fields
+ * carry this engine's active alarms, see EngineAlarms.
+ */
+void EngineInstance::send_dynamic() {
+  tN2kMsg N2kMsg;
+  SetN2kEngineDynamicParam(N2kMsg,
+                           config.n2k_instance,
+                           N2kDoubleNA,       // oil pressure
+                           oil_temperature, coolant_temperature,
+                           alternator_volts,  // alternator voltage
+                           fuel_rate,         // fuel rate, in l/h
+                           engine_runtime,    // engine hours, in seconds
+                           N2kDoubleNA,       // engine coolant pressure
+                           N2kDoubleNA,       // engine fuel pressure
+                           N2kInt8NA,         // engine load
+                           N2kInt8NA,         // engine torque
+                           alarms->get_status1(), alarms->get_status2());
+  bus.n2k_tx->send(N2kMsg, config.n2k_instance,
+                   dynamic_pending ? dynamic_acquired_us : acquired_us);
+  dynamic_pending = false;
+  BootProfiler::reach(BootMilestone::first_n2k_engine);
+}
+
+/**
+ * @brief Send Engine Parameters, Rapid Update
+ *
+ * N2K expects Engine Speed to be the rotational speed of the engine in units
+ * of 1/4 RPM, SetN2kEngineParamRapid() takes plain RPM and does the scaling
+ * itself.
+ */
+void EngineInstance::send_speed(float rpm) {
+  tN2kMsg N2kMsg;
+  SetN2kEngineParamRapid(N2kMsg, config.n2k_instance, rpm);
+  bus.n2k_tx->send(N2kMsg, config.n2k_instance, acquired_us);
+  BootProfiler::reach(BootMilestone::first_n2k_engine);
+}
+
+// hijack the exhaust gas temperature for wet exhaust temperature measurement;
+// temperature instance 2 for engine 0, 3 for engine 1 and so on
+void EngineInstance::send_exhaust(float temperature) {
+  tN2kMsg N2kMsg;
+  SetN2kTemperature(N2kMsg,
+                    1,                            // SID
+                    2 + config.n2k_instance,      // TempInstance
+                    N2kts_ExhaustGasTemperature,  // TempSource
+                    temperature                   // actual temperature
+  );
+  bus.n2k_tx->send(N2kMsg, 2 + config.n2k_instance, acquired_us);
+}
+
+}  // namespace sensesp
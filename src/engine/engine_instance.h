@@ -0,0 +1,126 @@
+#ifndef _engine_instance_H_
+#define _engine_instance_H_
+
+#include <NMEA2000.h>
+#include <Wire.h>
+
+#include "engine/channel_manifest.h"
+#include "engine/engine_alarms.h"
+#include "sensesp_onewire/onewire_temperature.h"
+#include "sensori/INA226.h"
+#include "sensori/activity_timer.h"
+#include "sensori/ina226value.h"
+#include "system/n2k_tx_queue.h"
+
+// engines one board can monitor
+#define MAX_ENGINES 4
+
+namespace sensesp {
+
+class BurstRecorder;
+class EdgeTimer;
+class N2kRx;
+class SKStoreForward;
+class UDPBroadcast;
+
+/// What differs between the engines monitored by one board
+struct EngineConfig {
+  const char* name;         // used in SK paths, config paths and the hostname
+  uint8_t n2k_instance;     // N2K engine instance, 0 for a single engine
+  uint8_t rpm_pin;          // alternator W terminal, through the opto coupler
+  uint8_t ina226_address;   // alternator voltage/current monitor
+  int8_t ina226_alert_pin;  // the INA226 ALERT output, -1 if not wired
+  bool on_display;          // this engine's values go to the OLED
+  int8_t battery_instance;  // N2K instance of the battery it charges, -1 if none
+};
+
+/// The resources all engines on the board share
+struct EngineBus {
+  TwoWire* i2c;
+  DallasTemperatureSensors* onewire;
+  N2kTxQueue* n2k_tx;
+  // put a channel value on the display
+  void (*show)(const ChannelSpec& spec, float value);
+  // keeps values while the Signal K server is unreachable, optional
+  SKStoreForward* store_forward;
+  // broadcasts values on the local network, optional
+  UDPBroadcast* udp;
+  // data other nodes send on N2K, for cross-checks, optional
+  N2kRx* n2k_rx;
+};
+
+/**
+ * @brief One engine: its sensors, their outputs and its N2K state
+ *
+ * All engines share the 1-Wire bus, the I2C bus and the N2K node. Engine
+ * Dynamic Parameters (PGN 127489) are not sent on every field update but
+ * marked pending, and a single scheduler sends the pending ones for all
+ * engines every N2K_DYNAMIC_PERIOD_MS, so several field updates arriving
+ * within one period share a single frame. A change of the alarm status bits
+ * is sent right away, without waiting for the scheduler.
+ */
+class EngineInstance {
+ public:
+  EngineInstance(const EngineConfig& config, EngineBus& bus);
+
+  /// Configure the engine's chips; needs nothing from SensESP
+  void begin_io();
+
+  /// Create the sensors, transforms and outputs; needs the SensESP app
+  void build();
+
+  /// New value for one of this engine's channels
+  void update(const ChannelSpec& spec, float value);
+
+  /// Start the shared Engine Dynamic Parameters scheduler
+  static void start_n2k_scheduler();
+
+  /// Whether the hour meter sees the engine running
+  bool is_running() const;
+
+  /// Time between alternator readings; power_down has the INA226 sleep
+  /// between them
+  void set_ina226_profile(uint read_delay, bool power_down);
+
+  /// An RPM pulse that arrived with the pin's interrupt masked
+  void count_rpm_edge();
+
+  /// The engine registered at index, nullptr if there is none
+  static EngineInstance* get(size_t index);
+
+  const EngineConfig& config;
+  const uint8_t index;
+
+ private:
+  EngineBus& bus;
+  INA226* ina226 = nullptr;
+  INA226value* volts = nullptr;
+  INA226value* amps = nullptr;
+  BurstRecorder* burst = nullptr;
+  EdgeTimer* edges = nullptr;
+  ActivityTimer* timer = nullptr;
+  FloatProducer* sources[CHANNEL_COUNT] = {};
+  EngineAlarms* alarms = nullptr;
+
+  double oil_temperature = N2kDoubleNA;
+  double coolant_temperature = N2kDoubleNA;
+  double alternator_volts = N2kDoubleNA;
+  double engine_runtime = N2kDoubleNA;
+  double fuel_rate = N2kDoubleNA;
+  bool dynamic_pending = false;
+  uint32_t dynamic_acquired_us = 0;
+  uint32_t acquired_us = 0;  // LatencyTrace time of the value being updated
+
+  void set_dynamic(double& field, double value);
+
+  void send_dynamic();
+  void send_speed(float rpm);
+  void send_exhaust(float temperature);
+
+  static EngineInstance* instances[MAX_ENGINES];
+  static size_t instance_count;
+};
+
+}  // namespace sensesp
+
+#endif
@@ -0,0 +1,158 @@
+#include "engine/power_manager.h"
+
+#include <WiFi.h>
+#include <driver/gpio.h>
+#include <esp_sleep.h>
+#include <soc/gpio_struct.h>
+
+#include "sensesp.h"
+#include "system/phase_scheduler.h"
+
+namespace sensesp {
+
+static const char* const STATE_NAMES[] = {"running", "idle", "parked"};
+
+// Drop an interrupt the pin has latched but not delivered
+static void clear_interrupt(gpio_num_t pin) {
+  if (pin < 32) {
+    GPIO.status_w1tc = 1UL << pin;
+  } else {
+    GPIO.status1_w1tc.intr_st = 1UL << (pin - 32);
+  }
+}
+
+PowerManager::PowerManager(uint8_t can_rx_pin, String config_path)
+    : Configurable(config_path), can_rx_pin{can_rx_pin} {
+  load_configuration();
+}
+
+void PowerManager::start() {
+  stopped_since = millis();
+  apply(PowerState::running);
+  PhaseScheduler::add("power", 1000, [this]() { this->evaluate(); });
+  ReactESP::app->onTick([this]() {
+    if (state == PowerState::parked && sleep_enabled) {
+      this->light_sleep();
+    }
+  });
+}
+
+void PowerManager::evaluate() {
+  bool running = false;
+  for (size_t i = 0; EngineInstance::get(i) != nullptr; i++) {
+    running |= EngineInstance::get(i)->is_running();
+  }
+  unsigned long now = millis();
+  if (running) {
+    stopped_since = now;
+  }
+  PowerState new_state = running ? PowerState::running
+                         : now - stopped_since > parked_after_ms
+                             ? PowerState::parked
+                             : PowerState::idle;
+  if (new_state != state) {
+    apply(new_state);
+  }
+}
+
+void PowerManager::apply(PowerState new_state) {
+  debugI("Power profile: %s", STATE_NAMES[(size_t)new_state]);
+  bool parked = new_state == PowerState::parked;
+  for (size_t i = 0; EngineInstance::get(i) != nullptr; i++) {
+    EngineInstance::get(i)->set_ina226_profile(
+        ina226_delay[(size_t)new_state], parked);
+  }
+  if (sleep_enabled && parked) {
+    WiFi.mode(WIFI_OFF);
+  } else if (sleep_enabled && state == PowerState::parked) {
+    // reconnect with the stored credentials
+    WiFi.mode(WIFI_STA);
+    WiFi.begin();
+  }
+  state = new_state;
+}
+
+// Sleep until the timer or a level change on a wake-up pin. Each pin wakes on
+// the level it is not at now, so any edge will do.
+//
+// Waking on a level turns the pin's interrupt into a level interrupt too, so
+// the RPM pins' edge handlers are masked for the whole sleep; otherwise a pin
+// that changes before the sleep, or still sits at the wake level after it,
+// fires the handler over and over. The rising edge that woke the board is
+// counted by hand.
+void PowerManager::light_sleep() {
+  gpio_num_t pins[MAX_ENGINES + 1];
+  int levels[MAX_ENGINES + 1];
+  size_t count = 0;
+  pins[count++] = (gpio_num_t)can_rx_pin;
+  for (size_t i = 0; EngineInstance::get(i) != nullptr; i++) {
+    pins[count++] = (gpio_num_t)EngineInstance::get(i)->config.rpm_pin;
+  }
+  for (size_t i = 1; i < count; i++) {
+    gpio_intr_disable(pins[i]);
+  }
+  for (size_t i = 0; i < count; i++) {
+    levels[i] = digitalRead(pins[i]);
+    gpio_wakeup_enable(pins[i],
+                       levels[i] ? GPIO_INTR_LOW_LEVEL : GPIO_INTR_HIGH_LEVEL);
+  }
+  esp_sleep_enable_gpio_wakeup();
+  esp_sleep_enable_timer_wakeup((uint64_t)sleep_ms * 1000);
+  esp_light_sleep_start();
+  for (size_t i = 0; i < count; i++) {
+    gpio_wakeup_disable(pins[i]);
+  }
+  // back to rising edges, without what the level latched meanwhile
+  for (size_t i = 1; i < count; i++) {
+    gpio_set_intr_type(pins[i], GPIO_INTR_POSEDGE);
+    clear_interrupt(pins[i]);
+    if (!levels[i] && digitalRead(pins[i])) {
+      EngineInstance::get(i - 1)->count_rpm_edge();
+    }
+    gpio_intr_enable(pins[i]);
+  }
+}
+
+void PowerManager::get_configuration(JsonObject& root) {
+  root["running_delay"] = ina226_delay[(size_t)PowerState::running];
+  root["idle_delay"] = ina226_delay[(size_t)PowerState::idle];
+  root["parked_delay"] = ina226_delay[(size_t)PowerState::parked];
+  root["parked_after"] = parked_after_ms / 60000;
+  root["sleep"] = sleep_enabled;
+  root["sleep_ms"] = sleep_ms;
+  root["state"] = STATE_NAMES[(size_t)state];
+}
+
+static const char SCHEMA[] PROGMEM = R"###({
+    "type": "object",
+    "properties": {
+        "running_delay": { "title": "Alternator read delay, running", "type": "integer", "description": "Milliseconds between INA226 readings while an engine runs" },
+        "idle_delay": { "title": "Alternator read delay, idle", "type": "integer", "description": "Milliseconds between INA226 readings with the engines stopped" },
+        "parked_delay": { "title": "Alternator read delay, parked", "type": "integer", "description": "Milliseconds between INA226 readings when parked; the INA226 sleeps in between" },
+        "parked_after": { "title": "Parked after", "type": "integer", "description": "Minutes with all engines stopped before the board is parked" },
+        "sleep": { "title": "Sleep when parked", "type": "boolean", "description": "Switch WiFi off and light sleep between samples when parked; no OTA or web UI until an engine starts" },
+        "sleep_ms": { "title": "Sleep slice", "type": "integer", "description": "Longest light sleep, in milliseconds" },
+        "state": { "title": "State", "type": "string", "readOnly": true }
+    }
+  })###";
+
+String PowerManager::get_config_schema() { return FPSTR(SCHEMA); }
+
+bool PowerManager::set_configuration(const JsonObject& config) {
+  String expected[] = {"running_delay", "idle_delay", "parked_delay",
+                       "parked_after", "sleep", "sleep_ms"};
+  for (auto str : expected) {
+    if (!config.containsKey(str)) {
+      return false;
+    }
+  }
+  ina226_delay[(size_t)PowerState::running] = config["running_delay"];
+  ina226_delay[(size_t)PowerState::idle] = config["idle_delay"];
+  ina226_delay[(size_t)PowerState::parked] = config["parked_delay"];
+  parked_after_ms = (uint32_t)config["parked_after"] * 60000;
+  sleep_enabled = config["sleep"];
+  sleep_ms = config["sleep_ms"];
+  return true;
+}
+
+}  // namespace sensesp
@@ -0,0 +1,69 @@
+#ifndef _power_manager_H_
+#define _power_manager_H_
+
+#include "engine/engine_instance.h"
+#include "sensesp/system/configurable.h"
+#include "system/config_store.h"
+
+namespace sensesp {
+
+/// What the engines are doing, from the board's point of view
+enum class PowerState : uint8_t {
+  running = 0,  // at least one engine runs
+  idle = 1,     // all stopped, but not for long
+  parked = 2,   // all stopped for longer than parked_after
+  count
+};
+
+/**
+ * @brief Sample rates and sleep by engine state
+ *
+ * Once a second the engines' hour meters (ActivityTimer::isActive(), which
+ * follows the RPM input) decide the state. Every state has its own
+ * time between INA226 readings, the only setting of the INA226value read
+ * delay; when parked the INA226 runs in triggered mode, converting once per
+ * reading and powered down in between.
+ *
+ * Sleep is off by default. When parked and sleep is enabled, WiFi is switched
+ * off (the store and forward buffer keeps the data) and the loop spends its
+ * idle time in ESP32 light sleep, sleep_ms at a time. OTA updates and the web
+ * UI are then out of reach until an engine starts, so a board that is
+ * updated while docked should keep it off. A level change on any RPM input
+ * or on the CAN RX pin wakes it at once. The RPM interrupts are masked while
+ * asleep, so the pulse that woke the board is counted by hand, and the next
+ * evaluation switches to running. The CAN frame that wakes the board is
+ * lost, the controller is not clocked during sleep.
+ */
+class PowerManager : public Configurable {
+ public:
+  PowerManager(uint8_t can_rx_pin, String config_path = "");
+
+  /// Start evaluating the engine state; needs the engines built
+  void start();
+
+  PowerState get_state() const { return state; }
+
+  virtual void load_configuration() override { ConfigStore::load(this); }
+  virtual void save_configuration() override { ConfigStore::save(this); }
+  virtual void get_configuration(JsonObject& root) override;
+  virtual bool set_configuration(const JsonObject& config) override;
+  virtual String get_config_schema() override;
+
+ private:
+  uint8_t can_rx_pin;
+  PowerState state = PowerState::running;
+  unsigned long stopped_since = 0;
+
+  uint32_t ina226_delay[(size_t)PowerState::count] = {1000, 5000, 60000};
+  uint32_t parked_after_ms = 30 * 60 * 1000;
+  bool sleep_enabled = false;
+  uint32_t sleep_ms = 100;
+
+  void evaluate();
+  void apply(PowerState new_state);
+  void light_sleep();
+};
+
+}  // namespace sensesp
+
+#endif
@@ -0,0 +1,202 @@
+#include "engine/sk_store_forward.h"
+
+#include <SPIFFS.h>
+#include <time.h>
+
+#include "sensesp_app.h"
+#include "system/phase_scheduler.h"
+
+// anything before this and the clock hasn't been set
+#define CLOCK_VALID_EPOCH 1600000000UL
+
+namespace sensesp {
+
+static const char* const SPILL_FILES[] = {"/skfwd0.bin", "/skfwd1.bin"};
+
+static bool clock_valid() { return time(nullptr) > (time_t)CLOCK_VALID_EPOCH; }
+
+// The spill files on SPIFFS, opened and closed for every access
+class SPIFFSSpill : public SpillStorage {
+ public:
+  virtual bool exists(uint8_t file) override {
+    return SPIFFS.exists(SPILL_FILES[file]);
+  }
+
+  virtual uint32_t size(uint8_t file) override {
+    if (!exists(file)) {
+      return 0;
+    }
+    File f = SPIFFS.open(SPILL_FILES[file], FILE_READ);
+    uint32_t bytes = f.size();
+    f.close();
+    return bytes;
+  }
+
+  virtual bool append(uint8_t file, const uint8_t* data,
+                      size_t bytes) override {
+    File f = SPIFFS.open(SPILL_FILES[file], FILE_APPEND);
+    if (!f) {
+      debugE("Store and forward: can't open %s", SPILL_FILES[file]);
+      return false;
+    }
+    size_t written = f.write(data, bytes);
+    f.close();
+    return written == bytes;
+  }
+
+  virtual size_t read(uint8_t file, uint32_t offset, uint8_t* data,
+                      size_t bytes) override {
+    File f = SPIFFS.open(SPILL_FILES[file], FILE_READ);
+    f.seek(offset);
+    size_t read = f.read(data, bytes);
+    f.close();
+    return read;
+  }
+
+  virtual void remove(uint8_t file) override {
+    SPIFFS.remove(SPILL_FILES[file]);
+  }
+};
+
+static SPIFFSSpill spiffs_spill;
+
+SKStoreForward::SKStoreForward(String config_path)
+    : Configurable(config_path), queue(spiffs_spill) {
+  // tells values from this boot apart from those of earlier ones
+  boot_id = (esp_random() % 0xFFFF) + 1;
+  load_configuration();
+}
+
+void SKStoreForward::start() {
+  // replayed values need real timestamps; SNTP keeps the pointer
+  configTime(0, 0, ntp_server.c_str());
+  queue.resume();
+  PhaseScheduler::add("SK spill", STORE_FORWARD_SPILL_MS, [this]() {
+    if (queue.spill_due()) {
+      queue.spill();
+    }
+  });
+  PhaseScheduler::add("SK replay", STORE_FORWARD_REPLAY_MS,
+                      [this]() { this->replay(); });
+}
+
+bool SKStoreForward::connected() const {
+  SKWSClient* ws_client = sensesp_app->get_ws_client();
+  return ws_client != nullptr && ws_client->is_connected();
+}
+
+void SKStoreForward::record(uint8_t engine, Channel channel, float value) {
+  uint32_t now = millis();
+  uint32_t& last = last_record[engine][(size_t)channel];
+  if (last != 0 && now - last < record_interval_ms) {
+    return;
+  }
+  if (connected()) {
+    last = 0;
+    return;
+  }
+  last = now;
+  StoredValue* stored = queue.push();
+  if (stored == nullptr) {
+    // the spill task hasn't caught up
+    return;
+  }
+  if (clock_valid()) {
+    stored->stamp = time(nullptr);
+    stored->boot_id = 0;
+  } else {
+    stored->stamp = now;
+    stored->boot_id = boot_id;
+  }
+  stored->engine = engine;
+  stored->channel = (uint8_t)channel;
+  stored->value = value;
+  recorded++;
+}
+
+void SKStoreForward::replay() {
+  if (!connected() || !clock_valid()) {
+    return;
+  }
+  StoredValue batch[STORE_FORWARD_BATCH];
+  size_t count = queue.next_batch(batch);
+  if (count == 0) {
+    return;
+  }
+
+  uint32_t now = time(nullptr);
+  uint32_t now_ms = millis();
+  char timestamp[24];
+  char path[64];
+  delta.clear();
+  for (size_t i = 0; i < count; i++) {
+    const StoredValue& stored = batch[i];
+    EngineInstance* engine = EngineInstance::get(stored.engine);
+    if (engine == nullptr || stored.channel >= CHANNEL_COUNT) {
+      continue;
+    }
+    uint32_t seconds;
+    if (!stored_time(stored, boot_id, now, now_ms, seconds)) {
+      dropped_undated++;
+      continue;
+    }
+    time_t stamp = seconds;
+    struct tm utc;
+    gmtime_r(&stamp, &utc);
+    strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", &utc);
+    snprintf(path, sizeof(path), CHANNELS[stored.channel].sk_path,
+             engine->config.name);
+    if (delta.add(timestamp, path, stored.value)) {
+      replayed++;
+    }
+  }
+  delta.end();
+  if (delta.count() > 0) {
+    // SKWSClient only takes a String: one copy, of the finished delta
+    String text(delta.data());
+    sensesp_app->get_ws_client()->sendTXT(text);
+  }
+}
+
+void SKStoreForward::get_configuration(JsonObject& root) {
+  root["record_interval"] = record_interval_ms;
+  root["max_bytes"] = queue.max_bytes;
+  root["ntp_server"] = ntp_server;
+  root["recorded"] = recorded;
+  root["replayed"] = replayed;
+  root["dropped_full"] = queue.dropped_full;
+  root["dropped_undated"] = dropped_undated;
+}
+
+static const char SCHEMA[] PROGMEM = R"###({
+    "type": "object",
+    "properties": {
+        "record_interval": { "title": "Record interval", "type": "integer", "description": "Minimum time between stored values of one channel, in milliseconds" },
+        "max_bytes": { "title": "Flash budget", "type": "integer", "description": "SPIFFS space for stored values, in bytes; 12 bytes per value" },
+        "ntp_server": { "title": "Time server", "type": "string", "description": "NTP server for the timestamps of replayed values, e.g. the Signal K server's host; applied after a restart" },
+        "recorded": { "title": "Values recorded", "type": "integer", "readOnly": true },
+        "replayed": { "title": "Values replayed", "type": "integer", "readOnly": true },
+        "dropped_full": { "title": "Dropped, store full", "type": "integer", "readOnly": true },
+        "dropped_undated": { "title": "Dropped, no timestamp", "type": "integer", "readOnly": true }
+    }
+  })###";
+
+String SKStoreForward::get_config_schema() { return FPSTR(SCHEMA); }
+
+bool SKStoreForward::set_configuration(const JsonObject& config) {
+  String expected[] = {"record_interval", "max_bytes"};
+  for (auto str : expected) {
+    if (!config.containsKey(str)) {
+      return false;
+    }
+  }
+  record_interval_ms = config["record_interval"];
+  queue.max_bytes = config["max_bytes"];
+  // added later, older configurations don't have it
+  if (config.containsKey("ntp_server")) {
+    ntp_server = config["ntp_server"].as<String>();
+  }
+  return true;
+}
+
+}  // namespace sensesp
@@ -0,0 +1,72 @@
+#ifndef _sk_store_forward_H_
+#define _sk_store_forward_H_
+
+#include "engine/channel_manifest.h"
+#include "engine/engine_instance.h"
+#include "engine/store_forward_queue.h"
+#include "sensesp/system/configurable.h"
+#include "system/config_store.h"
+
+// how often the RAM ring is checked, and spilled once half full
+#define STORE_FORWARD_SPILL_MS 1000
+// time between replayed deltas
+#define STORE_FORWARD_REPLAY_MS 250
+
+namespace sensesp {
+
+/**
+ * @brief Keep channel values while the Signal K server is unreachable
+ *
+ * While the websocket is down, every channel of every engine is recorded at
+ * most once per record_interval into a RAM ring. Recording never touches
+ * flash: a task of its own appends the ring to one of two spill files on
+ * SPIFFS once it is half full. When the active file reaches half of
+ * max_bytes, writing switches to the other one and whatever it held, the
+ * oldest data, is dropped and counted.
+ *
+ * Once connected again, the stored values are replayed oldest first, spill
+ * files before RAM, STORE_FORWARD_BATCH values per delta every
+ * STORE_FORWARD_REPLAY_MS, so the live stream keeps most of the link. Each
+ * value carries its original timestamp. Values recorded before the clock was
+ * set are dated from millis() if the board hasn't rebooted since; otherwise
+ * they can't be dated and are dropped. The clock is set by SNTP from
+ * ntp_server, which may as well be the Signal K server's host.
+ *
+ * The ring, the spill files and the replay order are StoreForwardQueue's.
+ */
+class SKStoreForward : public Configurable {
+ public:
+  SKStoreForward(String config_path = "");
+
+  /// Start replaying; needs the SensESP app
+  void start();
+
+  /// A channel value, recorded only while disconnected
+  void record(uint8_t engine, Channel channel, float value);
+
+  virtual void load_configuration() override { ConfigStore::load(this); }
+  virtual void save_configuration() override { ConfigStore::save(this); }
+  virtual void get_configuration(JsonObject& root) override;
+  virtual bool set_configuration(const JsonObject& config) override;
+  virtual String get_config_schema() override;
+
+ private:
+  uint32_t record_interval_ms = 30000;
+  String ntp_server = "pool.ntp.org";
+  uint16_t boot_id;
+
+  StoreForwardQueue queue;
+  ReplayDelta<STORE_FORWARD_DELTA_SIZE> delta;
+  uint32_t last_record[MAX_ENGINES][CHANNEL_COUNT] = {};
+
+  uint32_t recorded = 0;
+  uint32_t replayed = 0;
+  uint32_t dropped_undated = 0;
+
+  bool connected() const;
+  void replay();
+};
+
+}  // namespace sensesp
+
+#endif
@@ -0,0 +1,222 @@
+#ifndef _store_forward_queue_H_
+#define _store_forward_queue_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// values held in RAM before they are spilled to flash
+#define STORE_FORWARD_RING 128
+// values per replayed delta
+#define STORE_FORWARD_BATCH 20
+// one replayed value takes at most 150 bytes with a 63 character path
+#define STORE_FORWARD_DELTA_SIZE (STORE_FORWARD_BATCH * 160 + 16)
+
+namespace sensesp {
+
+/// One value recorded while the Signal K server was unreachable, 12 bytes
+struct StoredValue {
+  uint32_t stamp;   // epoch seconds, or millis() when boot_id != 0
+  uint16_t boot_id; // 0 when the clock was set at recording time
+  uint8_t engine;   // EngineInstance index
+  uint8_t channel;  // Channel
+  float value;
+};
+
+/// The epoch time of a stored value, false if it can't be dated: recorded
+/// before the clock was set, during an earlier boot
+inline bool stored_time(const StoredValue& stored, uint16_t boot_id,
+                        uint32_t now, uint32_t now_ms, uint32_t& stamp) {
+  if (stored.boot_id == 0) {
+    stamp = stored.stamp;
+  } else if (stored.boot_id == boot_id) {
+    stamp = now - (now_ms - stored.stamp) / 1000;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+/// The two spill files, on SPIFFS on the board
+class SpillStorage {
+ public:
+  virtual ~SpillStorage() {}
+  virtual bool exists(uint8_t file) = 0;
+  /// 0 if it doesn't exist
+  virtual uint32_t size(uint8_t file) = 0;
+  /// Create the file if needed; false if not all bytes were written
+  virtual bool append(uint8_t file, const uint8_t* data, size_t bytes) = 0;
+  virtual size_t read(uint8_t file, uint32_t offset, uint8_t* data,
+                      size_t bytes) = 0;
+  virtual void remove(uint8_t file) = 0;
+};
+
+/**
+ * @brief The values SKStoreForward holds, and the order they are replayed in
+ *
+ * New values go into a RAM ring. Once it is half full, spill() appends it to
+ * one of two spill files. When the active file reaches half of max_bytes,
+ * writing switches to the other one and whatever it held, the oldest data,
+ * is dropped and counted. next_batch() hands out STORE_FORWARD_BATCH values
+ * at a time, oldest first: the older spill file, the newer one, then RAM.
+ *
+ * No Arduino dependency, so it can be tested on a host.
+ */
+class StoreForwardQueue {
+ public:
+  explicit StoreForwardQueue(SpillStorage& storage) : storage(storage) {}
+
+  uint32_t max_bytes = 96 * 1024;
+  uint32_t dropped_full = 0;
+
+  /// Resume appending to the file a previous boot was filling: the only one
+  /// left, or the smaller one, the older one having been filled up
+  void resume() {
+    bool exists0 = storage.exists(0);
+    bool exists1 = storage.exists(1);
+    if (exists0 && exists1) {
+      write_file = storage.size(1) < storage.size(0) ? 1 : 0;
+    } else {
+      write_file = exists1 ? 1 : 0;
+    }
+  }
+
+  /// Room for one more value in RAM; nullptr, and counted, when the ring is
+  /// full because the spill hasn't caught up
+  StoredValue* push() {
+    if (ring_count == STORE_FORWARD_RING) {
+      dropped_full++;
+      return nullptr;
+    }
+    return &ring[ring_count++];
+  }
+
+  /// Whether the ring should be spilled
+  bool spill_due() const {
+    return ring_count - ring_replayed >= STORE_FORWARD_RING / 2;
+  }
+
+  /// Append the ring to the active spill file; false, with the values
+  /// dropped, if the file can't be written
+  bool spill() {
+    if (storage.size(write_file) + sizeof(ring) > max_bytes / 2) {
+      // the active file is full: switch over, dropping the older data
+      write_file ^= 1;
+      if (storage.exists(write_file)) {
+        // the replay was reading this one
+        dropped_full +=
+            (storage.size(write_file) - read_offset) / sizeof(StoredValue);
+        storage.remove(write_file);
+        read_offset = 0;
+      }
+    }
+    // what the replay already sent from RAM isn't spilled again
+    size_t count = ring_count - ring_replayed;
+    bool written =
+        storage.append(write_file, (const uint8_t*)&ring[ring_replayed],
+                       count * sizeof(StoredValue));
+    if (!written) {
+      dropped_full += count;
+    }
+    ring_count = 0;
+    ring_replayed = 0;
+    return written;
+  }
+
+  /// The next values in replay order, at most STORE_FORWARD_BATCH
+  size_t next_batch(StoredValue* batch) {
+    for (uint8_t i = 1; i <= 2; i++) {
+      uint8_t file = write_file ^ (i & 1);
+      if (!storage.exists(file)) {
+        continue;
+      }
+      size_t bytes = storage.read(file, read_offset, (uint8_t*)batch,
+                                  STORE_FORWARD_BATCH * sizeof(StoredValue));
+      read_offset += bytes;
+      if (read_offset >= storage.size(file)) {
+        storage.remove(file);
+        read_offset = 0;
+      }
+      size_t count = bytes / sizeof(StoredValue);
+      if (count > 0) {
+        return count;
+      }
+    }
+
+    size_t count = ring_count - ring_replayed;
+    if (count > STORE_FORWARD_BATCH) {
+      count = STORE_FORWARD_BATCH;
+    }
+    memcpy(batch, &ring[ring_replayed], count * sizeof(StoredValue));
+    ring_replayed += count;
+    if (ring_replayed == ring_count) {
+      ring_count = ring_replayed = 0;
+    }
+    return count;
+  }
+
+ private:
+  SpillStorage& storage;
+  StoredValue ring[STORE_FORWARD_RING];
+  size_t ring_count = 0;
+  size_t ring_replayed = 0;
+  uint8_t write_file = 0;    // spill file being appended to, 0 or 1
+  uint32_t read_offset = 0;  // replay position in the older spill file
+};
+
+/**
+ * @brief One replayed Signal K delta in a fixed buffer
+ *
+ * Every value is an update of its own, with its original timestamp. The
+ * closing bytes are held back, so a value that is refused leaves a delta
+ * that can still be closed.
+ */
+template <size_t N>
+class ReplayDelta {
+ public:
+  ReplayDelta() { clear(); }
+
+  void clear() {
+    length = 0;
+    values = 0;
+    buffer[0] = '\0';
+  }
+
+  const char* data() const { return buffer; }
+  size_t size() const { return length; }
+  size_t count() const { return values; }
+
+  /// false, leaving the delta as it was, if the value won't fit along with
+  /// the closing bytes
+  bool add(const char* timestamp, const char* path, float value) {
+    int n = snprintf(
+        buffer + length, N - length,
+        "%s{\"timestamp\":\"%s\",\"values\":[{\"path\":\"%s\",\"value\":%g}]}",
+        values == 0 ? "{\"updates\":[" : ",", timestamp, path, value);
+    if (n < 0 || length + n + 2 >= N) {
+      buffer[length] = '\0';
+      return false;
+    }
+    length += n;
+    values++;
+    return true;
+  }
+
+  /// Close the delta, if a value was added; the room for it is reserved
+  void end() {
+    if (values > 0) {
+      memcpy(buffer + length, "]}", 3);
+      length += 2;
+    }
+  }
+
+ private:
+  char buffer[N];
+  size_t length;
+  size_t values;
+};
+
+}  // namespace sensesp
+
+#endif
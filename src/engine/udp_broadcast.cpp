@@ -0,0 +1,204 @@
+#include "engine/udp_broadcast.h"
+
+#include <WiFi.h>
+
+#include "system/latency_trace.h"
+#include "system/phase_scheduler.h"
+
+namespace sensesp {
+
+UDPBroadcast::UDPBroadcast(UDPFormat format, uint16_t port, uint32_t period_ms,
+                           String config_path)
+    : Configurable(config_path),
+      format{format},
+      port{port},
+      period_ms{period_ms} {
+  load_configuration();
+}
+
+void UDPBroadcast::start() {
+  if (period_ms > 0) {
+    PhaseScheduler::add("UDP", period_ms, [this]() { this->flush(); });
+  }
+}
+
+void UDPBroadcast::publish(uint8_t engine, Channel channel, float value) {
+  if (!enabled || engine >= MAX_ENGINES) {
+    return;
+  }
+  values[engine][(size_t)channel] = value;
+  fresh[engine] |= 1UL << (size_t)channel;
+#ifdef LATENCY_TRACE
+  acquired[engine][(size_t)channel] = LatencyTrace::current();
+#endif
+  if (period_ms == 0) {
+    flush();
+  }
+}
+
+void UDPBroadcast::flush() {
+  if (!WiFi.isConnected()) {
+    return;
+  }
+  packet.clear();
+  memset(sent, 0, sizeof(sent));
+  if (format == UDPFormat::nmea0183) {
+    format_nmea0183();
+  } else {
+    format_signalk();
+  }
+  // what didn't fit stays fresh for the next datagram
+  for (size_t e = 0; e < MAX_ENGINES; e++) {
+    fresh[e] &= ~sent[e];
+  }
+  if (packet.size() == 0) {
+    return;
+  }
+  udp.beginPacket(WiFi.broadcastIP(), port);
+  udp.write((const uint8_t*)packet.data(), packet.size());
+  udp.endPacket();
+  packets++;
+#ifdef LATENCY_TRACE
+  for (size_t e = 0; e < MAX_ENGINES; e++) {
+    for (size_t c = 0; c < CHANNEL_COUNT; c++) {
+      if (sent[e] & (1UL << c)) {
+        LatencyTrace::record(LatencySink::udp, acquired[e][c]);
+      }
+    }
+  }
+#endif
+}
+
+// All fresh values, starting where the last delta ran out of room, so no
+// channel is left behind for good when they don't all fit
+void UDPBroadcast::format_signalk() {
+  const size_t total = MAX_ENGINES * CHANNEL_COUNT;
+  for (size_t i = 0; i < total; i++) {
+    size_t index = (next_value + i) % total;
+    size_t e = index / CHANNEL_COUNT;
+    size_t c = index % CHANNEL_COUNT;
+    if (!(fresh[e] & (1UL << c))) {
+      continue;
+    }
+    EngineInstance* engine = EngineInstance::get(e);
+    if (engine == nullptr) {
+      continue;
+    }
+    char path[64];
+    snprintf(path, sizeof(path), CHANNELS[c].sk_path, engine->config.name);
+    if (!packet.add_value(path, values[e][c])) {
+      next_value = index;
+      deferred++;
+      break;
+    }
+    sent[e] |= 1UL << c;
+  }
+  packet.end_delta();
+}
+
+void UDPBroadcast::format_nmea0183() {
+  // transducer type, unit and name of the channels that go into $IIXDR
+  struct XDRField {
+    Channel channel;
+    char type;
+    char unit;
+    const char* name;
+  };
+  static const XDRField XDR_FIELDS[] = {
+      {Channel::coolant_temperature, 'C', 'C', "ENGINE"},
+      {Channel::oil_temperature, 'C', 'C', "OIL"},
+      {Channel::exhaust_temperature, 'C', 'C', "EXHAUST"},
+      {Channel::alternator_temperature, 'C', 'C', "ALTERNATOR"},
+      {Channel::alternator_voltage, 'U', 'V', "ALTERNATOR"},
+      {Channel::alternator_current, 'I', 'A', "ALTERNATOR"},
+  };
+
+  for (size_t e = 0; e < MAX_ENGINES; e++) {
+    EngineInstance* engine = EngineInstance::get(e);
+    if (engine == nullptr || fresh[e] == 0) {
+      continue;
+    }
+    uint8_t number = engine->config.n2k_instance;
+
+    const uint32_t revs = 1UL << (size_t)Channel::engine_revs;
+    if (fresh[e] & revs) {
+      if (packet.begin_sentence("$ERRPM") &&
+          packet.append(",E,%u,%.1f,,A", number,
+                        values[e][(size_t)Channel::engine_revs] * 60.0f)) {
+        packet.end_sentence();
+        sent[e] |= revs;
+      } else {
+        packet.drop_sentence();
+        deferred++;
+        return;
+      }
+    }
+
+    uint32_t fields = 0;
+    if (!packet.begin_sentence("$IIXDR")) {
+      packet.drop_sentence();
+      return;
+    }
+    for (const XDRField& field : XDR_FIELDS) {
+      const uint32_t bit = 1UL << (size_t)field.channel;
+      if (!(fresh[e] & bit)) {
+        continue;
+      }
+      float value = values[e][(size_t)field.channel];
+      if (field.type == 'C') {
+        value -= 273.15f;
+      }
+      if (!packet.append(",%c,%.2f,%c,%s#%u", field.type, value, field.unit,
+                         field.name, number)) {
+        deferred++;
+        break;
+      }
+      fields |= bit;
+    }
+    if (fields != 0) {
+      packet.end_sentence();
+      sent[e] |= fields;
+    } else {
+      packet.drop_sentence();
+    }
+  }
+}
+
+void UDPBroadcast::get_configuration(JsonObject& root) {
+  root["enabled"] = enabled;
+  root["format"] = (int)format;
+  root["port"] = port;
+  root["period"] = period_ms;
+  root["packets"] = packets;
+  root["deferred"] = deferred;
+}
+
+static const char SCHEMA[] PROGMEM = R"###({
+    "type": "object",
+    "properties": {
+        "enabled": { "title": "Enabled", "type": "boolean" },
+        "format": { "title": "Format", "type": "integer", "description": "0 = Signal K delta, 1 = NMEA 0183 RPM and XDR sentences" },
+        "port": { "title": "UDP port", "type": "integer" },
+        "period": { "title": "Period", "type": "integer", "description": "Time between datagrams in milliseconds, 0 = one per value (applied after a restart)" },
+        "packets": { "title": "Datagrams sent", "type": "integer", "readOnly": true },
+        "deferred": { "title": "Datagrams that were full", "type": "integer", "description": "The values that didn't fit went with the next one", "readOnly": true }
+    }
+  })###";
+
+String UDPBroadcast::get_config_schema() { return FPSTR(SCHEMA); }
+
+bool UDPBroadcast::set_configuration(const JsonObject& config) {
+  String expected[] = {"enabled", "format", "port", "period"};
+  for (auto str : expected) {
+    if (!config.containsKey(str)) {
+      return false;
+    }
+  }
+  enabled = config["enabled"];
+  format = (UDPFormat)(int)config["format"];
+  port = config["port"];
+  period_ms = config["period"];
+  return true;
+}
+
+}  // namespace sensesp
@@ -0,0 +1,86 @@
+#ifndef _udp_broadcast_H_
+#define _udp_broadcast_H_
+
+#include <WiFiUdp.h>
+
+#include "engine/channel_manifest.h"
+#include "engine/engine_instance.h"
+#include "engine/udp_packet.h"
+#include "sensesp/system/configurable.h"
+#include "system/config_store.h"
+
+// one UDP datagram, fits a single WiFi frame
+#define UDP_PACKET_SIZE 1400
+
+namespace sensesp {
+
+/// What goes into the datagrams
+enum class UDPFormat : uint8_t {
+  signalk = 0,   // a Signal K delta with the channels updated since the last one
+  nmea0183 = 1   // $ERRPM and $IIXDR sentences per engine
+};
+
+/**
+ * @brief Broadcast engine data over UDP, without a server or a connection
+ *
+ * Fed from the same per-channel consumer as the display and N2K (see
+ * EngineInstance::update()). publish() only stores the value and marks it
+ * fresh; every period_ms the fresh values are formatted into one fixed
+ * buffer and broadcast on the local subnet, so there is no allocation and no
+ * handshake on the way. A period of 0 sends every value as it arrives, for
+ * the lowest latency. Values that don't fit into the datagram stay fresh and
+ * lead the next one.
+ *
+ * In the NMEA 0183 format temperatures are in degrees Celsius and the
+ * engine number is the N2K engine instance:
+ *
+ *   $ERRPM,E,0,1850.0,,A*hh
+ *   $IIXDR,C,82.5,C,ENGINE#0,C,71.0,C,OIL#0,...,U,14.10,V,ALTERNATOR#0*hh
+ */
+class UDPBroadcast : public Configurable {
+ public:
+  UDPBroadcast(UDPFormat format = UDPFormat::signalk, uint16_t port = 10110,
+               uint32_t period_ms = 100, String config_path = "");
+
+  /// Start broadcasting; needs the network
+  void start();
+
+  /// A channel value, sent with the next datagram
+  void publish(uint8_t engine, Channel channel, float value);
+
+  virtual void load_configuration() override { ConfigStore::load(this); }
+  virtual void save_configuration() override { ConfigStore::save(this); }
+  virtual void get_configuration(JsonObject& root) override;
+  virtual bool set_configuration(const JsonObject& config) override;
+  virtual String get_config_schema() override;
+
+ private:
+  UDPFormat format;
+  uint16_t port;
+  uint32_t period_ms;
+  bool enabled = true;
+
+  static_assert(CHANNEL_COUNT <= 32, "fresh has one bit per channel");
+  float values[MAX_ENGINES][CHANNEL_COUNT] = {};
+  uint32_t fresh[MAX_ENGINES] = {};
+  // what went into the datagram being formatted
+  uint32_t sent[MAX_ENGINES] = {};
+  // where the next Signal K delta starts: engine * CHANNEL_COUNT + channel
+  size_t next_value = 0;
+#ifdef LATENCY_TRACE
+  uint32_t acquired[MAX_ENGINES][CHANNEL_COUNT] = {};
+#endif
+
+  WiFiUDP udp;
+  UDPPacket<UDP_PACKET_SIZE> packet;
+  uint32_t packets = 0;
+  uint32_t deferred = 0;
+
+  void flush();
+  void format_signalk();
+  void format_nmea0183();
+};
+
+}  // namespace sensesp
+
+#endif
@@ -0,0 +1,112 @@
+#ifndef _udp_packet_H_
+#define _udp_packet_H_
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+namespace sensesp {
+
+// what closes a Signal K delta, and an NMEA 0183 sentence: "*hh\r\n"
+#define UDP_DELTA_CLOSE "]}]}"
+#define UDP_SENTENCE_CLOSE_BYTES 5
+
+/**
+ * @brief One datagram of Signal K delta or NMEA 0183 text in a fixed buffer
+ *
+ * While a delta or a sentence is open, the bytes that close it are held
+ * back, so a value or field that is refused leaves a packet that can still
+ * be closed. Whatever was accepted goes out; what was refused can go into
+ * the next datagram.
+ *
+ * No Arduino dependency, so it can be tested on a host.
+ */
+template <size_t N>
+class UDPPacket {
+ public:
+  UDPPacket() { clear(); }
+
+  void clear() {
+    length = 0;
+    reserved = 0;
+    values = 0;
+    buffer[0] = '\0';
+  }
+
+  const char* data() const { return buffer; }
+  size_t size() const { return length; }
+
+  /// Append to the packet; false, leaving the packet as it was, if it won't
+  /// fit along with the closing bytes
+  bool append(const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(buffer + length, N - length, fmt, args);
+    va_end(args);
+    if (n < 0 || length + n + reserved >= N) {
+      buffer[length] = '\0';
+      return false;
+    }
+    length += n;
+    return true;
+  }
+
+  /// One value of a Signal K delta, opening the delta with the first
+  bool add_value(const char* path, float value) {
+    reserved = sizeof(UDP_DELTA_CLOSE) - 1;
+    if (!append("%s{\"path\":\"%s\",\"value\":%g}",
+                values == 0 ? "{\"updates\":[{\"values\":[" : ",", path,
+                value)) {
+      return false;
+    }
+    values++;
+    return true;
+  }
+
+  /// Close the delta, if one was opened; the room for it is reserved
+  void end_delta() {
+    if (values > 0) {
+      reserved = 0;
+      append(UDP_DELTA_CLOSE);
+    }
+  }
+
+  /// Start an NMEA 0183 sentence, e.g. "$IIXDR"; the fields follow with
+  /// append()
+  bool begin_sentence(const char* header) {
+    sentence = length;
+    reserved = UDP_SENTENCE_CLOSE_BYTES;
+    return append("%s", header);
+  }
+
+  /// Checksum and line end of the open sentence; the room for them is
+  /// reserved
+  void end_sentence() {
+    uint8_t checksum = 0;
+    for (size_t i = sentence + 1; i < length; i++) {
+      checksum ^= buffer[i];
+    }
+    reserved = 0;
+    append("*%02X\r\n", checksum);
+  }
+
+  /// Take the open sentence out again
+  void drop_sentence() {
+    length = sentence;
+    reserved = 0;
+    buffer[length] = '\0';
+  }
+
+ private:
+  char buffer[N];
+  size_t length;
+  size_t reserved;  // closing bytes held back
+  size_t values;    // in the open delta
+  size_t sentence = 0;
+};
+
+}  // namespace sensesp
+
+#endif
@@ -14,14 +14,28 @@
 #include "sensesp/signalk/signalk_output.h"
 #include "sensesp/sensors/sensor.h"
 #include "sensesp/sensors/digital_input.h"
-#include "sensesp/transforms/frequency.h"
-#include "sensesp/transforms/linear.h"
 #include "sensesp/transforms/transform.h"
 
 #include "sensori/activity_timer.h"
 #include "sensori/difference.h"
 #include "sensori/ina226value.h"
+#include "engine/burst_recorder.h"
+#include "engine/channel_manifest.h"
+#include "engine/engine_instance.h"
+#include "engine/power_manager.h"
+#include "engine/sk_store_forward.h"
+#include "engine/udp_broadcast.h"
 #include "sensori/INA226.h"
+#include "system/alloc_watch.h"
+#include "system/boot_arena.h"
+#include "system/boot_profiler.h"
+#include "system/config_store.h"
+#include "system/latency_trace.h"
+#include "system/n2k_rx.h"
+#include "system/n2k_tx_queue.h"
+#include "system/oled_pages.h"
+#include "system/phase_scheduler.h"
+#include "system/stress_test.h"
 
 #include "sensesp_minimal_app_builder.h"
 
@@ -53,6 +67,7 @@ using namespace sensesp;
 
 TwoWire *i2c;
 Adafruit_SSD1306 *display;
+OledPages *oled;
 
 tNMEA2000 *nmea2000;
 
@@ -105,63 +120,56 @@ void scan_i2c(TwoWire *i2c) {
 }
 
 
-/// Clear a text row on an Adafruit graphics display
-void ClearRow(int row) { display->fillRect(0, 8 * row, SCREEN_WIDTH, 8, 0); }
-
 float KelvinToCelsius(float temp) { return temp - 273.15; }
 
 float KelvinToFahrenheit(float temp) { return (temp - 273.15) * 9. / 5. + 32.; }
 
-void PrintValue(int row, String title, float value)
+// characters on one text row of the display, 6 pixels each
+#define DISPLAY_ROW_CHARS (SCREEN_WIDTH / 6)
+
+// the hostname line is formatted once, the 500 ms repaint just shows its cached image
+char hostname_line[DISPLAY_ROW_CHARS + 1];
+
+void PrintValue(int row, const char *title, float value, uint8_t field = 0)
 {
-    ClearRow(row);
+    // the row changes in the buffer only, the page goes out on the next flush
     if (show_display) {
-      display->setCursor(0, 8 * row);
-      display->printf("%s: %.1f", title.c_str(), value);
-      }
-    display->display();
+      oled->show(row, title, value, field);
+    } else {
+      oled->clear_row(row);
+    }
+    BootProfiler::reach(BootMilestone::first_display);
 }
 
-void PrintTemperature(int row, String title, float temperature)
+void PrintTemperature(int row, const char *title, float temperature)
 {
     PrintValue(row, title, TEMP_DISPLAY_FUNC(temperature));
 }
 
-double oil_temperature = N2kDoubleNA;
-double coolant_temperature = N2kDoubleNA;
-double alternator_volts = N2kDoubleNA;
-double engine_runtime = N2kDoubleNA;
-const String engine = "main";
-DigitalInputCounter *rpminput;
-
-
-/**
- * @brief Send Engine Dynamic Parameter data
- *
- * Send engine temperature data using the Engine Dynamic Parameter PGN.
- * All unused fields that are sent with undefined value except the status
- * bit fields are sent as zero. Hopefully we're not resetting anybody's engine
- * warnings...
- */
-void SendEngineTemperatures()
+/// Put a channel value on its display row, temperatures in the display units
+void ShowChannel(const ChannelSpec &spec, float value)
 {
-    tN2kMsg N2kMsg;
-    SetN2kEngineDynamicParam(N2kMsg,
-                             0,           // instance of a single engine is always 0
-                             N2kDoubleNA, // oil pressure
-                             oil_temperature, coolant_temperature,
-                             alternator_volts, // alternator voltage
-                             N2kDoubleNA,      // fuel rate
-                             engine_runtime,     // engine hours
-                             N2kDoubleNA,      // engine coolant pressure
-                             N2kDoubleNA,      // engine fuel pressure
-                             N2kInt8NA,        // engine load
-                             N2kInt8NA,        // engine torque
-                             (tN2kEngineDiscreteStatus1)0,
-                             (tN2kEngineDiscreteStatus2)0);
-    nmea2000->SendMsg(N2kMsg);
+    float shown = is_kelvin(spec.units) ? TEMP_DISPLAY_FUNC(value) : value;
+    PrintValue(spec.display_row, spec.display_label, spec.display_scale * shown,
+               spec.display_field);
 }
 
+// The engines monitored by this board. They share the 1-Wire bus, the I2C bus
+// and the N2K node; each needs its own RPM input and INA226 address. For a twin
+// engine boat, e.g.:
+//   {"port", 0, 35, 0x40, 33, true, 0},
+//   {"starboard", 1, 36, 0x41, 25, false, 1},
+const EngineConfig ENGINES[] = {
+    // name, N2K instance, RPM pin, INA226 address, INA226 ALERT pin, on the display,
+    // N2K battery instance
+    {"main", 0, 35, 0x40, 33, true, 0},
+};
+constexpr size_t ENGINE_COUNT = sizeof(ENGINES) / sizeof(ENGINES[0]);
+static_assert(ENGINE_COUNT <= MAX_ENGINES, "more ENGINES than MAX_ENGINES, raise it in engine_instance.h");
+
+EngineBus engine_bus;
+EngineInstance *engines[ENGINE_COUNT];
+
 ReactESP app;
 
 void setup () {
@@ -170,145 +178,67 @@ void setup () {
                  SetupSerialDebug(115200);
 #endif
 
-  
-  SensESPAppBuilder builder;
-  sensesp_app = (&builder)
-                    // Set a custom hostname for the app.
-                    ->set_hostname(engine + " Enginehealth")
-                    ->enable_ota ("mypassword")
-                    // Optionally, hard-code the WiFi and Signal K server
-                    // settings. This is normally not needed.
-                      ->get_app();
+                 // Bring up the NMEA 2000 node before anything that depends on the
+                 // network. It needs neither WiFi nor Signal K, so the helm display
+                 // sees this node, and its engine PGNs, long before WiFi has associated.
+
+                 // initialize the NMEA 2000 subsystem
+                 // instantiate the NMEA2000 object
+                 nmea2000 = BootArena::make<tNMEA2000_esp32>(Subsystem::n2k, CAN_TX_PIN, CAN_RX_PIN);
 
+                 // Our own messages wait in the N2kTxQueue, ordered by priority and
+                 // replaced when a fresher value comes along, so the library's FIFO only
+                 // needs to hold what goes to the CAN controller next. It still has to
+                 // take the longest fast packet message the library sends by itself.
+                 nmea2000->SetN2kCANSendFrameBufSize(40);
+                 nmea2000->SetN2kCANReceiveFrameBufSize(250);
+
+                 // Set Product information
+                 nmea2000->SetProductInformation(
+                     "20210405",             // Manufacturer's Model serial code (max 32 chars)
+                     103,                    // Manufacturer's product code
+                     "SH-ESP32 Temp Sensor", // Manufacturer's Model ID (max 33 chars)
+                     "0.1.0.0 (2021-04-05)", // Manufacturer's Software version code (max 40
+                                             // chars)
+                     "0.0.3.1 (2021-03-07)"  // Manufacturer's Model version (max 24 chars)
+                 );
+                 // Set device information
+                 nmea2000->SetDeviceInformation(
+                     1,   // Unique number. Use e.g. Serial number.
+                     130, // Device function=Analog to NMEA 2000 Gateway. See codes on
+                          // http://www.nmea.org/Assets/20120726%20nmea%202000%20class%20&%20function%20codes%20v%202.00.pdf
+                     75,  // Device class=Inter/Intranetwork Device. See codes on
+                          // http://www.nmea.org/Assets/20120726%20nmea%202000%20class%20&%20function%20codes%20v%202.00.pdf
+                     2046 // Just choosen free from code list on
+                          // http://www.nmea.org/Assets/20121020%20nmea%202000%20registration%20list.pdf
+                 );
+
+                 // listen as well, the transmit queue needs all traffic for its bus load estimate;
+                 // N2kRx opens its receive filter for that now and then
+                 nmea2000->SetMode(tNMEA2000::N2km_ListenAndNode, 22);
+                 // Disable all msg forwarding to USB (=Serial)
+                 nmea2000->EnableForward(false);
+                 nmea2000->Open();
+
+                 // No need to parse the messages at every single loop iteration; 10 ms will do.
+                 // Once the receive filter is up, it times the parsing.
+                 app.onRepeat(10, []() {
+                     if (engine_bus.n2k_rx != nullptr) {
+                         engine_bus.n2k_rx->parse();
+                     } else {
+                         nmea2000->ParseMessages();
+                     }
+                 });
+                 BootProfiler::reach(BootMilestone::n2k_open);
+
+                 // Local I/O next: the I2C bus, the display and the INA226 don't need
+                 // the SensESP app either.
 
-                   DallasTemperatureSensors *dts = new DallasTemperatureSensors(ONEWIRE_PIN);
-
-                 // define three 1-Wire temperature sensors that update every 1000 ms
-                 // and have specific web UI configuration paths
-
-                 auto main_engine_oil_temperature =
-                     new OneWireTemperature(dts, 1000, "/" + engine + "EngineOilTemp/oneWire");
-                 auto main_engine_coolant_temperature =
-                     new OneWireTemperature(dts, 1000, "/" + engine + "EngineCoolantTemp/oneWire");
-                 auto main_engine_exhaust_temperature =
-                     new OneWireTemperature(dts, 1000, "/" + engine + "EngineWetExhaustTemp/oneWire");
-                 auto main_alternator_temperature =
-                     new OneWireTemperature(dts, 1000, "/" + engine + "AlternatorTemp/oneWire");
-
-                 // define metadata for sensors
-
-                 auto main_engine_oil_temperature_metadata =
-                     new SKMetadata("K",                      // units
-                                    engine + " Oil Temperature", // display name
-                                    "Engine Oil Temperature", // description
-                                    "Oil Temp",               // short name
-                                    10.                       // timeout, in seconds
-                     );
-                 auto main_engine_coolant_temperature_metadata =
-                     new SKMetadata("K",                          // units
-                                    engine + " Coolant Temperature", // display name
-                                    "Engine Coolant Temperature", // description
-                                    "Coolant Temp",               // short name
-                                    10.                           // timeout, in seconds
-                     );
-                 auto main_engine_temperature_metadata =
-                     new SKMetadata("K",                  // units
-                                    engine + " Temperature", // display name
-                                    "Engine Temperature", // description
-                                    "Engine Temp",        // short name
-                                    10.                   // timeout, in seconds
-                     );
-                 auto main_engine_exhaust_temperature_metadata =
-                     new SKMetadata("K",                       // units
-                                    engine + " Exhaust Temperature", // display name
-                                    "Wet Exhaust Temperature", // description
-                                    "Exhaust Temp",            // short name
-                                    10.                        // timeout, in seconds
-                     );
-
-                 auto main_alternator_temperature_metadata =
-                     new SKMetadata("K",                      // units
-                                    engine + " Alternator Temperature", // display name
-                                    "Alternator Temperature", // description
-                                    "Alternator Temp",        // short name
-                                    10.                       // timeout, in seconds
-                     );
-
-                 auto main_alternator_voltage_metadata =
-                     new SKMetadata("V",                         // units
-                                    engine + " Alternator Voltage",        // display name
-                                    "Alternator Output Voltage", // description
-                                    "Alternator V",              // short name
-                                    10.                          // timeout, in seconds
-                     );
-
-                auto main_alternator_current_metadata =
-                     new SKMetadata("A",                         // units
-                                    engine + " Alternator Current",        // display name
-                                    "Alternator Output Current", // description
-                                    "Alternator A",              // short name
-                                    10.                          // timeout, in seconds
-                     );
-                    // Propagate /vessels/<RegExp>/propulsion/<RegExp>/runTime
-                    // Units: s (Second)
-                    // Description: Total running time for engine (Engine Hours in seconds)
-                 auto engine_runtime_metadata =
-                     new SKMetadata("s",                       // units
-                                    engine + " Engine Runtime", // display name
-                                    "Total hrs running", // description
-                                    "Engine hrs",            // short name
-                                    10.                        // timeout, in seconds
-                     );
-    
-                    
-                 auto engine_revs_metadata =
-                     new SKMetadata("Hz",                       // units
-                                    engine + " Engine speed",   // display name
-                                    "Engine revs",              // description
-                                    "Speed",                    // short name
-                                    10.                        // timeout, in seconds
-                     );
-
-                 // connect the sensors to Signal K output paths
-                 // Oil temp
-                 main_engine_oil_temperature->connect_to(new SKOutput<float>(
-                     "propulsion." + engine + ".oilTemperature", main_engine_oil_temperature_metadata));
-                 // Coolant temp
-                 main_engine_coolant_temperature->connect_to(new SKOutput<float>(
-                     "propulsion." + engine + ".coolantTemperature", main_engine_coolant_temperature_metadata));
-                 // transmit coolant temperature as overall engine temperature as well
-                 main_engine_coolant_temperature->connect_to(new SKOutput<float>(
-                     "propulsion." + engine + ".temperature", main_engine_temperature_metadata));
-                 // propulsion.*.ExhaustTemperature is a standard path: /vessels/<RegExp>/propulsion/<RegExp>/exhaustTemperature
-                 main_engine_exhaust_temperature->connect_to(
-                     new SKOutput<float>("propulsion." + engine +".exhaustTemperature", main_engine_exhaust_temperature_metadata));
-
-                 // send the alternator temperature /vessels/<RegExp>/electrical/alternators/<RegExp>/temperature
-                 main_alternator_temperature->connect_to(
-                     new SKOutput<float>("electrical." + engine + ".alternators.temperature", main_alternator_temperature_metadata));
-
-
-                 // Add display updaters for temperature values
-                 main_engine_oil_temperature->connect_to(new LambdaConsumer<float>(
-                     [](float temperature)
-                     { PrintTemperature(1, "Oil", temperature); }));
-                 main_engine_coolant_temperature->connect_to(new LambdaConsumer<float>(
-                     [](float temperature)
-                     { PrintTemperature(2, "Coolant", temperature); }));
-                 main_engine_exhaust_temperature->connect_to(new LambdaConsumer<float>(
-                     [](float temperature)
-                     { PrintTemperature(3, "Exhaust", temperature); }));
-                 main_alternator_temperature->connect_to(new LambdaConsumer<float>(
-                     [](float temperature)
-                     { PrintTemperature(4, "Alternator", temperature); }));
-                
-
-                
                  // initialize the display
-                 i2c = new TwoWire(0);
+                 i2c = BootArena::make<TwoWire>(Subsystem::io, 0);
                  i2c->begin(SDA_PIN, SCL_PIN);
              
-                 display = new Adafruit_SSD1306(SCREEN_WIDTH, SCREEN_HEIGHT, i2c, -1);
+                 display = BootArena::make<Adafruit_SSD1306>(Subsystem::io, SCREEN_WIDTH, SCREEN_HEIGHT, i2c, -1);
                  if (!display->begin(SSD1306_SWITCHCAPVCC, 0x3C)) {
                      Serial.println(F("SSD1306 allocation failed"));
                  }
@@ -317,190 +247,136 @@ void setup () {
                  display->clearDisplay();
                  display->setTextSize(1);
                  display->setTextColor(SSD1306_WHITE);
+                 oled = BootArena::make<OledPages>(Subsystem::io, display, i2c);
+                 oled->start();
+
+                 // the resources all engines share, then each engine's own chips
+                 engine_bus.i2c = i2c;
+                 engine_bus.show = ShowChannel;
+                 for (size_t i = 0; i < ENGINE_COUNT; i++) {
+                     engines[i] = BootArena::make<EngineInstance>(Subsystem::sensors, ENGINES[i], engine_bus);
+                     engines[i]->begin_io();
+                 }
+                 BootProfiler::reach(BootMilestone::local_io);
+
+  // Only now build the SensESP app. WiFi, OTA and the Signal K websocket are
+  // started by sensesp_app->start() and connect in the background from then on.
+  SensESPAppBuilder builder;
+  sensesp_app = (&builder)
+                    // Set a custom hostname for the app.
+                    ->set_hostname(expand("%s Enginehealth", ENGINES[0].name))
+                    ->enable_ota ("mypassword")
+                    // Optionally, hard-code the WiFi and Signal K server
+                    // settings. This is normally not needed.
+                      ->get_app();
+                 BootProfiler::reach(BootMilestone::app_built);
+
+                 // the N2K transmit queue has its settings on the web UI, so it comes after the app
+                 engine_bus.n2k_tx = BootArena::make<N2kTxQueue>(Subsystem::n2k, nmea2000, "/System/N2kTxQueue");
+                 // the RX pin still shows the frames the receive filter drops
+                 engine_bus.n2k_tx->watch_rx_pin(CAN_RX_PIN);
+                 engine_bus.n2k_tx->start();
+                 // only the node's own PGNs and the subscribed data get through to the library
+                 engine_bus.n2k_rx = BootArena::make<N2kRx>(Subsystem::n2k, nmea2000, engine_bus.n2k_tx, "/System/N2kRx");
+                 nmea2000->SetMsgHandler([](const tN2kMsg &msg) { engine_bus.n2k_rx->dispatch(msg); });
+                 engine_bus.n2k_rx->start();
+
+                 engine_bus.onewire = BootArena::make<DallasTemperatureSensors>(Subsystem::io, ONEWIRE_PIN);
+
+                 // hold the engine data while the Signal K server is out of reach, replay it later
+                 engine_bus.store_forward = BootArena::make<SKStoreForward>(Subsystem::signalk, "/System/StoreForward");
+                 // and broadcast it on the local network for helm tablets, no server needed
+                 engine_bus.udp = BootArena::make<UDPBroadcast>(Subsystem::signalk, UDPFormat::signalk, 10110, 100U, "/System/UDPBroadcast");
+
+                 // every engine's sensors, transforms and outputs, see EngineInstance::build()
+                 for (size_t i = 0; i < ENGINE_COUNT; i++) {
+                     engines[i]->build();
+                 }
+                 EngineInstance::start_n2k_scheduler();
 
                 // put the hostname on display
-                app.onRepeat (500U,[](){
+                snprintf(hostname_line, sizeof(hostname_line), "%s", sensesp_app->get_hostname().c_str());
+                PhaseScheduler::add("hostname", 500U, [](){
                     if (show_display) {
-                      display->setCursor(0, 0);
-                      display->printf("%s", sensesp_app->get_hostname().c_str());
+                      oled->show(0, hostname_line);
                     }
                 });
 
                 // if the BOOT button is pressed, activate the display for 10 seconds
-                auto *dispButton = new DigitalInputChange (BOOT_BUTTON, PULLDOWN,CHANGE,"");
-                dispButton->connect_to(new LambdaConsumer<bool>([](bool btnstate)
+                auto *dispButton = BootArena::make<DigitalInputChange>(Subsystem::sensors, BOOT_BUTTON, PULLDOWN,CHANGE,"");
+                dispButton->connect_to(BootArena::make<LambdaConsumer<bool>>(Subsystem::consumers, [](bool btnstate)
                                                             {
                                                                 if (!btnstate) {
                                                                     show_display = true;
                                                                     app.onDelay (10U*1000U,[](){
                                                                         show_display = false;
-                                                                        display->clearDisplay();
+                                                                        oled->clear();
                                                                     });
 
                                                                 }
                                                               }));
 
 
-                 // RPM Measurement down here, we expect a RPM proportional signal (the generator
-                 // W output) and connected to the ESP HAT board opto coupler input GPIO 35
-                 // We'll also start the activity timer when RPM's > 0
-                 //
-                 // The crank pulley diameter is 127.86mm
-                 // The alternator pulley diameter is 58mm
-                 // Ration of 2.2044 to 1
-                 // 12 pole alternator, 6 pairs of poles
-                 // Pulses per rev= number of pairs of poles x the pulley ratio.
-                 // 6 x 2.2044 = 13.23 pulse per rev, for reference the standard number of pulses per rev for the original alternator is 10.29
-                 // This convert to frequencies of:
-                 // 220 Hz at 1,000 rpm; 440 HZ at 2,000rpm and 660Hz at 3000 rpm
-                 
-                 const float rpm_multiplier = 60.0 / 13.23;  // in Hz
-                 uint8_t rpm_pin = 35;
-                 // SignalK wants it in Hz, so divide by 60..
-                 auto *dic = new DigitalInputCounter(rpm_pin, INPUT_PULLUP, RISING, 200U);  // fast changing parameter
-                 dic
-                     ->connect_to(new Frequency(rpm_multiplier/60.0, "/" + engine + "_engine_rpm/calibrate"))
-                     ->connect_to(new SKOutputFloat ("propulsion." + engine + ".revolutions", engine_revs_metadata));
-
-                 // Send the RPM's to the display
-                 dic
-                     ->connect_to(new Frequency(rpm_multiplier))
-                     ->connect_to(new LambdaConsumer<float>([](float rpm)
-                                                            { 
-                                                            PrintValue(6, "RPM", rpm); }));
-
-                 // Send the RPM's to the N2K network
-                 // note N2K expects Engine Speed to be the rotational speed of the engine in units of 1/4 RPM.
-                 dic
-                     ->connect_to(new Frequency(rpm_multiplier))
-                     ->connect_to(new LambdaConsumer<float>([](float rpm)
-                                                            {
-                                                                tN2kMsg N2kMsg;
-                                                                SetN2kEngineParamRapid(N2kMsg,
-                                                                                       1, // SID
-                                                                                       rpm * 4.0);
-
-                                                            }));
-                // Update the hour meter for this engine and add to the startvalue
-                auto *main_engine_timer = new ActivityTimer(1.0,"/" + engine + "_engine_hrs/begin_value");
-
-                dic
-                  ->connect_to (main_engine_timer)
-                  ->connect_to (new LambdaConsumer<float>([](float running_hrs)
-                                                            { 
-                                                              engine_runtime = running_hrs;
-                                                              PrintValue(7, "Hours", engine_runtime);
-                                                            }));
-
-                main_engine_timer
-                      ->connect_to (new Linear (3600.0,0.0,""))
-                      ->connect_to (new SKOutputFloat("propulsion." + engine + ".runTime", engine_runtime_metadata));                 
-                
-                // start the INA266 current & voltage measurements for the alternator
-
-                auto *alternatorINA = new INA226 (i2c);
-                alternatorINA->begin(0x40);  // uses the default address of 0x40
- 
-                // configure with defaults
-    
-                alternatorINA->configure(INA226_AVERAGES_1, INA226_BUS_CONV_TIME_1100US, INA226_SHUNT_CONV_TIME_1100US, INA226_MODE_SHUNT_BUS_CONT);  // uses the default values
-                alternatorINA->calibrate(0.01, 4);  // uses the default values
-                // Now the INA226 is ready for reading, which will be done by the INA226value class.
-                auto altVmeter = new INA226value (alternatorINA,bus_voltage,1000U,"/" + engine + "_Alternator/Electrics/Voltage");
-                debugD ("we have a voltmeter");
-
-   
-                altVmeter->connect_to (new SKOutputFloat("electrical.alternators." + engine + ".voltage", main_alternator_voltage_metadata));
-
-                altVmeter->connect_to (new LambdaConsumer<float>([](float altV)
-                                                           {   debugD ("Alternator volts: %f V",altV);
-                                                               PrintValue (2,"AltV",altV); }));
-                auto altAmmeter = new INA226value (alternatorINA,current,1000U,"/" + engine + "_Alternator/Electrics/Current");
-                debugD ("we have an Ammeter");
+                BootProfiler::reach(BootMilestone::graph_built);
 
-   
-                altAmmeter->connect_to (new SKOutputFloat("electrical.alternators." + engine + ".current", main_alternator_current_metadata));
-
-                altAmmeter->connect_to (new LambdaConsumer<float>([](float altA)
-                                                           {   debugD ("Alternator amps: %f A",altA);
-                                                               PrintValue (3,"AltA",altA); }));
-
- 
-                 // initialize the NMEA 2000 subsystem
-                 // instantiate the NMEA2000 object
-                 nmea2000 = new tNMEA2000_esp32(CAN_TX_PIN, CAN_RX_PIN);
-
-                 // Reserve enough buffer for sending all messages. This does not work on small
-                 // memory devices like Uno or Mega
-                 nmea2000->SetN2kCANSendFrameBufSize(250);
-                 nmea2000->SetN2kCANReceiveFrameBufSize(250);
-
-                 // Set Product information
-                 nmea2000->SetProductInformation(
-                     "20210405",             // Manufacturer's Model serial code (max 32 chars)
-                     103,                    // Manufacturer's product code
-                     "SH-ESP32 Temp Sensor", // Manufacturer's Model ID (max 33 chars)
-                     "0.1.0.0 (2021-04-05)", // Manufacturer's Software version code (max 40
-                                             // chars)
-                     "0.0.3.1 (2021-03-07)"  // Manufacturer's Model version (max 24 chars)
-                 );
-                 // Set device information
-                 nmea2000->SetDeviceInformation(
-                     1,   // Unique number. Use e.g. Serial number.
-                     130, // Device function=Analog to NMEA 2000 Gateway. See codes on
-                          // http://www.nmea.org/Assets/20120726%20nmea%202000%20class%20&%20function%20codes%20v%202.00.pdf
-                     75,  // Device class=Inter/Intranetwork Device. See codes on
-                          // http://www.nmea.org/Assets/20120726%20nmea%202000%20class%20&%20function%20codes%20v%202.00.pdf
-                     2046 // Just choosen free from code list on
-                          // http://www.nmea.org/Assets/20121020%20nmea%202000%20registration%20list.pdf
-                 );
+                sensesp_app->start();
+                engine_bus.store_forward->start();
+                engine_bus.udp->start();
+
+                // sample rates and sleep follow the engines: running, idle or parked
+                auto *power = BootArena::make<PowerManager>(Subsystem::consumers, CAN_RX_PIN, "/System/PowerProfiles");
+                power->start();
+
+                // every object has loaded its configuration: move the ones still in JSON files to the store
+                ConfigStore::commit();
+                ConfigStore::report();
+
+                // spread the periodic tasks over their periods once their costs are known
+                PhaseScheduler::start();
+                BootProfiler::reach(BootMilestone::app_started);
+
+                // the whole graph is in place, make sure the network stack is left enough heap;
+                // if it isn't, the board still runs, without the extras below
+                BootArena::report();
+                bool heap_ok = BootArena::check_heap_floor();
+                if (heap_ok) {
+                    // start and stop captures, next to the SensESP web UI on port 80
+                    BurstRecorder::serve(81);
+                } else {
+                    // a warning on Signal K, next to SensESP's sensorDevice values, repeated so
+                    // it still arrives when the server is reached later
+                    static char heap_warning[200];
+                    snprintf(heap_warning, sizeof(heap_warning),
+                             R"({"state":"warn","method":["visual"],"message":"Free heap %u bytes after boot, below the floor of %u bytes; the capture server is off"})",
+                             ESP.getFreeHeap(), (unsigned)HEAP_FLOOR_BYTES);
+                    auto *heap_notification = BootArena::make<SKOutputRawJson>(
+                        Subsystem::signalk, "notifications.sensorDevice." + sensesp_app->get_hostname() + ".heapLow", "");
+                    heap_notification->set_input(heap_warning);
+                    app.onRepeat(60U*1000U, [heap_notification]() { heap_notification->set_input(heap_warning); });
+                }
+
+#ifdef ALLOC_WATCH
+                // from here on the sample path should not allocate any more
+                AllocWatch::arm();
+                app.onRepeat(10U*1000U, []() { AllocWatch::report(); });
+#endif
 
-                 nmea2000->SetMode(tNMEA2000::N2km_NodeOnly, 22);
-                 // Disable all msg forwarding to USB (=Serial)
-                 nmea2000->EnableForward(false);
-                 nmea2000->Open();
+#ifdef LATENCY_TRACE
+                // how old values are when they leave, per sink
+                app.onRepeat(30U*1000U, []() { LatencyTrace::report(); });
+#endif
 
-                 // No need to parse the messages at every single loop iteration; 10 ms will do
-                 app.onRepeat(10, []()
-                              { nmea2000->ParseMessages(); });
-
-                 // Implement the N2K PGN sending. Engine (oil) temperature and coolant
-                 // temperature are a bit more complex because they're sent together
-                 // as part of a Engine Dynamic Parameter PGN.
-
-                 main_engine_oil_temperature->connect_to(
-                     new LambdaConsumer<float>([](float temperature)
-                                               {
-                                                   oil_temperature = temperature;
-                                                   SendEngineTemperatures();
-                                               }));
-                 main_engine_coolant_temperature->connect_to(
-                     new LambdaConsumer<float>([](float temperature)
-                                               {
-                                                   coolant_temperature = temperature;
-                                                   SendEngineTemperatures();
-                                               }));
-                 // hijack the exhaust gas temperature for wet exhaust temperature
-                 // measurement
-                 main_engine_exhaust_temperature->connect_to(
-                     new LambdaConsumer<float>([](float temperature)
-                                               {
-                                                   tN2kMsg N2kMsg;
-                                                   SetN2kTemperature(N2kMsg,
-                                                                     1,                           // SID
-                                                                     2,                           // TempInstance
-                                                                     N2kts_ExhaustGasTemperature, // TempSource
-                                                                     temperature                  // actual temperature
-                                                   );
-
-                                                   // Set the alternator measurement, note there is no place in ny message on egine
-                                                   // an alternative could be to use PGN130312 'Temperature as measured by a specific temperature source'
-                                                   // TODO
-
-                                                   nmea2000->SendMsg(N2kMsg);
-                                               }));
+#ifdef STRESS_TEST
+                // add synthetic channels step by step and log what the board can take
+                if (heap_ok) {
+                    BootArena::make<StressTest>(Subsystem::consumers, engine_bus.n2k_tx, "/System/StressTest")->start();
+                }
+#endif
 
-                sensesp_app->start();
+                // by now the first samples have made it to the bus and the display
+                app.onDelay(10U*1000U, []() { BootProfiler::report(); });
+                // and the display has had a few hundred row updates to measure
+                app.onDelay(60U*1000U, []() { oled->report(); });
              }
 
 
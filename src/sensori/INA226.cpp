@@ -44,6 +44,7 @@ bool INA226::configure(ina226_averages_t avg, ina226_busConvTime_t busConvTime,
     vShuntMax = 0.08192f;
     
     writeRegister16(INA226_REG_CONFIG, config);
+    configValue = config;
     
     return true;
 }
@@ -192,6 +193,27 @@ uint16_t INA226::getMaskEnable(void)
     return readRegister16(INA226_REG_MASKENABLE);
 }
 
+// Change only the operating mode. In the triggered modes the chip converts
+// once and then powers down until the next trigger.
+void INA226::setMode(ina226_mode_t mode)
+{
+    configValue = (configValue & ~0b0000000000000111) | mode;
+    writeRegister16(INA226_REG_CONFIG, configValue);
+}
+
+// In a triggered mode, as last set by configure() or setMode()
+bool INA226::isTriggered(void)
+{
+    uint16_t mode = configValue & 0b0000000000000111;
+    return mode >= INA226_MODE_SHUNT_TRIG && mode <= INA226_MODE_SHUNT_BUS_TRIG;
+}
+
+// Writing the configuration in a triggered mode starts a single conversion
+void INA226::triggerConversion(void)
+{
+    writeRegister16(INA226_REG_CONFIG, configValue);
+}
+
 void INA226::enableShuntOverLimitAlert(void)
 {
     writeRegister16(INA226_REG_MASKENABLE, INA226_BIT_SOL);
@@ -280,6 +302,51 @@ bool INA226::isAlert(void)
     return ((getMaskEnable() & INA226_BIT_AFF) == INA226_BIT_AFF);
 }
 
+// Read the bus voltage register count times, one read every periodUs, into
+// samples (raw, 1.25 mV per LSB). The register pointer is set once and every
+// sample is a bare 2 byte read, without the delay of readRegister16(), at
+// 400 kHz. Blocks for the whole capture and returns its duration in
+// microseconds, or 0 if the INA226 stopped answering and the capture was
+// abandoned.
+uint32_t INA226::captureBusVoltage(int16_t *samples, size_t count, uint32_t periodUs)
+{
+    uint32_t clock = wire->getClock();
+    wire->setClock(400000);
+
+    wire->beginTransmission(inaAddress);
+    wire->write(INA226_REG_BUSVOLTAGE);
+    bool ok = wire->endTransmission() == 0;
+
+    uint32_t start = micros();
+    uint32_t next = start;
+    for (size_t i = 0; ok && i < count; i++)
+    {
+        while ((int32_t)(micros() - next) < 0) {};
+        next += periodUs;
+
+        // a NACK or a stuck bus leaves nothing to read
+        if (wire->requestFrom(inaAddress, 2) != 2)
+        {
+            ok = false;
+            break;
+        }
+        uint8_t vha = wire->read();
+        uint8_t vla = wire->read();
+        samples[i] = vha << 8 | vla;
+    }
+    uint32_t elapsed = micros() - start;
+
+    wire->setClock(clock);
+    return ok ? elapsed : 0;
+}
+
+// The whole Mask/Enable register: which alert function is enabled, plus the
+// AFF, CVRF and OVF flags. Reading it clears a latched alert.
+uint16_t INA226::readAlertStatus(void)
+{
+    return getMaskEnable();
+}
+
 int16_t INA226::readRegister16(uint8_t reg)
 {
     int16_t value;
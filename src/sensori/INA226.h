@@ -106,6 +106,9 @@ public:
     ina226_busConvTime_t getBusConversionTime(void);
     ina226_shuntConvTime_t getShuntConversionTime(void);
     ina226_mode_t getMode(void);
+    void setMode(ina226_mode_t mode);
+    bool isTriggered(void);
+    void triggerConversion(void);
     
     void enableShuntOverLimitAlert(void);
     void enableShuntUnderLimitAlert(void);
@@ -123,11 +126,13 @@ public:
     
     bool isMathOverflow(void);
     bool isAlert(void);
+    uint16_t readAlertStatus(void);
     
     float readShuntCurrent(void);
     float readShuntVoltage(void);
     float readBusPower(void);
     float readBusVoltage(void);
+    uint32_t captureBusVoltage(int16_t *samples, size_t count, uint32_t periodUs);
     
     float getMaxPossibleCurrent(void);
     float getMaxCurrent(void);
@@ -137,6 +142,7 @@ public:
 private:
     TwoWire *wire;
     int8_t inaAddress;
+    uint16_t configValue;
     float currentLSB, powerLSB;
     float vShuntMax, vBusMax, rShunt;
     
@@ -3,6 +3,7 @@
 
 #include "activity_timer.h"
 #include "sensesp/transforms/transform.h"
+#include "system/config_store.h"
 
 
 namespace sensesp {
@@ -24,6 +25,8 @@ namespace sensesp {
   ActivityTimer(float offset, String config_path = "");
 
   virtual void set_input(float value, uint8_t inputChannel) override;
+  virtual void load_configuration() override { ConfigStore::load(this); }
+  virtual void save_configuration() override { ConfigStore::save(this); }
   virtual void get_configuration(JsonObject& doc) override;
   virtual bool set_configuration(const JsonObject& config) override;
   virtual String get_config_schema() override;
@@ -0,0 +1,106 @@
+#include "sensori/alternator_ripple.h"
+
+#include "sensesp.h"
+#include "sensori/goertzel.h"
+#include "system/latency_trace.h"
+
+// below this the engine isn't running, in rev/s
+#define RIPPLE_MIN_REVS 5.0
+// INA226 bus voltage LSB
+#define BUS_VOLTS_PER_LSB 0.00125f
+
+namespace sensesp {
+
+AlternatorRipple::AlternatorRipple(INA226* pINA226, float pulses_per_rev,
+                                   uint32_t interval_ms, String config_path)
+    : FloatTransform(config_path),
+      pINA226{pINA226},
+      pulses_per_rev{pulses_per_rev},
+      interval_ms{interval_ms} {
+  load_configuration();
+}
+
+void AlternatorRipple::set_input(float revs, uint8_t input_channel) {
+  unsigned long now = millis();
+  if (revs < RIPPLE_MIN_REVS || now - last_burst_ms < interval_ms) {
+    return;
+  }
+  last_burst_ms = now;
+  burst(revs);
+}
+
+void AlternatorRipple::burst(float revs) {
+  ina226_averages_t averages = pINA226->getAverages();
+  ina226_busConvTime_t bus_time = pINA226->getBusConversionTime();
+  ina226_shuntConvTime_t shunt_time = pINA226->getShuntConversionTime();
+  ina226_mode_t mode = pINA226->getMode();
+
+  // the ratio is as old as the capture, not the RPM reading that started it
+  LatencyChain chain;
+  pINA226->configure(INA226_AVERAGES_1, INA226_BUS_CONV_TIME_140US,
+                     INA226_SHUNT_CONV_TIME_140US, INA226_MODE_BUS_CONT);
+  uint32_t elapsed_us = pINA226->captureBusVoltage(
+      samples, RIPPLE_SAMPLES, RIPPLE_SAMPLE_PERIOD_US);
+  pINA226->configure(averages, bus_time, shunt_time, mode);
+  if (elapsed_us == 0) {
+    debugW("Ripple: INA226 not answering, capture abandoned");
+    return;
+  }
+
+  // the actual sample rate, the pacing slips when a read takes longer
+  float sample_rate = (RIPPLE_SAMPLES - 1) * 1e6f / elapsed_us;
+  float electrical_hz = revs * pulses_per_rev;
+  if (6.0f * electrical_hz > 0.5f * sample_rate) {
+    debugD("Ripple: %.0f Hz out of reach at %.0f samples/s",
+           6.0f * electrical_hz, sample_rate);
+    return;
+  }
+
+  const float harmonics[] = {1.0f, 2.0f, 6.0f};
+  float mean = sample_mean(samples, RIPPLE_SAMPLES);
+  for (size_t i = 0; i < 3; i++) {
+    amplitudes[i] =
+        BUS_VOLTS_PER_LSB *
+        goertzel_amplitude(samples, RIPPLE_SAMPLES, mean,
+                           harmonics[i] * electrical_hz / sample_rate);
+  }
+  if (amplitudes[2] <= 0.0f) {
+    return;
+  }
+  float ratio = sqrtf(amplitudes[0] * amplitudes[0] +
+                      amplitudes[1] * amplitudes[1]) / amplitudes[2];
+  debugI("Ripple at %.0f Hz: %.4f %.4f %.4f V, ratio %.2f", electrical_hz,
+         amplitudes[0], amplitudes[1], amplitudes[2], ratio);
+  this->emit(ratio);
+}
+
+void AlternatorRipple::get_configuration(JsonObject& root) {
+  root["pulses_per_rev"] = pulses_per_rev;
+  root["interval"] = interval_ms;
+  root["value"] = output;
+}
+
+static const char SCHEMA[] PROGMEM = R"###({
+    "type": "object",
+    "properties": {
+        "pulses_per_rev": { "title": "Pulses per revolution", "type": "number", "description": "W terminal pulses per engine revolution" },
+        "interval": { "title": "Interval", "type": "integer", "description": "Time between ripple captures, in milliseconds" },
+        "value": { "title": "Last ripple ratio", "type" : "number", "readOnly": true }
+    }
+  })###";
+
+String AlternatorRipple::get_config_schema() { return FPSTR(SCHEMA); }
+
+bool AlternatorRipple::set_configuration(const JsonObject& config) {
+  String expected[] = {"pulses_per_rev", "interval"};
+  for (auto str : expected) {
+    if (!config.containsKey(str)) {
+      return false;
+    }
+  }
+  pulses_per_rev = config["pulses_per_rev"];
+  interval_ms = config["interval"];
+  return true;
+}
+
+}  // namespace sensesp
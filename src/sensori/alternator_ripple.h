@@ -0,0 +1,69 @@
+#ifndef _alternator_ripple_H_
+#define _alternator_ripple_H_
+
+#include <Arduino.h>
+#include <Wire.h>
+#include "sensori/INA226.h"
+
+#include "sensesp/transforms/transform.h"
+#include "system/config_store.h"
+
+// samples per burst, 2 bytes each
+#define RIPPLE_SAMPLES 256
+// time between samples, just over the 140 us conversion time; a 2 byte read
+// takes about 100 us at 400 kHz I2C
+#define RIPPLE_SAMPLE_PERIOD_US 150
+
+namespace sensesp {
+
+/**
+ * @brief Alternator diode and stator health from the bus voltage ripple
+ *
+ * A healthy three phase bridge leaves ripple at 6x the electrical frequency.
+ * An open diode or a failed stator phase adds strong components at 1x and 2x.
+ * The input is the engine speed in rev/s; with the pulses per revolution of
+ * the W terminal this gives the electrical frequency.
+ *
+ * Every interval_ms, while the engine runs, the INA226 is switched to bus-only
+ * conversions at 140 us without averaging, RIPPLE_SAMPLES readings are
+ * captured and the chip's configuration is restored. The capture blocks the
+ * loop for about 40 ms; it runs right after an input update so it never
+ * overlaps a regular INA226value reading. The Goertzel amplitudes at 1x, 2x
+ * and 6x the electrical frequency give the output:
+ *
+ *   ripple ratio = sqrt(A1^2 + A2^2) / A6
+ *
+ * A good alternator stays well below 1. Nothing is emitted when 6x the
+ * electrical frequency is above the Nyquist limit of the capture: half of
+ * 1 / RIPPLE_SAMPLE_PERIOD_US is 3333 Hz, so 6x stays below it up to 556 Hz,
+ * about 2500 RPM with 13.23 pulses per revolution.
+ */
+class AlternatorRipple : public FloatTransform {
+ public:
+  AlternatorRipple(INA226* pINA226, float pulses_per_rev = 13.23,
+                   uint32_t interval_ms = 60000, String config_path = "");
+
+  virtual void set_input(float revs, uint8_t input_channel = 0) override;
+
+  /// Ripple amplitudes of the last burst, in volts, at 1x, 2x and 6x
+  const float* get_amplitudes() const { return amplitudes; }
+
+ private:
+  INA226* pINA226;
+  float pulses_per_rev;
+  uint32_t interval_ms;
+  unsigned long last_burst_ms = 0;
+  int16_t samples[RIPPLE_SAMPLES];
+  float amplitudes[3] = {};
+
+  void burst(float revs);
+  virtual void load_configuration() override { ConfigStore::load(this); }
+  virtual void save_configuration() override { ConfigStore::save(this); }
+  virtual void get_configuration(JsonObject& root) override;
+  virtual bool set_configuration(const JsonObject& config) override;
+  virtual String get_config_schema() override;
+};
+
+}  // namespace sensesp
+
+#endif
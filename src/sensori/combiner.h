@@ -0,0 +1,195 @@
+#ifndef _combiner_H_
+#define _combiner_H_
+
+#include <array>
+
+#include "sensesp/transforms/transform.h"
+#include "system/config_store.h"
+#include "system/latency_trace.h"
+#include "system/phase_scheduler.h"
+
+namespace sensesp {
+
+/// When a Combiner produces a new output
+enum class CombinerPolicy : uint8_t {
+  all_fresh = 0,   // every input has been updated since the last output
+  any_update = 1,  // any input update, as long as all inputs are current
+  periodic = 2     // on a fixed period, as long as all inputs are current
+};
+
+/**
+ * @brief Time alignment of N input values, without heap allocation
+ *
+ * Each input value is stamped with the time it was received. Two values are
+ * considered aligned when they are no more than max_skew_ms apart, so an input
+ * that stops updating expires instead of being combined forever, and a fast
+ * input simply overwrites its own slot with the most recent value.
+ *
+ * update() returns true when the policy says the inputs should be combined
+ * now; due() does the same for the periodic policy.
+ */
+template <size_t N>
+class InputAligner {
+  static_assert(N > 0 && N <= 32, "InputAligner supports 1 to 32 inputs");
+
+ public:
+  InputAligner(CombinerPolicy policy, uint32_t max_skew_ms)
+      : policy{policy}, max_skew_ms{max_skew_ms} {}
+
+  bool update(uint8_t channel, float value, uint32_t now_ms) {
+    if (channel >= N) {
+      return false;
+    }
+    values[channel] = value;
+    stamps[channel] = now_ms;
+    valid_mask |= 1UL << channel;
+    fresh_mask |= 1UL << channel;
+
+    switch (policy) {
+      case CombinerPolicy::all_fresh:
+        expire(now_ms);
+        if (fresh_mask == ALL) {
+          fresh_mask = 0;
+          return true;
+        }
+        return false;
+      case CombinerPolicy::any_update:
+        return aligned(now_ms);
+      default:
+        return false;
+    }
+  }
+
+  bool due(uint32_t now_ms) { return aligned(now_ms); }
+
+  const std::array<float, N>& get_values() const { return values; }
+
+  CombinerPolicy policy;
+  uint32_t max_skew_ms;
+
+ private:
+  static constexpr uint32_t ALL = (N == 32) ? 0xFFFFFFFFUL : ((1UL << N) - 1);
+
+  std::array<float, N> values{};
+  std::array<uint32_t, N> stamps{};
+  uint32_t valid_mask = 0;
+  uint32_t fresh_mask = 0;
+
+  // all inputs have a value that is no older than max_skew_ms
+  bool aligned(uint32_t now_ms) const {
+    if (valid_mask != ALL) {
+      return false;
+    }
+    for (size_t i = 0; i < N; i++) {
+      if (now_ms - stamps[i] > max_skew_ms) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // a fresh value that has grown too old to pair with the newest one no longer
+  // counts; wait for the next update of that input instead
+  void expire(uint32_t now_ms) {
+    for (size_t i = 0; i < N; i++) {
+      if ((fresh_mask & (1UL << i)) && now_ms - stamps[i] > max_skew_ms) {
+        fresh_mask &= ~(1UL << i);
+      }
+    }
+  }
+};
+
+static const char COMBINER_SCHEMA[] PROGMEM = R"###({
+    "type": "object",
+    "properties": {
+        "policy": { "title": "Output policy", "type": "integer", "description": "0 = all inputs fresh, 1 = any input update, 2 = periodic (a change to or from periodic is applied after a restart)" },
+        "max_skew": { "title": "Maximum skew", "type": "integer", "description": "Maximum age difference between inputs, in milliseconds" },
+        "period": { "title": "Period", "type": "integer", "description": "Output period for the periodic policy, in milliseconds (applied after a restart)" },
+        "value": { "title": "Last value", "type" : "number", "readOnly": true }
+    }
+  })###";
+
+/**
+ * @brief Combine N time-aligned float inputs into one output
+ *
+ * Connect the producers to input channels 0 .. N-1. The combine function gets
+ * the latest value of every input and returns the output value; any callable
+ * will do, e.g. a captureless lambda:
+ *
+ *   auto power = new Combiner<2>(
+ *       [](const std::array<float, 2>& in) { return in[0] * in[1]; },
+ *       CombinerPolicy::any_update, 1500);
+ *   volts->connect_to(power, 0);
+ *   amps->connect_to(power, 1);
+ *
+ * The arity is fixed at compile time and the inputs live inside the object,
+ * so nothing is allocated per sample. Only the periodic policy takes a
+ * PhaseScheduler task, the others run on their inputs alone.
+ */
+template <size_t N, typename CombineFunc = float (*)(const std::array<float, N>&)>
+class Combiner : public FloatTransform {
+ public:
+  Combiner(CombineFunc combine,
+           CombinerPolicy policy = CombinerPolicy::all_fresh,
+           uint32_t max_skew_ms = 2000, uint32_t period_ms = 1000,
+           String config_path = "")
+      : FloatTransform(config_path),
+        combine{combine},
+        aligner{policy, max_skew_ms},
+        period_ms{period_ms} {
+    load_configuration();
+    if (aligner.policy == CombinerPolicy::periodic) {
+      PhaseScheduler::add("Combiner", this->period_ms, [this]() {
+        if (aligner.policy == CombinerPolicy::periodic &&
+            aligner.due(millis())) {
+          LatencyChain chain;
+          this->emit(this->combine(aligner.get_values()));
+        }
+      });
+    }
+  }
+
+  virtual void set_input(float input, uint8_t input_channel) override {
+    if (aligner.update(input_channel, input, millis())) {
+      this->emit(combine(aligner.get_values()));
+    }
+  }
+
+  virtual void load_configuration() override { ConfigStore::load(this); }
+  virtual void save_configuration() override { ConfigStore::save(this); }
+  virtual void get_configuration(JsonObject& root) override {
+    root["policy"] = (int)aligner.policy;
+    root["max_skew"] = aligner.max_skew_ms;
+    root["period"] = period_ms;
+    root["value"] = output;
+  }
+
+  virtual bool set_configuration(const JsonObject& config) override {
+    String expected[] = {"policy", "max_skew", "period"};
+    for (auto str : expected) {
+      if (!config.containsKey(str)) {
+        return false;
+      }
+    }
+    int policy = config["policy"];
+    if (policy < (int)CombinerPolicy::all_fresh ||
+        policy > (int)CombinerPolicy::periodic) {
+      return false;
+    }
+    aligner.policy = (CombinerPolicy)policy;
+    aligner.max_skew_ms = config["max_skew"];
+    period_ms = config["period"];
+    return true;
+  }
+
+  virtual String get_config_schema() override { return FPSTR(COMBINER_SCHEMA); }
+
+ private:
+  CombineFunc combine;
+  InputAligner<N> aligner;
+  uint32_t period_ms;
+};
+
+}  // namespace sensesp
+
+#endif
@@ -4,16 +4,17 @@ namespace sensesp {
 
 // Difference
 
-Difference::Difference(float k1, float k2, String config_path)
-    : FloatTransform(config_path), k1{k1}, k2{k2} {
+Difference::Difference(float k1, float k2, String config_path, uint32_t max_skew_ms)
+    : FloatTransform(config_path),
+      aligner{CombinerPolicy::all_fresh, max_skew_ms},
+      k1{k1},
+      k2{k2} {
   load_configuration();
 }
 
 void Difference::set_input(float input, uint8_t inputChannel) {
-  inputs[inputChannel] = input;
-  received |= 1 << inputChannel;
-  if (received == 0b11) {
-    received = 0;
+  if (aligner.update(inputChannel, input, millis())) {
+    const std::array<float, 2>& inputs = aligner.get_values();
     this->emit(k1 * inputs[0] - k2 * inputs[1]);
   }
 }
@@ -21,6 +22,7 @@ void Difference::set_input(float input, uint8_t inputChannel) {
 void Difference::get_configuration(JsonObject& root) {
   root["k1"] = k1;
   root["k2"] = k2;
+  root["max_skew"] = aligner.max_skew_ms;
   root["value"] = output;
 }
 
@@ -29,6 +31,7 @@ static const char SCHEMA[] PROGMEM = R"({
     "properties": {
         "k1": { "title": "Input #1 multiplier", "type": "number" },
         "k2": { "title": "Input #2 multiplier", "type": "number" },
+        "max_skew": { "title": "Maximum skew", "type": "integer", "description": "Maximum age difference between the inputs, in milliseconds" },
         "value": { "title": "Last value", "type" : "number", "readOnly": true }
     }
   })";
@@ -44,6 +47,10 @@ bool Difference::set_configuration(const JsonObject& config) {
   }
   k1 = config["k1"];
   k2 = config["k2"];
+  // optional, configurations saved before it existed don't have it
+  if (config.containsKey("max_skew")) {
+    aligner.max_skew_ms = config["max_skew"];
+  }
   return true;
 }
 
@@ -1,22 +1,28 @@
 #ifndef _difference_H_
 #define _difference_H_
 
+#include "sensori/combiner.h"
 #include "sensesp/transforms/transform.h"
+#include "system/config_store.h"
 
 namespace sensesp {
 
 // y = k1 * x1 - k2 * x2
+//
+// Emits once both inputs have been updated and are no more than max_skew_ms
+// apart. For other policies or more inputs, use Combiner.
 class Difference : public FloatTransform {
  public:
-  Difference(float k1, float k2, String config_path = "");
+  Difference(float k1, float k2, String config_path = "", uint32_t max_skew_ms = 2000);
   virtual void set_input(float input, uint8_t inputChannel) override;
+  virtual void load_configuration() override { ConfigStore::load(this); }
+  virtual void save_configuration() override { ConfigStore::save(this); }
   virtual void get_configuration(JsonObject& doc) override;
   virtual bool set_configuration(const JsonObject& config) override;
   virtual String get_config_schema() override;
 
  private:
-  uint8_t received = 0;
-  float inputs[2];
+  InputAligner<2> aligner;
   float k1;
   float k2;
 };
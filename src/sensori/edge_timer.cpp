@@ -0,0 +1,182 @@
+#include "sensori/edge_timer.h"
+
+#include "sensesp.h"
+#include "system/latency_trace.h"
+#include "system/phase_scheduler.h"
+
+// faster than this is contact bounce or noise, 10 kHz
+#define EDGE_MIN_PERIOD_US 100
+// slower than this the engine is stopping, start the window over
+#define EDGE_MAX_PERIOD_US 100000
+#define ROUGHNESS_PERIOD_MS 1000
+
+namespace sensesp {
+
+EdgeTimer::EdgeTimer(uint8_t pin, int pin_mode, int interrupt_type,
+                     unsigned int read_delay, uint8_t edges_per_rev,
+                     String config_path)
+    : IntSensor(config_path),
+      pin{pin},
+      pin_mode{pin_mode},
+      interrupt_type{interrupt_type},
+      read_delay{read_delay},
+      edges_per_rev{edges_per_rev} {
+  load_configuration();
+}
+
+void EdgeTimer::start() {
+  pinMode(pin, pin_mode);
+
+  ReactESP::app->onInterrupt(pin, interrupt_type,
+                             [this]() { this->edge(micros()); });
+
+  PhaseScheduler::add("EdgeTimer", read_delay, [this]() {
+    noInterrupts();
+    output = counter;
+    counter = 0;
+    interrupts();
+    LatencyChain chain;
+    this->notify();
+  });
+
+  ReactESP::app->onTick([this]() { this->drain(); });
+  PhaseScheduler::add("roughness", ROUGHNESS_PERIOD_MS, [this]() {
+    LatencyChain chain;
+    this->report();
+  });
+}
+
+// Called by the interrupt handler, keep it minimal: count, and store the
+// period for the loop
+void EdgeTimer::edge(uint32_t now) {
+  uint32_t period = now - last_edge_us;
+  if (period < EDGE_MIN_PERIOD_US) {
+    return;
+  }
+  last_edge_us = now;
+  counter = counter + 1;
+  ring[head % EDGE_RING_SIZE] = period;
+  head = head + 1;
+}
+
+void EdgeTimer::count_edge() {
+  noInterrupts();
+  edge(micros());
+  interrupts();
+}
+
+void EdgeTimer::drain() {
+  uint32_t end = head;
+  if (end - tail > EDGE_RING_SIZE) {
+    overruns += end - tail - EDGE_RING_SIZE;
+    tail = end - EDGE_RING_SIZE;
+    reset_window();
+  }
+  for (; tail != end; tail++) {
+    last_period_us = ring[tail % EDGE_RING_SIZE];
+    add_period(last_period_us);
+  }
+}
+
+uint32_t EdgeTimer::get_period_us() const {
+  uint32_t edge_us = last_edge_us;
+  if (micros() - edge_us > EDGE_MAX_PERIOD_US) {
+    return 0;
+  }
+  return last_period_us;
+}
+
+void EdgeTimer::add_period(uint32_t period_us) {
+  if (period_us > EDGE_MAX_PERIOD_US) {
+    reset_window();
+    return;
+  }
+
+  uint64_t p = period_us;
+  if (window_fill == edges_per_rev) {
+    uint64_t oldest = window[window_pos];
+    sum -= oldest;
+    sum_squares -= oldest * oldest;
+  } else {
+    window_fill++;
+  }
+  window[window_pos] = period_us;
+  window_pos = (window_pos + 1) % edges_per_rev;
+  sum += p;
+  sum_squares += p * p;
+
+  if (window_fill < edges_per_rev) {
+    return;
+  }
+
+  // coefficient of variation within the last revolution, squared:
+  // var / mean^2 = (n * sum_squares - sum^2) / sum^2
+  // in integers, the difference is tiny compared to the terms
+  uint64_t spread = edges_per_rev * sum_squares - sum * sum;
+  float s = sum;
+  cv2_sum += spread / (s * s);
+  cv2_n++;
+
+  // every edges_per_rev edges a new, non-overlapping revolution is complete
+  if (++since_rev >= edges_per_rev) {
+    since_rev = 0;
+    if (last_rev_us != 0) {
+      float change = ((float)sum - (float)last_rev_us) / s;
+      c2c2_sum += change * change;
+      c2c2_n++;
+    }
+    last_rev_us = sum;
+  }
+}
+
+void EdgeTimer::reset_window() {
+  window_fill = 0;
+  window_pos = 0;
+  since_rev = 0;
+  sum = 0;
+  sum_squares = 0;
+  last_rev_us = 0;
+}
+
+void EdgeTimer::report() {
+  if (cv2_n == 0 || c2c2_n == 0) {
+    return;
+  }
+  float index = sqrtf(cv2_sum / cv2_n + c2c2_sum / c2c2_n);
+  cv2_sum = c2c2_sum = 0.0f;
+  cv2_n = c2c2_n = 0;
+  roughness_value.set(index);
+}
+
+void EdgeTimer::get_configuration(JsonObject& root) {
+  root["read_delay"] = read_delay;
+  root["edges_per_rev"] = edges_per_rev;
+  root["overruns"] = overruns;
+}
+
+static const char SCHEMA[] PROGMEM = R"###({
+    "type": "object",
+    "properties": {
+        "read_delay": { "title": "Read delay", "type": "integer", "description": "The time, in milliseconds, between each pulse count output (applied after a restart)" },
+        "edges_per_rev": { "title": "Edges per revolution", "type": "integer", "description": "Pulses per engine revolution, rounded; the window for the roughness index" },
+        "overruns": { "title": "Dropped edges", "type" : "integer", "readOnly": true }
+    }
+  })###";
+
+String EdgeTimer::get_config_schema() { return FPSTR(SCHEMA); }
+
+bool EdgeTimer::set_configuration(const JsonObject& config) {
+  String expected[] = {"read_delay", "edges_per_rev"};
+  for (auto str : expected) {
+    if (!config.containsKey(str)) {
+      return false;
+    }
+  }
+  read_delay = config["read_delay"];
+  int edges = config["edges_per_rev"];
+  edges_per_rev = constrain(edges, 2, EDGE_WINDOW_MAX);
+  reset_window();
+  return true;
+}
+
+}  // namespace sensesp
@@ -0,0 +1,106 @@
+#ifndef _edge_timer_H_
+#define _edge_timer_H_
+
+#include <Arduino.h>
+
+#include "sensesp/sensors/sensor.h"
+#include "sensesp/system/observablevalue.h"
+#include "system/config_store.h"
+
+// periods buffered between the interrupt handler and the loop, power of 2
+#define EDGE_RING_SIZE 64
+// longest revolution window, in edges
+#define EDGE_WINDOW_MAX 32
+
+namespace sensesp {
+
+/**
+ * @brief Pulse counter that also times every edge, for crank speed variation
+ *
+ * A drop-in replacement for DigitalInputCounter: it owns the pin's only
+ * interrupt handler and still emits the number of pulses every read_delay ms.
+ * The handler additionally stores the period since the previous edge in a
+ * ring buffer; the loop drains it every tick.
+ *
+ * From the drained periods a sliding window of one revolution (edges_per_rev
+ * edges, e.g. 13 for 13.23 W terminal pulses per revolution) is kept with a
+ * running sum and sum of squares, so each edge costs O(1):
+ *
+ *  - within a revolution, the coefficient of variation of the pulse periods
+ *  - from revolution to revolution, the relative change of its duration
+ *
+ * The roughness index, emitted by roughness() every second, is the RMS of
+ * both, as a ratio. A smooth diesel stays around a few thousandths; a
+ * cylinder that doesn't fire slows the crank once every cycle and raises
+ * both terms. The alternator belt filters the signal, so this is a coarse
+ * view, good for trends rather than for naming the cylinder.
+ */
+class EdgeTimer : public IntSensor {
+ public:
+  EdgeTimer(uint8_t pin, int pin_mode, int interrupt_type,
+            unsigned int read_delay = 200, uint8_t edges_per_rev = 13,
+            String config_path = "");
+  void start() override final;
+
+  /// Roughness index, emitted every second while the engine runs
+  ObservableValue<float>& roughness() { return roughness_value; }
+
+  /// periods dropped because the loop didn't keep up
+  uint32_t get_overruns() const { return overruns; }
+
+  /// The latest drained pulse period in us, 0 once the pin has gone quiet
+  uint32_t get_period_us() const;
+
+  /// An edge the interrupt handler couldn't see, e.g. the one that woke the
+  /// board from light sleep with the handler masked
+  void count_edge();
+
+ private:
+  uint8_t pin;
+  int pin_mode;
+  int interrupt_type;
+  unsigned int read_delay;
+  uint8_t edges_per_rev;
+
+  // written by the interrupt handler
+  volatile int32_t counter = 0;
+  volatile uint32_t last_edge_us = 0;
+  volatile uint32_t head = 0;
+  uint32_t ring[EDGE_RING_SIZE];
+
+  uint32_t tail = 0;
+  uint32_t overruns = 0;
+  uint32_t last_period_us = 0;
+
+  // sliding window of one revolution
+  uint32_t window[EDGE_WINDOW_MAX];
+  uint8_t window_fill = 0;
+  uint8_t window_pos = 0;
+  uint8_t since_rev = 0;
+  uint64_t sum = 0;
+  uint64_t sum_squares = 0;
+  uint64_t last_rev_us = 0;
+
+  // accumulated between roughness reports
+  float cv2_sum = 0.0f;
+  float c2c2_sum = 0.0f;
+  uint32_t cv2_n = 0;
+  uint32_t c2c2_n = 0;
+
+  ObservableValue<float> roughness_value;
+
+  void edge(uint32_t now);
+  void drain();
+  void add_period(uint32_t period_us);
+  void reset_window();
+  void report();
+  virtual void load_configuration() override { ConfigStore::load(this); }
+  virtual void save_configuration() override { ConfigStore::save(this); }
+  virtual void get_configuration(JsonObject& root) override;
+  virtual bool set_configuration(const JsonObject& config) override;
+  virtual String get_config_schema() override;
+};
+
+}  // namespace sensesp
+
+#endif
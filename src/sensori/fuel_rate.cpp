@@ -0,0 +1,79 @@
+#include "sensori/fuel_rate.h"
+
+// a load input older than this no longer counts
+#define FUEL_LOAD_TIMEOUT_MS 5000
+
+namespace sensesp {
+
+FuelRate::FuelRate(float rpm_max, String config_path)
+    : FloatTransform(config_path), rpm_max{rpm_max} {
+  for (size_t l = 0; l < FUEL_LOAD_POINTS; l++) {
+    for (size_t r = 0; r < FUEL_RPM_POINTS; r++) {
+      float load = (float)l / (FUEL_LOAD_POINTS - 1);
+      rates[l * FUEL_RPM_POINTS + r] = 0.3f + 7.7f * load;
+    }
+  }
+  load_configuration();
+}
+
+void FuelRate::set_input(float value, uint8_t input_channel) {
+  if (input_channel == 1) {
+    load = value;
+    load_millis = millis();
+    has_load = true;
+    return;
+  }
+  float rpm = value * 60.0f;
+  float ratio = rpm / rpm_max;
+  float engine_load =
+      (has_load && millis() - load_millis < FUEL_LOAD_TIMEOUT_MS)
+          ? load
+          : ratio * ratio * ratio;
+  float litres_per_hour = rpm > 0.0f ? lookup(engine_load, rpm) : 0.0f;
+  this->emit(litres_per_hour / 3600000.0f);
+}
+
+float FuelRate::lookup(float load, float rpm) const {
+  return fuel_table_lookup(rates, rpm_max, load, rpm);
+}
+
+void FuelRate::get_configuration(JsonObject& root) {
+  root["rpm_max"] = rpm_max;
+  JsonArray table = root.createNestedArray("rates");
+  for (float rate : rates) {
+    table.add(rate);
+  }
+  root["value"] = output * 3600000.0f;
+}
+
+static const char SCHEMA[] PROGMEM = R"###({
+    "type": "object",
+    "properties": {
+        "rpm_max": { "title": "Rated RPM", "type": "number", "description": "Engine speed at rated power, the end of the RPM axis" },
+        "rates": { "title": "Fuel rate table", "type": "array", "minItems": 45, "maxItems": 45, "items": { "type": "number" },
+                   "description": "Litres per hour, 5 rows of 9: load 0, 25, 50, 75 and 100 %, each at RPM 0, 1/8 .. 8/8 of rated RPM" },
+        "value": { "title": "Last fuel rate", "type" : "number", "description": "Litres per hour", "readOnly": true }
+    }
+  })###";
+
+String FuelRate::get_config_schema() { return FPSTR(SCHEMA); }
+
+bool FuelRate::set_configuration(const JsonObject& config) {
+  String expected[] = {"rpm_max", "rates"};
+  for (auto str : expected) {
+    if (!config.containsKey(str)) {
+      return false;
+    }
+  }
+  JsonArray table = config["rates"];
+  if (table.size() != FUEL_LOAD_POINTS * FUEL_RPM_POINTS) {
+    return false;
+  }
+  rpm_max = config["rpm_max"];
+  for (size_t i = 0; i < FUEL_LOAD_POINTS * FUEL_RPM_POINTS; i++) {
+    rates[i] = table[i];
+  }
+  return true;
+}
+
+}  // namespace sensesp
@@ -0,0 +1,54 @@
+#ifndef _fuel_rate_H_
+#define _fuel_rate_H_
+
+#include "sensesp/transforms/transform.h"
+#include "sensori/fuel_table.h"
+#include "system/config_store.h"
+
+namespace sensesp {
+
+/**
+ * @brief Fuel rate estimated from engine speed and load
+ *
+ * The consumption table is a FUEL_LOAD_POINTS x FUEL_RPM_POINTS grid in
+ * litres per hour, with evenly spaced axes: load from 0 to 1 (fraction of
+ * rated power) and RPM from 0 to rpm_max. Because the axes are uniform, the
+ * cell is found by a multiplication instead of a search, and every sample
+ * costs the same bilinear interpolation on a 180 byte table, see
+ * fuel_table_lookup().
+ *
+ * Input channel 0 is the engine speed in rev/s, channel 1 an optional load
+ * ratio. Without a load input (or when it is older than 5 s) the propeller
+ * law gives the load: (rpm / rpm_max)^3.
+ *
+ * The output is in m3/s, as Signal K wants it. The table and rpm_max are
+ * edited in the web UI; the default is a small diesel burning 0.3 l/h idling
+ * and 8 l/h at rated power.
+ */
+class FuelRate : public FloatTransform {
+ public:
+  FuelRate(float rpm_max = 3600, String config_path = "");
+
+  virtual void set_input(float value, uint8_t input_channel = 0) override;
+
+  /// Litres per hour at a load ratio and RPM, clamped to the table
+  float lookup(float load, float rpm) const;
+
+  virtual void load_configuration() override { ConfigStore::load(this); }
+  virtual void save_configuration() override { ConfigStore::save(this); }
+  virtual void get_configuration(JsonObject& root) override;
+  virtual bool set_configuration(const JsonObject& config) override;
+  virtual String get_config_schema() override;
+
+ private:
+  float rpm_max;
+  // row major, one row per load point
+  float rates[FUEL_LOAD_POINTS * FUEL_RPM_POINTS];
+  float load = 0.0f;
+  unsigned long load_millis = 0;
+  bool has_load = false;
+};
+
+}  // namespace sensesp
+
+#endif
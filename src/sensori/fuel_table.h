@@ -0,0 +1,41 @@
+#ifndef _fuel_table_H_
+#define _fuel_table_H_
+
+#include <math.h>
+
+// consumption grid: load 0, 25, 50, 75, 100 % by RPM 0 .. rpm_max
+#define FUEL_LOAD_POINTS 5
+#define FUEL_RPM_POINTS 9
+
+namespace sensesp {
+
+/**
+ * @brief Bilinear interpolation in a fuel consumption table
+ *
+ * rates is row major, one row of FUEL_RPM_POINTS per load point, with evenly
+ * spaced axes: load from 0 to 1 and RPM from 0 to rpm_max. The cell is found
+ * by a multiplication instead of a search. Load and RPM beyond the axes are
+ * clamped to the outer cells.
+ *
+ * No Arduino dependency, so it can be tested on a host.
+ */
+inline float fuel_table_lookup(const float* rates, float rpm_max, float load,
+                               float rpm) {
+  // position on the grid, clamped to the outer cells
+  float x = fminf(fmaxf(rpm / rpm_max, 0.0f), 1.0f) * (FUEL_RPM_POINTS - 1);
+  float y = fminf(fmaxf(load, 0.0f), 1.0f) * (FUEL_LOAD_POINTS - 1);
+  int col = (int)fminf(x, FUEL_RPM_POINTS - 2);
+  int row = (int)fminf(y, FUEL_LOAD_POINTS - 2);
+  float tx = x - col;
+  float ty = y - row;
+
+  const float* lo = &rates[row * FUEL_RPM_POINTS + col];
+  const float* hi = lo + FUEL_RPM_POINTS;
+  float at_lo = lo[0] + tx * (lo[1] - lo[0]);
+  float at_hi = hi[0] + tx * (hi[1] - hi[0]);
+  return at_lo + ty * (at_hi - at_lo);
+}
+
+}  // namespace sensesp
+
+#endif
@@ -0,0 +1,57 @@
+#include "sensori/fuel_used.h"
+
+namespace sensesp {
+
+FuelUsed::FuelUsed(float persist_volume, String config_path)
+    : FloatTransform(config_path), persist_volume{persist_volume} {
+  load_configuration();
+  last_millis = millis();
+}
+
+void FuelUsed::set_input(float rate, uint8_t input_channel) {
+  unsigned long now = millis();
+  // trapezoid over the time since the previous rate
+  unsaved += 0.5 * (rate + last_rate) * (now - last_millis) / 1000.0;
+  last_millis = now;
+
+  if ((rate <= 0.0f && last_rate > 0.0f) || unsaved >= persist_volume) {
+    persist();
+  }
+  last_rate = rate;
+  this->emit(total + unsaved);
+}
+
+void FuelUsed::persist() {
+  total += unsaved;
+  unsaved = 0.0;
+  save_configuration();
+}
+
+void FuelUsed::get_configuration(JsonObject& root) {
+  root["total"] = total;
+  root["persist_volume"] = persist_volume;
+}
+
+static const char SCHEMA[] PROGMEM = R"###({
+    "type": "object",
+    "properties": {
+        "total": { "title": "Fuel used", "type": "number", "description": "Total in m3, set to synchronise with a fuel log" },
+        "persist_volume": { "title": "Save every", "type": "number", "description": "Volume in m3 after which the total is saved while running" }
+    }
+  })###";
+
+String FuelUsed::get_config_schema() { return FPSTR(SCHEMA); }
+
+bool FuelUsed::set_configuration(const JsonObject& config) {
+  String expected[] = {"total", "persist_volume"};
+  for (auto str : expected) {
+    if (!config.containsKey(str)) {
+      return false;
+    }
+  }
+  total = config["total"];
+  persist_volume = config["persist_volume"];
+  return true;
+}
+
+}  // namespace sensesp
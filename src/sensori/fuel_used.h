@@ -0,0 +1,40 @@
+#ifndef _fuel_used_H_
+#define _fuel_used_H_
+
+#include "sensesp/transforms/transform.h"
+#include "system/config_store.h"
+
+namespace sensesp {
+
+/**
+ * @brief Fuel used, integrated from the fuel rate
+ *
+ * Persisted the way ActivityTimer persists engine hours: the total is saved
+ * to the configuration when the engine stops (the rate drops to zero) and
+ * every persist_volume while it runs, so a power loss costs at most that
+ * much. Input in m3/s, output in m3.
+ */
+class FuelUsed : public FloatTransform {
+ public:
+  FuelUsed(float persist_volume = 0.01, String config_path = "");
+
+  virtual void set_input(float rate, uint8_t input_channel = 0) override;
+  virtual void load_configuration() override { ConfigStore::load(this); }
+  virtual void save_configuration() override { ConfigStore::save(this); }
+  virtual void get_configuration(JsonObject& root) override;
+  virtual bool set_configuration(const JsonObject& config) override;
+  virtual String get_config_schema() override;
+
+ private:
+  double total = 0.0;
+  double unsaved = 0.0;
+  float persist_volume;
+  float last_rate = 0.0f;
+  unsigned long last_millis = 0;
+
+  void persist();
+};
+
+}  // namespace sensesp
+
+#endif
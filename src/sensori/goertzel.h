@@ -0,0 +1,68 @@
+#ifndef _goertzel_H_
+#define _goertzel_H_
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace sensesp {
+
+/// One frequency component: peak amplitude, and the phase of the cosine at
+/// the first sample in radians
+struct GoertzelResult {
+  float amplitude;
+  float phase;
+};
+
+/**
+ * @brief One frequency component of a block of samples
+ *
+ * Goertzel filter over n samples with the mean removed and a Hann window
+ * applied on the fly, so no work buffer is needed. The frequency is given as
+ * a fraction of the sample rate and need not fall on an FFT bin. The
+ * amplitude is the peak amplitude in the units of the samples, corrected for
+ * the window gain. The symmetric window leaves the phase as it is.
+ *
+ * Plain functions with no Arduino dependency, so they can be fed synthetic
+ * waveforms on a host.
+ */
+inline GoertzelResult goertzel(const int16_t* samples, size_t n, float mean,
+                               float cycles_per_sample) {
+  const float two_pi = 6.28318530718f;
+  float omega = two_pi * cycles_per_sample;
+  float coeff = 2.0f * cosf(omega);
+  float s1 = 0.0f;
+  float s2 = 0.0f;
+  for (size_t i = 0; i < n; i++) {
+    float window = 0.5f - 0.5f * cosf(two_pi * i / (n - 1));
+    float s = window * (samples[i] - mean) + coeff * s1 - s2;
+    s2 = s1;
+    s1 = s;
+  }
+  float power = s1 * s1 + s2 * s2 - coeff * s1 * s2;
+  // s1 - e^-iw s2 is the DFT term relative to the last sample, turn it back
+  // to the first
+  float turns = cycles_per_sample * (n - 1);
+  float phase = atan2f(sinf(omega) * s2, s1 - 0.5f * coeff * s2) -
+                two_pi * (turns - floorf(turns));
+  phase = remainderf(phase, two_pi);
+  // the Hann window halves the amplitude
+  return {power > 0.0f ? 4.0f * sqrtf(power) / n : 0.0f, phase};
+}
+
+inline float goertzel_amplitude(const int16_t* samples, size_t n, float mean,
+                                float cycles_per_sample) {
+  return goertzel(samples, n, mean, cycles_per_sample).amplitude;
+}
+
+inline float sample_mean(const int16_t* samples, size_t n) {
+  int32_t sum = 0;
+  for (size_t i = 0; i < n; i++) {
+    sum += samples[i];
+  }
+  return (float)sum / n;
+}
+
+}  // namespace sensesp
+
+#endif
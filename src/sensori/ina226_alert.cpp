@@ -0,0 +1,137 @@
+#include "sensori/ina226_alert.h"
+
+#include "sensesp.h"
+#include "system/latency_trace.h"
+
+// while an alert persists the chip asserts the pin again after every
+// conversion; don't spend the loop on reading it back more often than this
+#define ALERT_SERVICE_INTERVAL_MS 100
+
+namespace sensesp {
+
+INA226Alert::INA226Alert(INA226* pINA226, uint8_t pin,
+                         INA226AlertFunction function, float limit,
+                         uint32_t hold_ms, String config_path)
+    : FloatSensor(config_path),
+      pINA226{pINA226},
+      pin{pin},
+      function{function},
+      limit{limit},
+      hold_ms{hold_ms} {
+  load_configuration();
+}
+
+void INA226Alert::start() {
+  program();
+  started = true;
+
+  pinMode(pin, INPUT_PULLUP);
+  ReactESP::app->onInterrupt(pin, FALLING, [this]() {
+    if (!pending) {
+      pending_micros = micros();
+      pending = true;
+    }
+  });
+
+  ReactESP::app->onTick([this]() {
+    if (pending) {
+      if (!active || millis() - last_service_ms >= ALERT_SERVICE_INTERVAL_MS) {
+        service();
+      }
+    } else if (active && millis() - last_event_ms > hold_ms) {
+      active = false;
+      debugI("INA226 alert cleared");
+      LatencyChain chain;
+      this->emit(0.0);
+    }
+  });
+}
+
+// Writing the alert function rewrites the whole Mask/Enable register, so the
+// latch has to be set afterwards.
+void INA226Alert::program() {
+  switch (function) {
+    case INA226AlertFunction::bus_over:
+      pINA226->setBusVoltageLimit(limit);
+      pINA226->enableBusOvertLimitAlert();
+      break;
+    case INA226AlertFunction::bus_under:
+      pINA226->setBusVoltageLimit(limit);
+      pINA226->enableBusUnderLimitAlert();
+      break;
+    case INA226AlertFunction::shunt_over:
+      pINA226->setShuntVoltageLimit(limit);
+      pINA226->enableShuntOverLimitAlert();
+      break;
+    case INA226AlertFunction::shunt_under:
+      pINA226->setShuntVoltageLimit(limit);
+      pINA226->enableShuntUnderLimitAlert();
+      break;
+    case INA226AlertFunction::power_over:
+      pINA226->setPowerLimit(limit);
+      pINA226->enableOverPowerLimitAlert();
+      break;
+    default:
+      debugE("Invalid INA226 alert function %d", (int)function);
+      return;
+  }
+  pINA226->setAlertLatch(true);
+}
+
+void INA226Alert::service() {
+  unsigned long edge_micros = pending_micros;
+  // clear before reading, so an edge while we read is not lost
+  pending = false;
+  last_service_ms = millis();
+  uint16_t flags = pINA226->readAlertStatus();
+  if (!(flags & INA226_BIT_AFF)) {
+    return;  // released already, or not our comparator
+  }
+  cause = flags;
+  event_micros = edge_micros;
+  last_event_ms = last_service_ms;
+  if (!active) {
+    active = true;
+    debugW("INA226 alert, flags 0x%04x, %lu us after the edge", flags,
+           micros() - edge_micros);
+    LatencyChain chain(edge_micros);
+    this->emit(1.0);
+  }
+}
+
+void INA226Alert::get_configuration(JsonObject& root) {
+  root["function"] = (int)function;
+  root["limit"] = limit;
+  root["hold"] = hold_ms;
+  root["value"] = output;
+}
+
+static const char SCHEMA[] PROGMEM = R"###({
+    "type": "object",
+    "properties": {
+        "function": { "title": "Alert function", "type": "integer", "description": "0 = bus over voltage, 1 = bus under voltage, 2 = shunt over voltage, 3 = shunt under voltage, 4 = over power" },
+        "limit": { "title": "Limit", "type": "number", "description": "Volts, or watts for over power" },
+        "hold": { "title": "Hold time", "type": "integer", "description": "Time without a new alert before it is cleared, in milliseconds" },
+        "value": { "title": "Alert active", "type" : "number", "readOnly": true }
+    }
+  })###";
+
+String INA226Alert::get_config_schema() { return FPSTR(SCHEMA); }
+
+bool INA226Alert::set_configuration(const JsonObject& config) {
+  String expected[] = {"function", "limit", "hold"};
+  for (auto str : expected) {
+    if (!config.containsKey(str)) {
+      return false;
+    }
+  }
+  function = (INA226AlertFunction)(int)config["function"];
+  limit = config["limit"];
+  hold_ms = config["hold"];
+  if (started) {
+    program();
+  }
+  return true;
+}
+
+}  // namespace sensesp
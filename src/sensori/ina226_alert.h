@@ -0,0 +1,77 @@
+#ifndef _ina226_alert_H_
+#define _ina226_alert_H_
+
+#include <Arduino.h>
+#include <Wire.h>
+#include "sensori/INA226.h"
+
+#include "sensesp/sensors/sensor.h"
+#include "system/config_store.h"
+
+namespace sensesp {
+
+// The INA226 has a single alert limit register, so one comparator function
+// can be active at a time. The values match the order in the config schema.
+enum class INA226AlertFunction : uint8_t {
+  bus_over = 0,    // limit in volts
+  bus_under = 1,   // limit in volts
+  shunt_over = 2,  // limit in volts across the shunt
+  shunt_under = 3, // limit in volts across the shunt
+  power_over = 4   // limit in watts
+};
+
+/**
+ * @brief Alarm from the INA226's own comparator, through its ALERT pin
+ *
+ * The chip compares every conversion against the programmed limit, so a load
+ * dump spike that the 1 Hz INA226value readings would never see still trips
+ * the alert. The alert is latched in the chip; the interrupt handler only
+ * records the time, the Mask/Enable register is read from the main loop
+ * (I2C can't be used in an ISR) to confirm the cause and release the latch.
+ *
+ * Emits 1 as soon as an alert is serviced and 0 when no new alert has been
+ * seen for hold_ms. The ALERT pin is open drain and active low.
+ */
+class INA226Alert : public FloatSensor {
+ public:
+  INA226Alert(INA226* pINA226, uint8_t pin,
+              INA226AlertFunction function = INA226AlertFunction::bus_over,
+              float limit = 15.5, uint32_t hold_ms = 5000,
+              String config_path = "");
+  void start() override final;
+
+  /// Mask/Enable flags read for the last alert
+  uint16_t get_cause() const { return cause; }
+  /// micros() at the falling edge of the last alert
+  unsigned long get_event_micros() const { return event_micros; }
+
+ private:
+  INA226* pINA226;
+  uint8_t pin;
+  INA226AlertFunction function;
+  float limit;
+  uint32_t hold_ms;
+  bool started = false;
+
+  // written by the interrupt handler
+  volatile bool pending = false;
+  volatile unsigned long pending_micros = 0;
+
+  bool active = false;
+  uint16_t cause = 0;
+  unsigned long event_micros = 0;
+  unsigned long last_event_ms = 0;
+  unsigned long last_service_ms = 0;
+
+  void program();
+  void service();
+  virtual void load_configuration() override { ConfigStore::load(this); }
+  virtual void save_configuration() override { ConfigStore::save(this); }
+  virtual void get_configuration(JsonObject& root) override;
+  virtual bool set_configuration(const JsonObject& config) override;
+  virtual String get_config_schema() override;
+};
+
+}  // namespace sensesp
+
+#endif
@@ -1,6 +1,8 @@
 #include <Arduino.h>
 #include "sensori/ina226value.h"
 #include "sensesp_app.h"
+#include "system/latency_trace.h"
+#include "system/phase_scheduler.h"
 #include <HardwareSerial.h>
 
 namespace sensesp {
@@ -17,10 +19,16 @@ void INA226value::start() {
       read_delay_ = conversion_delay_ + 50;
     }
  */   
-  ReactESP::app->onRepeat(read_delay, [this]() { this->update(); });
+  task = PhaseScheduler::add("INA226value", read_delay, [this]() { this->update(); });
   
 }
 
+// Change the time between reads while running, e.g. for a power profile
+void INA226value::set_read_delay(uint read_delay) {
+  this->read_delay = read_delay;
+  PhaseScheduler::set_period(task, read_delay);
+}
+
 void INA226value::update() {
 
       double scale = 0.00001;  // i.e. round to nearest one-hundred-thousandth
@@ -50,6 +58,12 @@ void INA226value::update() {
         default: debugE("FATAL: invalid val_type parameter.");  
       }
       
+      // powered down between reads: start the conversion for the next one
+      if (pINA226->isTriggered()) {
+        pINA226->triggerConversion();
+      }
+
+      LatencyChain chain;
       this->emit(output);
 }
 
@@ -61,7 +75,7 @@ void INA226value::get_configuration(JsonObject& root) {
   static const char SCHEMA[] PROGMEM = R"###({
     "type": "object",
     "properties": {
-        "read_delay": { "title": "Read delay", "type": "number", "description": "The time, in milliseconds, between each read of the input" },
+        "read_delay": { "title": "Read delay", "type": "number", "description": "The time, in milliseconds, between each read of the input; set by the power profile", "readOnly": true },
         "value": { "title": "Last value", "type" : "number", "readOnly": true }
     }
   })###";
@@ -72,13 +86,8 @@ void INA226value::get_configuration(JsonObject& root) {
 }
 
 bool INA226value::set_configuration(const JsonObject& config) {
-  String expected[] = {"read_delay"};
-  for (auto str : expected) {
-    if (!config.containsKey(str)) {
-      return false;
-    }
-  }
-  read_delay = config["read_delay"];
+  // the read delay follows PowerManager's profile, which would overwrite
+  // a setting of its own at the next change of state
   return true;
 }
 }
\ No newline at end of file
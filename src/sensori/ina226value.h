@@ -6,6 +6,7 @@
 #include "sensori/INA226.h"
 
 #include "sensesp/sensors/sensor.h"
+#include "system/config_store.h"
 
 namespace sensesp {
 
@@ -26,13 +27,17 @@ class INA226value : public FloatSensor {
   public:
     INA226value(INA226* pINA226, INA226ValType val_type, uint read_delay = 500, String config_path="");
     void start() override final;
+    void set_read_delay(uint read_delay);
     INA226* pINA226;
 
   private:
     
     INA226ValType val_type;
     uint read_delay;
+    int task = -1;
     void update();
+    virtual void load_configuration() override { ConfigStore::load(this); }
+    virtual void save_configuration() override { ConfigStore::save(this); }
     virtual void get_configuration(JsonObject& root) override;
     virtual bool set_configuration(const JsonObject& config) override;
     virtual String get_config_schema() override;
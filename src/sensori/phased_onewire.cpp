@@ -0,0 +1,19 @@
+#include "phased_onewire.h"
+
+#include "system/phase_scheduler.h"
+
+namespace sensesp {
+
+PhasedOneWireTemperature::PhasedOneWireTemperature(
+    DallasTemperatureSensors* dts, uint read_delay, const char* name,
+    String config_path)
+    : OneWireTemperature(dts, read_delay, config_path),
+      name{name},
+      read_delay{read_delay} {}
+
+void PhasedOneWireTemperature::start() {
+  PhaseScheduler::add_started(name, read_delay, ONEWIRE_READ_COST_US,
+                              [this]() { OneWireTemperature::start(); });
+}
+
+}  // namespace sensesp
@@ -0,0 +1,31 @@
+#ifndef _phased_onewire_H_
+#define _phased_onewire_H_
+
+#include "sensesp_onewire/onewire_temperature.h"
+
+// what one sensor costs the loop per reading, as far as a DS18B20 on a shared
+// bus can be estimated: reset, match ROM and read the 9 byte scratchpad,
+// bit-banged at about 70 us per bit
+#define ONEWIRE_READ_COST_US 12000
+
+namespace sensesp {
+
+// OneWireTemperature, started at an offset of its own by PhaseScheduler
+//
+// The library starts every sensor's read reaction when SensESP starts, so all
+// of them convert together and read their scratchpads together 750 ms later.
+// Deferring each start to a slot of its own spreads both.
+class PhasedOneWireTemperature : public OneWireTemperature {
+ public:
+  PhasedOneWireTemperature(DallasTemperatureSensors* dts, uint read_delay,
+                           const char* name, String config_path = "");
+  virtual void start() override;
+
+ private:
+  const char* name;
+  uint read_delay;
+};
+
+}  // namespace sensesp
+
+#endif
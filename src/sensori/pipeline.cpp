@@ -0,0 +1,73 @@
+#include "sensori/pipeline.h"
+
+namespace sensesp {
+
+// FrequencyStage
+
+FrequencyStage::FrequencyStage(const Params& params)
+    : Configurable(params.config_path), multiplier{params.multiplier} {
+  load_configuration();
+  last_update = millis();
+}
+
+void FrequencyStage::get_configuration(JsonObject& root) {
+  root["multiplier"] = multiplier;
+}
+
+static const char FREQUENCY_SCHEMA[] PROGMEM = R"({
+    "type": "object",
+    "properties": {
+        "multiplier": { "title": "Multiplier", "type": "number" }
+    }
+  })";
+
+String FrequencyStage::get_config_schema() { return FPSTR(FREQUENCY_SCHEMA); }
+
+bool FrequencyStage::set_configuration(const JsonObject& config) {
+  String expected[] = {"multiplier"};
+  for (auto str : expected) {
+    if (!config.containsKey(str)) {
+      return false;
+    }
+  }
+  multiplier = config["multiplier"];
+  return true;
+}
+
+// LinearStage
+
+LinearStage::LinearStage(const Params& params)
+    : Configurable(params.config_path),
+      multiplier{params.multiplier},
+      offset{params.offset} {
+  load_configuration();
+}
+
+void LinearStage::get_configuration(JsonObject& root) {
+  root["multiplier"] = multiplier;
+  root["offset"] = offset;
+}
+
+static const char LINEAR_SCHEMA[] PROGMEM = R"({
+    "type": "object",
+    "properties": {
+        "multiplier": { "title": "Multiplier", "type": "number" },
+        "offset": { "title": "Constant offset", "type": "number" }
+    }
+  })";
+
+String LinearStage::get_config_schema() { return FPSTR(LINEAR_SCHEMA); }
+
+bool LinearStage::set_configuration(const JsonObject& config) {
+  String expected[] = {"multiplier", "offset"};
+  for (auto str : expected) {
+    if (!config.containsKey(str)) {
+      return false;
+    }
+  }
+  multiplier = config["multiplier"];
+  offset = config["offset"];
+  return true;
+}
+
+}  // namespace sensesp
@@ -0,0 +1,101 @@
+#ifndef _pipeline_H_
+#define _pipeline_H_
+
+#include "sensesp/system/configurable.h"
+#include "sensesp/transforms/transform.h"
+#include "sensori/stage_chain.h"
+#include "system/config_store.h"
+
+namespace sensesp {
+
+/**
+ * @brief A pipeline that consumes In values and emits the fused result
+ *
+ * Replaces a chain of separately allocated transforms, e.g.
+ *
+ *   dic->connect_to(new Frequency(k))->connect_to(new LambdaConsumer<float>(f));
+ *
+ * with one object and one virtual call at the entry:
+ *
+ *   dic->connect_to(new Pipe<int, FrequencyStage, Tap<f>>(FrequencyStage::Params{k}));
+ *
+ * The pipe itself is a Transform, so regular consumers such as SKOutput can
+ * still be connected to the end of it. The pipe has no configuration of its
+ * own; configurable stages (FrequencyStage, LinearStage) keep their own config
+ * path and show up in the web UI as before.
+ */
+template <typename In, typename... Stages>
+class Pipe : public Transform<In, float> {
+ public:
+  template <typename... Args>
+  explicit Pipe(Args&&... args)
+      : Transform<In, float>(""), chain(std::forward<Args>(args)...) {}
+
+  virtual void set_input(In input, uint8_t input_channel = 0) override {
+    this->emit(chain((float)input));
+  }
+
+ private:
+  StageChain<Stages...> chain;
+};
+
+/**
+ * @brief Pipe stage converting a pulse count into a frequency
+ *
+ * Same calculation and same configuration as the Frequency transform, so an
+ * existing Frequency config path (and its saved multiplier) can be reused.
+ */
+class FrequencyStage : public Configurable {
+ public:
+  struct Params {
+    float multiplier;
+    String config_path;
+  };
+
+  explicit FrequencyStage(const Params& params);
+
+  float operator()(float count) {
+    unsigned long now = millis();
+    unsigned long elapsed = now - last_update;
+    last_update = now;
+    return elapsed == 0 ? 0.0f : multiplier * 1000.0f * count / elapsed;
+  }
+
+  virtual void load_configuration() override { ConfigStore::load(this); }
+  virtual void save_configuration() override { ConfigStore::save(this); }
+  virtual void get_configuration(JsonObject& doc) override;
+  virtual bool set_configuration(const JsonObject& config) override;
+  virtual String get_config_schema() override;
+
+ private:
+  float multiplier;
+  unsigned long last_update = 0;
+};
+
+/// Pipe stage computing y = multiplier * x + offset, configurable like Linear
+class LinearStage : public Configurable {
+ public:
+  struct Params {
+    float multiplier;
+    float offset;
+    String config_path;
+  };
+
+  explicit LinearStage(const Params& params);
+
+  float operator()(float value) const { return multiplier * value + offset; }
+
+  virtual void load_configuration() override { ConfigStore::load(this); }
+  virtual void save_configuration() override { ConfigStore::save(this); }
+  virtual void get_configuration(JsonObject& doc) override;
+  virtual bool set_configuration(const JsonObject& config) override;
+  virtual String get_config_schema() override;
+
+ private:
+  float multiplier;
+  float offset;
+};
+
+}  // namespace sensesp
+
+#endif
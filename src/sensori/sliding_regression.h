@@ -0,0 +1,129 @@
+#ifndef _sliding_regression_H_
+#define _sliding_regression_H_
+
+#include <math.h>
+#include <stdint.h>
+
+// largest regression window, in samples
+#define TREND_WINDOW_MAX 128
+
+namespace sensesp {
+
+/**
+ * @brief Least squares line through the last N (time, value) samples
+ *
+ * Keeps the sums of x, y, x^2 and xy, so adding a sample and dropping the
+ * oldest costs O(1). Times are kept relative to the oldest sample and values
+ * relative to the first one; after each full turn of the window both are
+ * rebased and the sums recomputed from the samples, which keeps the
+ * precision and stops rounding errors from building up. Times are
+ * millis(), and may wrap.
+ *
+ * No Arduino dependency, so it can be tested on a host.
+ */
+class SlidingRegression {
+ public:
+  explicit SlidingRegression(uint8_t window = TREND_WINDOW_MAX) {
+    resize(window);
+  }
+
+  /// Start over with another window length, 2 to TREND_WINDOW_MAX
+  void resize(uint8_t window) {
+    this->window = window < 2                  ? 2
+                   : window > TREND_WINDOW_MAX ? TREND_WINDOW_MAX
+                                               : window;
+    n = 0;
+    next = 0;
+    sx = sy = sxx = sxy = 0;
+  }
+
+  void add(uint32_t time_ms, float value) {
+    if (n == 0) {
+      base_ms = time_ms;
+      base_value = value;
+    }
+    if (n == window) {
+      // the oldest sample leaves the window
+      float ox = x[next];
+      float oy = y[next];
+      sx -= ox;
+      sy -= oy;
+      sxx -= (double)ox * ox;
+      sxy -= (double)ox * oy;
+      n--;
+    }
+    float nx = (time_ms - base_ms) / 1000.0f;
+    float ny = value - base_value;
+    x[next] = nx;
+    y[next] = ny;
+    sx += nx;
+    sy += ny;
+    sxx += (double)nx * nx;
+    sxy += (double)nx * ny;
+    n++;
+
+    next = (next + 1) % window;
+    if (next == 0) {
+      recompute();
+    }
+  }
+
+  uint8_t count() const { return n; }
+
+  /// Slope of the line, in value units per second
+  float slope() const {
+    if (n < 2) {
+      return 0;
+    }
+    double spread = sxx - sx * sx / n;
+    if (spread <= 0) {
+      return 0;
+    }
+    return (sxy - sx * sy / n) / spread;
+  }
+
+  /// The line's value at time_ms
+  float fitted(uint32_t time_ms) const {
+    if (n == 0) {
+      return NAN;
+    }
+    float at = (int32_t)(time_ms - base_ms) / 1000.0f;
+    return base_value + sy / n + slope() * (at - sx / n);
+  }
+
+ private:
+  uint8_t window;
+  uint8_t n = 0;
+  uint8_t next = 0;  // slot of the next sample
+  uint32_t base_ms = 0;
+  float base_value = 0;
+  float x[TREND_WINDOW_MAX];  // seconds since base_ms
+  float y[TREND_WINDOW_MAX];  // value - base_value
+  double sx = 0, sy = 0, sxx = 0, sxy = 0;
+
+  // Rebase on the oldest sample and sum again, once per turn of the window
+  void recompute() {
+    // with the window full, the oldest sample is in the next slot
+    uint8_t oldest = n == window ? next : 0;
+    // a whole number of milliseconds, so base_ms moves exactly as far as
+    // the times do
+    uint32_t shift_ms = (uint32_t)lroundf(x[oldest] * 1000.0f);
+    float shift_x = shift_ms / 1000.0f;
+    float shift_y = y[oldest];
+    base_ms += shift_ms;
+    base_value += shift_y;
+    sx = sy = sxx = sxy = 0;
+    for (uint8_t i = 0; i < n; i++) {
+      x[i] -= shift_x;
+      y[i] -= shift_y;
+      sx += x[i];
+      sy += y[i];
+      sxx += (double)x[i] * x[i];
+      sxy += (double)x[i] * y[i];
+    }
+  }
+};
+
+}  // namespace sensesp
+
+#endif
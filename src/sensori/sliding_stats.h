@@ -0,0 +1,143 @@
+#ifndef _sliding_stats_H_
+#define _sliding_stats_H_
+
+#include <math.h>
+#include <stdint.h>
+
+// largest window, in samples
+#define WINDOW_STATS_MAX 64
+
+namespace sensesp {
+
+/**
+ * @brief Minimum, maximum, mean and standard deviation of the last N samples
+ *
+ * Every add() costs O(1), in a fixed amount of memory:
+ *
+ *  - mean and variance with Welford's update, and its inverse for the sample
+ *    that leaves the window; after each full turn of the window both are
+ *    recomputed from the samples, so rounding errors can't build up
+ *  - minimum and maximum with a monotonic deque each: the candidates in
+ *    window order, every one smaller (larger) than the ones before it, so the
+ *    front is the extreme and a sample is pushed and popped at most once
+ *
+ * No Arduino dependency, so it can be tested on a host.
+ */
+class SlidingStats {
+ public:
+  explicit SlidingStats(uint8_t window = WINDOW_STATS_MAX) { resize(window); }
+
+  /// Start over with another window length, 1 to WINDOW_STATS_MAX
+  void resize(uint8_t window) {
+    this->window = window < 1                  ? 1
+                   : window > WINDOW_STATS_MAX ? WINDOW_STATS_MAX
+                                               : window;
+    n = 0;
+    seq = 0;
+    mean_value = 0;
+    m2 = 0;
+    min_deque.clear();
+    max_deque.clear();
+  }
+
+  void add(float value) {
+    uint8_t slot = seq % window;
+    if (n == window) {
+      // the oldest sample leaves the window: Welford in reverse
+      float old = samples[slot];
+      if (n == 1) {
+        mean_value = 0;
+        m2 = 0;
+      } else {
+        double old_mean = mean_value;
+        mean_value = (n * mean_value - old) / (n - 1);
+        m2 -= (old - old_mean) * (old - mean_value);
+      }
+      n--;
+    }
+    samples[slot] = value;
+    n++;
+    double delta = value - mean_value;
+    mean_value += delta / n;
+    m2 += delta * (value - mean_value);
+
+    // drop the candidates that have left the window, then those the new
+    // sample beats
+    uint32_t oldest = seq + 1 - n;
+    while (!min_deque.empty() && (int32_t)(min_deque.front() - oldest) < 0) {
+      min_deque.pop_front();
+    }
+    while (!max_deque.empty() && (int32_t)(max_deque.front() - oldest) < 0) {
+      max_deque.pop_front();
+    }
+    while (!min_deque.empty() && samples[min_deque.back() % window] >= value) {
+      min_deque.pop_back();
+    }
+    while (!max_deque.empty() && samples[max_deque.back() % window] <= value) {
+      max_deque.pop_back();
+    }
+    min_deque.push_back(seq);
+    max_deque.push_back(seq);
+
+    if (++seq % window == 0) {
+      recompute();
+    }
+  }
+
+  uint8_t count() const { return n; }
+  float minimum() const { return samples[min_deque.front() % window]; }
+  float maximum() const { return samples[max_deque.front() % window]; }
+  float mean() const { return mean_value; }
+
+  float stddev() const {
+    if (n < 2 || m2 <= 0) {
+      return 0;
+    }
+    return sqrt(m2 / (n - 1));
+  }
+
+ private:
+  /// Ring of sample sequence numbers, oldest at the front
+  class Deque {
+   public:
+    void clear() { head = tail = 0; }
+    bool empty() const { return head == tail; }
+    uint32_t front() const { return seqs[head % WINDOW_STATS_MAX]; }
+    uint32_t back() const { return seqs[(tail - 1) % WINDOW_STATS_MAX]; }
+    void push_back(uint32_t seq) { seqs[tail++ % WINDOW_STATS_MAX] = seq; }
+    void pop_front() { head++; }
+    void pop_back() { tail--; }
+
+   private:
+    uint32_t seqs[WINDOW_STATS_MAX];
+    uint32_t head = 0;
+    uint32_t tail = 0;
+  };
+
+  uint8_t window;
+  uint8_t n = 0;
+  uint32_t seq = 0;  // sequence number of the next sample
+  float samples[WINDOW_STATS_MAX];
+  double mean_value = 0;
+  double m2 = 0;  // sum of squared differences from the mean
+  Deque min_deque;
+  Deque max_deque;
+
+  // Two passes over the samples, once per turn of the window
+  void recompute() {
+    double sum = 0;
+    for (uint8_t i = 0; i < n; i++) {
+      sum += samples[i];
+    }
+    mean_value = sum / n;
+    m2 = 0;
+    for (uint8_t i = 0; i < n; i++) {
+      double delta = samples[i] - mean_value;
+      m2 += delta * delta;
+    }
+  }
+};
+
+}  // namespace sensesp
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef _stage_chain_H_
+#define _stage_chain_H_
+
+#include <utility>
+
+namespace sensesp {
+
+/**
+ * @brief A chain of stages fused into one function object
+ *
+ * A stage is any type with a non-virtual `float operator()(float)`. The chain
+ * holds the stages by value and calls them directly, so the compiler inlines
+ * the whole chain: no observer lists, no virtual calls and no allocation
+ * between stages.
+ *
+ * The constructor arguments are forwarded to the stages in order, one
+ * argument per stage; stages without an argument are default constructed.
+ *
+ * No Arduino dependency, so it can be tested on a host.
+ */
+template <typename... Stages>
+class StageChain;
+
+template <>
+class StageChain<> {
+ public:
+  float operator()(float value) { return value; }
+};
+
+template <typename First, typename... Rest>
+class StageChain<First, Rest...> {
+ public:
+  StageChain() = default;
+
+  template <typename Arg, typename... Args>
+  explicit StageChain(Arg&& arg, Args&&... args)
+      : first(std::forward<Arg>(arg)), rest(std::forward<Args>(args)...) {}
+
+  float operator()(float value) { return rest(first(value)); }
+
+ private:
+  First first;
+  StageChain<Rest...> rest;
+};
+
+/// Pass the value to a free function, e.g. a display or N2K update, and on
+/// down the pipe. The function is a template argument so it can be inlined.
+template <void (*Func)(float)>
+class Tap {
+ public:
+  float operator()(float value) const {
+    Func(value);
+    return value;
+  }
+};
+
+}  // namespace sensesp
+
+#endif
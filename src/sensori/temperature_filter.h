@@ -0,0 +1,145 @@
+#ifndef _temperature_filter_H_
+#define _temperature_filter_H_
+
+#include <math.h>
+#include <stdint.h>
+
+// what the DS18B20 reads before its first conversion, and on a failed read
+#define DS18B20_POWER_ON_K 358.15f
+#define DS18B20_ERROR_K 146.15f
+// rejected readings in a row, at one level or along one slope, that make a
+// new level
+#define TREND_NEW_LEVEL 3
+
+namespace sensesp {
+
+/**
+ * @brief Keeps DS18B20 glitches out of a temperature trend
+ *
+ * A reading is accepted when it lies within max_jump of the last accepted
+ * one, carried forward along the trend's slope to the reading's time. That
+ * rejects:
+ *
+ *  - -127 °C, what DallasTemperature reports for a failed CRC or a sensor
+ *    that doesn't answer
+ *  - 85 °C, the power-on value of the scratchpad, unless the previous
+ *    accepted reading was close to it already
+ *  - a jump of more than max_jump from where the trend was heading
+ *
+ * A jump is a glitch unless the readings after it carry on from it: each one
+ * within max_jump of the previous rejected reading, or of where the rejected
+ * readings so far are heading. TREND_NEW_LEVEL of them in a row are accepted
+ * as a new level, or a new slope, e.g. the exhaust heating up by several
+ * degrees per reading when the raw water fails. The owner should then start
+ * the trend over from the run, see new_level().
+ *
+ * No Arduino dependency, so it can be tested on a host.
+ */
+class TemperatureFilter {
+ public:
+  explicit TemperatureFilter(float max_jump = 5.0f) : max_jump{max_jump} {}
+
+  float max_jump;
+
+  /// Forget everything, the next reading is taken as it comes
+  void reset() {
+    last_value = NAN;
+    run_count = 0;
+    started = false;
+  }
+
+  /// Whether the reading at time_ms is real; slope is the trend so far, in K
+  /// per second
+  bool accept(uint32_t time_ms, float temperature, float slope) {
+    started = false;
+    // a sub-zero reading is real, e.g. the alternator on a winter morning
+    if (near(temperature, DS18B20_ERROR_K)) {
+      return false;
+    }
+    if (isnan(last_value)) {
+      if (near(temperature, DS18B20_POWER_ON_K)) {
+        return false;
+      }
+      return take(time_ms, temperature);
+    }
+    float expected =
+        last_value + slope * (int32_t)(time_ms - last_ms) / 1000.0f;
+    if (fabsf(temperature - expected) <= max_jump) {
+      return take(time_ms, temperature);
+    }
+
+    // a jump: a glitch, unless the next readings carry on from it
+    if (run_count == 0 || !continues(time_ms, temperature)) {
+      run_count = 0;
+    }
+    if (run_count < TREND_NEW_LEVEL) {
+      run_ms[run_count] = time_ms;
+      run_values[run_count] = temperature;
+      run_count++;
+    } else {
+      // at the power-on value: keep the run, drop its oldest reading
+      for (uint8_t i = 1; i < TREND_NEW_LEVEL; i++) {
+        run_ms[i - 1] = run_ms[i];
+        run_values[i - 1] = run_values[i];
+      }
+      run_ms[TREND_NEW_LEVEL - 1] = time_ms;
+      run_values[TREND_NEW_LEVEL - 1] = temperature;
+    }
+    if (run_count < TREND_NEW_LEVEL ||
+        near(temperature, DS18B20_POWER_ON_K)) {
+      return false;
+    }
+    take(time_ms, temperature);
+    started = true;
+    return true;
+  }
+
+  /// The last accepted reading made a new level: the trend should start
+  /// over from run_length() readings of the run before it, then this one
+  bool new_level() const { return started; }
+  uint8_t run_length() const { return started ? TREND_NEW_LEVEL - 1 : 0; }
+  uint32_t run_time(uint8_t i) const { return run_ms[i]; }
+  float run_value(uint8_t i) const { return run_values[i]; }
+
+ private:
+  float last_value = NAN;
+  uint32_t last_ms = 0;
+  uint32_t run_ms[TREND_NEW_LEVEL];
+  float run_values[TREND_NEW_LEVEL];
+  uint8_t run_count = 0;  // rejected readings in a row that agree
+  bool started = false;
+
+  static bool near(float temperature, float value) {
+    return fabsf(temperature - value) < 0.01f;
+  }
+
+  bool take(uint32_t time_ms, float temperature) {
+    last_value = temperature;
+    last_ms = time_ms;
+    run_count = 0;
+    return true;
+  }
+
+  // At the level of the last rejected reading, or on the line through the
+  // last two: the last rejected and the one before, or, for the second
+  // reading of a run, the last accepted
+  bool continues(uint32_t time_ms, float temperature) const {
+    uint32_t b_ms = run_ms[run_count - 1];
+    float b = run_values[run_count - 1];
+    if (fabsf(temperature - b) <= max_jump) {
+      return true;
+    }
+    uint32_t a_ms = run_count >= 2 ? run_ms[run_count - 2] : last_ms;
+    float a = run_count >= 2 ? run_values[run_count - 2] : last_value;
+    int32_t span = (int32_t)(b_ms - a_ms);
+    if (span <= 0) {
+      return false;
+    }
+    float heading = b + (b - a) * (int32_t)(time_ms - b_ms) / span;
+    return fabsf(temperature - heading) <= max_jump;
+  }
+};
+
+}  // namespace sensesp
+
+#endif
@@ -0,0 +1,77 @@
+#include "sensori/temperature_trend.h"
+
+namespace sensesp {
+
+TemperatureTrend::TemperatureTrend(std::function<float()> limit,
+                                   uint8_t window, float max_jump,
+                                   String config_path)
+    : FloatTransform(config_path),
+      limit{limit},
+      window{window},
+      filter{max_jump} {
+  load_configuration();
+  regression.resize(this->window);
+}
+
+void TemperatureTrend::set_input(float input, uint8_t input_channel) {
+  uint32_t now = millis();
+  if (!filter.accept(now, input, regression.slope())) {
+    rejected++;
+    return;
+  }
+  if (filter.new_level()) {
+    regression.resize(window);
+    for (uint8_t i = 0; i < filter.run_length(); i++) {
+      regression.add(filter.run_time(i), filter.run_value(i));
+    }
+  }
+  regression.add(now, input);
+  if (regression.count() < TREND_MIN_SAMPLES) {
+    return;
+  }
+
+  float slope = regression.slope();
+  float current = regression.fitted(now);
+  float limit = this->limit();
+  float seconds = TREND_HORIZON_S;
+  if (current >= limit) {
+    seconds = 0;
+  } else if (slope > 0) {
+    seconds = min((limit - current) / slope, TREND_HORIZON_S);
+  }
+  this->emit(slope);
+  time_to_limit_value.set(seconds);
+}
+
+void TemperatureTrend::get_configuration(JsonObject& root) {
+  root["window"] = window;
+  root["max_jump"] = filter.max_jump;
+  root["rejected"] = rejected;
+}
+
+static const char SCHEMA[] PROGMEM = R"###({
+    "type": "object",
+    "properties": {
+        "window": { "title": "Window", "type": "integer", "minimum": 2, "maximum": 128, "description": "Samples the trend is fitted over" },
+        "max_jump": { "title": "Maximum jump", "type": "number", "description": "Larger changes between samples are glitches unless they persist, in Kelvin" },
+        "rejected": { "title": "Samples rejected", "type": "integer", "readOnly": true }
+    }
+  })###";
+
+String TemperatureTrend::get_config_schema() { return FPSTR(SCHEMA); }
+
+bool TemperatureTrend::set_configuration(const JsonObject& config) {
+  String expected[] = {"window", "max_jump"};
+  for (auto str : expected) {
+    if (!config.containsKey(str)) {
+      return false;
+    }
+  }
+  window = constrain((int)config["window"], 2, TREND_WINDOW_MAX);
+  filter.max_jump = config["max_jump"];
+  filter.reset();
+  regression.resize(window);
+  return true;
+}
+
+}  // namespace sensesp
@@ -0,0 +1,64 @@
+#ifndef _temperature_trend_H_
+#define _temperature_trend_H_
+
+#include <Arduino.h>
+
+#include <functional>
+
+#include "sensesp/system/observablevalue.h"
+#include "sensesp/transforms/transform.h"
+#include "sensori/sliding_regression.h"
+#include "sensori/temperature_filter.h"
+#include "system/config_store.h"
+
+// samples needed before a trend is emitted
+#define TREND_MIN_SAMPLES 10
+// time to limit reported when the limit is further away, or not approached
+#define TREND_HORIZON_S 3600.0f
+
+namespace sensesp {
+
+/**
+ * @brief Temperature rate of change and time to a limit, for early warnings
+ *
+ * Input is a temperature in Kelvin, from a 1-Wire sensor. The output is the
+ * slope of a sliding linear regression over the last `window` samples, in
+ * K/s; time_to_limit() emits, with every slope, how long the fitted line takes
+ * to reach `limit`: 0 when it is already there and TREND_HORIZON_S when it is
+ * further away than that or not getting closer. The limit comes from the
+ * owner, e.g. the channel's alarm threshold, and is read with every sample,
+ * so a threshold changed in the web UI counts at once.
+ *
+ * DS18B20 glitches are kept out of the regression by a TemperatureFilter.
+ * When it accepts a new level or a new slope, the regression starts over
+ * from the readings that made it, so the trend follows a fast rise at once.
+ */
+class TemperatureTrend : public FloatTransform {
+ public:
+  TemperatureTrend(std::function<float()> limit, uint8_t window = 120,
+                   float max_jump = 5.0, String config_path = "");
+
+  virtual void set_input(float input, uint8_t input_channel = 0) override;
+
+  /// Seconds until the limit is reached at the current trend
+  ObservableValue<float>& time_to_limit() { return time_to_limit_value; }
+
+  virtual void load_configuration() override { ConfigStore::load(this); }
+  virtual void save_configuration() override { ConfigStore::save(this); }
+  virtual void get_configuration(JsonObject& root) override;
+  virtual bool set_configuration(const JsonObject& config) override;
+  virtual String get_config_schema() override;
+
+ private:
+  std::function<float()> limit;
+  uint8_t window;
+  uint32_t rejected = 0;
+
+  TemperatureFilter filter;
+  SlidingRegression regression;
+  ObservableValue<float> time_to_limit_value;
+};
+
+}  // namespace sensesp
+
+#endif
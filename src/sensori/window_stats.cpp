@@ -0,0 +1,53 @@
+#include "sensori/window_stats.h"
+
+namespace sensesp {
+
+WindowStats::WindowStats(uint8_t window, uint8_t every, String config_path)
+    : Transform<float, String>(config_path), window{window}, every{every} {
+  load_configuration();
+  stats.resize(this->window);
+}
+
+void WindowStats::set_input(float input, uint8_t input_channel) {
+  stats.add(input);
+  if (++since_emit < every) {
+    return;
+  }
+  since_emit = 0;
+  char json[128];
+  snprintf(json, sizeof(json),
+           "{\"min\":%g,\"max\":%g,\"mean\":%g,\"stddev\":%g,\"n\":%u}",
+           stats.minimum(), stats.maximum(), stats.mean(), stats.stddev(),
+           stats.count());
+  this->emit(json);
+}
+
+void WindowStats::get_configuration(JsonObject& root) {
+  root["window"] = window;
+  root["every"] = every;
+}
+
+static const char SCHEMA[] PROGMEM = R"###({
+    "type": "object",
+    "properties": {
+        "window": { "title": "Window", "type": "integer", "minimum": 1, "maximum": 64, "description": "Samples the statistics cover" },
+        "every": { "title": "Output every", "type": "integer", "minimum": 1, "description": "Samples between two summaries" }
+    }
+  })###";
+
+String WindowStats::get_config_schema() { return FPSTR(SCHEMA); }
+
+bool WindowStats::set_configuration(const JsonObject& config) {
+  String expected[] = {"window", "every"};
+  for (auto str : expected) {
+    if (!config.containsKey(str)) {
+      return false;
+    }
+  }
+  window = constrain((int)config["window"], 1, WINDOW_STATS_MAX);
+  every = max((int)config["every"], 1);
+  stats.resize(window);
+  return true;
+}
+
+}  // namespace sensesp
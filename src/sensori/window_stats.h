@@ -0,0 +1,45 @@
+#ifndef _window_stats_H_
+#define _window_stats_H_
+
+#include <Arduino.h>
+
+#include "sensesp/transforms/transform.h"
+#include "sensori/sliding_stats.h"
+#include "system/config_store.h"
+
+namespace sensesp {
+
+/**
+ * @brief Summarise a channel over a sliding window, as a Signal K object
+ *
+ * Every `every` samples, emits the statistics of the last `window` samples as
+ * a JSON object for SKOutputRawJson:
+ *
+ *   {"min":351.2,"max":355.9,"mean":353.4,"stddev":1.2,"n":60}
+ *
+ * Sending the summary instead of every sample cuts the Signal K message rate
+ * by `every` without losing the extremes. A window change through the web UI
+ * starts the statistics over.
+ */
+class WindowStats : public Transform<float, String> {
+ public:
+  WindowStats(uint8_t window = 60, uint8_t every = 10, String config_path = "");
+
+  virtual void set_input(float input, uint8_t input_channel = 0) override;
+
+  virtual void load_configuration() override { ConfigStore::load(this); }
+  virtual void save_configuration() override { ConfigStore::save(this); }
+  virtual void get_configuration(JsonObject& root) override;
+  virtual bool set_configuration(const JsonObject& config) override;
+  virtual String get_config_schema() override;
+
+ private:
+  uint8_t window;
+  uint8_t every;
+  uint8_t since_emit = 0;
+  SlidingStats stats;
+};
+
+}  // namespace sensesp
+
+#endif
@@ -0,0 +1,78 @@
+#ifdef ALLOC_WATCH
+
+#include "system/alloc_watch.h"
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "sensesp.h"
+
+namespace sensesp {
+
+volatile bool AllocWatch::armed = false;
+void* AllocWatch::loop_task = nullptr;
+volatile uint32_t AllocWatch::loop_count = 0;
+volatile uint32_t AllocWatch::loop_bytes = 0;
+volatile uint32_t AllocWatch::other_count = 0;
+void* volatile AllocWatch::last_loop_caller = nullptr;
+volatile uint32_t AllocWatch::last_loop_size = 0;
+
+void AllocWatch::arm() {
+  loop_task = xTaskGetCurrentTaskHandle();
+  armed = true;
+}
+
+void AllocWatch::report() {
+  // logging allocates too, don't count that
+  armed = false;
+  if (loop_count == 0) {
+    debugI("AllocWatch: no allocations in the loop task, %u in other tasks",
+           other_count);
+  } else {
+    debugW("AllocWatch: %u allocations (%u bytes) in the loop task, last one %u "
+           "bytes from %p; %u in other tasks",
+           loop_count, loop_bytes, last_loop_size, last_loop_caller,
+           other_count);
+  }
+  armed = true;
+}
+
+static inline void count_allocation(size_t size, void* caller) {
+  if (!AllocWatch::armed) {
+    return;
+  }
+  if (xTaskGetCurrentTaskHandle() == AllocWatch::loop_task) {
+    AllocWatch::loop_count = AllocWatch::loop_count + 1;
+    AllocWatch::loop_bytes = AllocWatch::loop_bytes + size;
+    AllocWatch::last_loop_caller = caller;
+    AllocWatch::last_loop_size = size;
+  } else {
+    AllocWatch::other_count = AllocWatch::other_count + 1;
+  }
+}
+
+}  // namespace sensesp
+
+extern "C" {
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+
+void* __wrap_malloc(size_t size) {
+  sensesp::count_allocation(size, __builtin_return_address(0));
+  return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+  sensesp::count_allocation(count * size, __builtin_return_address(0));
+  return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+  sensesp::count_allocation(size, __builtin_return_address(0));
+  return __real_realloc(ptr, size);
+}
+
+}  // extern "C"
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef _alloc_watch_H_
+#define _alloc_watch_H_
+
+#include <Arduino.h>
+
+namespace sensesp {
+
+/**
+ * @brief Debug-build counter of heap allocations made after startup
+ *
+ * Only compiled in with -D ALLOC_WATCH, together with the linker options
+ * -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc (see the esp32dev_alloc_watch
+ * environment in platformio.ini). Every allocation made after arm() is
+ * counted; allocations made from the Arduino loop task, where all sensor
+ * callbacks run, are counted separately, together with the return address of
+ * the most recent one. Decode that address with addr2line or the
+ * esp32_exception_decoder to find the offending call site.
+ */
+class AllocWatch {
+ public:
+  static void arm();
+  static void report();
+
+  static volatile bool armed;
+  static void* loop_task;
+  static volatile uint32_t loop_count;
+  static volatile uint32_t loop_bytes;
+  static volatile uint32_t other_count;
+  static void* volatile last_loop_caller;
+  static volatile uint32_t last_loop_size;
+};
+
+}  // namespace sensesp
+
+#endif
@@ -0,0 +1,56 @@
+#include "system/boot_arena.h"
+
+#include "sensesp.h"
+
+namespace sensesp {
+
+static const char* const SUBSYSTEM_NAMES[] = {"n2k",        "io",
+                                              "sensors",    "transforms",
+                                              "signalk",    "consumers"};
+
+alignas(8) static uint8_t arena[BOOT_ARENA_SIZE];
+
+size_t BootArena::used = 0;
+size_t BootArena::overflow = 0;
+size_t BootArena::subsystem_bytes[(size_t)Subsystem::count] = {};
+uint16_t BootArena::subsystem_objects[(size_t)Subsystem::count] = {};
+
+void* BootArena::allocate(size_t size, size_t alignment, Subsystem subsystem) {
+  size_t start = (used + alignment - 1) & ~(alignment - 1);
+  subsystem_bytes[(size_t)subsystem] += size;
+  subsystem_objects[(size_t)subsystem]++;
+
+  if (start + size > BOOT_ARENA_SIZE) {
+    overflow += size;
+    debugW("Boot arena full, %u bytes for %s taken from the heap", size,
+           SUBSYSTEM_NAMES[(size_t)subsystem]);
+    return ::operator new(size);
+  }
+  used = start + size;
+  return &arena[start];
+}
+
+void BootArena::report() {
+  for (size_t i = 0; i < (size_t)Subsystem::count; i++) {
+    debugI("Arena: %-10s %3u objects %6u bytes", SUBSYSTEM_NAMES[i],
+           subsystem_objects[i], subsystem_bytes[i]);
+  }
+  debugI("Arena: %u of %u bytes used, %u bytes overflowed to the heap", used,
+         (size_t)BOOT_ARENA_SIZE, overflow);
+  debugI("Heap: %u bytes free, %u bytes low water mark, largest block %u bytes",
+         ESP.getFreeHeap(), ESP.getMinFreeHeap(), ESP.getMaxAllocHeap());
+}
+
+bool BootArena::check_heap_floor(uint32_t floor_bytes) {
+  uint32_t free_heap = ESP.getFreeHeap();
+  if (free_heap >= floor_bytes) {
+    return true;
+  }
+  // halting here would only boot-loop the board; log it and let the caller
+  // leave the optional features off and raise it where it will be seen
+  debugE("Free heap %u bytes is below the floor of %u bytes", free_heap,
+         floor_bytes);
+  return false;
+}
+
+}  // namespace sensesp
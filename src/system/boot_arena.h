@@ -0,0 +1,71 @@
+#ifndef _boot_arena_H_
+#define _boot_arena_H_
+
+#include <Arduino.h>
+#include <new>
+#include <utility>
+
+// Size of the arena holding all long-lived objects created in setup(). The
+// boot report shows how much of it is actually used; override with
+// -D BOOT_ARENA_SIZE=... in platformio.ini if the graph grows.
+#ifndef BOOT_ARENA_SIZE
+#define BOOT_ARENA_SIZE (24 * 1024)
+#endif
+
+// Free heap required once setup() has finished, so WiFi and TLS still find
+// large enough blocks. Override with -D HEAP_FLOOR_BYTES=...
+#ifndef HEAP_FLOOR_BYTES
+#define HEAP_FLOOR_BYTES (48 * 1024)
+#endif
+
+namespace sensesp {
+
+/// What an arena allocation belongs to, for the boot report
+enum class Subsystem : uint8_t {
+  n2k,         // NMEA 2000 node
+  io,          // buses and chip drivers: I2C, OLED, 1-Wire, INA226
+  sensors,     // SensESP sensors
+  transforms,  // transforms and pipes
+  signalk,     // SK outputs and their metadata
+  consumers,   // display and N2K consumers
+  count
+};
+
+/**
+ * @brief Bump allocator for the objects that live as long as the device runs
+ *
+ * Everything created in setup() is placed one after the other in a statically
+ * sized buffer instead of on the heap, so the sensor graph can no longer
+ * fragment the heap before WiFi and TLS need their large blocks. Objects
+ * made here are never destroyed.
+ *
+ * Should the arena run out, make() falls back to the heap and counts the
+ * overflow, which shows up in report().
+ */
+class BootArena {
+ public:
+  template <typename T, typename... Args>
+  static T* make(Subsystem subsystem, Args&&... args) {
+    void* memory = allocate(sizeof(T), alignof(T), subsystem);
+    return new (memory) T(std::forward<Args>(args)...);
+  }
+
+  static void* allocate(size_t size, size_t alignment, Subsystem subsystem);
+
+  /// Log the bytes used per subsystem and the state of the heap
+  static void report();
+
+  /// Whether the free heap is at least floor_bytes; logs an error if not,
+  /// report() has the details
+  static bool check_heap_floor(uint32_t floor_bytes = HEAP_FLOOR_BYTES);
+
+ private:
+  static size_t used;
+  static size_t overflow;
+  static size_t subsystem_bytes[(size_t)Subsystem::count];
+  static uint16_t subsystem_objects[(size_t)Subsystem::count];
+};
+
+}  // namespace sensesp
+
+#endif
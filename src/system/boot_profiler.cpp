@@ -0,0 +1,36 @@
+#include "system/boot_profiler.h"
+
+#include <esp_timer.h>
+#include "sensesp.h"
+
+namespace sensesp {
+
+static const char* const MILESTONE_NAMES[] = {
+    "N2K open",      "local I/O",        "app built",    "graph built",
+    "app started",   "first N2K engine", "first display"};
+
+int64_t BootProfiler::reached_us[(size_t)BootMilestone::count] = {};
+
+void BootProfiler::reach(BootMilestone milestone) {
+  int64_t& slot = reached_us[(size_t)milestone];
+  if (slot == 0) {
+    slot = esp_timer_get_time();
+  }
+}
+
+int64_t BootProfiler::elapsed_us(BootMilestone milestone) {
+  return reached_us[(size_t)milestone];
+}
+
+void BootProfiler::report() {
+  for (size_t i = 0; i < (size_t)BootMilestone::count; i++) {
+    if (reached_us[i] == 0) {
+      debugI("Boot: %-16s not reached", MILESTONE_NAMES[i]);
+    } else {
+      debugI("Boot: %-16s %6lu ms", MILESTONE_NAMES[i],
+             (unsigned long)(reached_us[i] / 1000));
+    }
+  }
+}
+
+}  // namespace sensesp
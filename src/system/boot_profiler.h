@@ -0,0 +1,40 @@
+#ifndef _boot_profiler_H_
+#define _boot_profiler_H_
+
+#include <Arduino.h>
+
+namespace sensesp {
+
+/// Startup milestones, in the order we expect to reach them
+enum class BootMilestone : uint8_t {
+  n2k_open,          // CAN controller up, address claim under way
+  local_io,          // I2C bus, display and INA226 configured
+  app_built,         // SensESP app object created (SPIFFS mounted)
+  graph_built,       // sensors, transforms and outputs wired
+  app_started,       // sensesp_app->start() returned
+  first_n2k_engine,  // first engine PGN handed to the CAN driver
+  first_display,     // first engine value painted on the OLED
+  count
+};
+
+/**
+ * @brief Record how long after power-on each startup milestone is reached
+ *
+ * Timestamps come from esp_timer, which starts counting when the application
+ * starts (the ROM and second stage bootloader add roughly 300 ms before that).
+ * Every milestone is recorded only the first time it is reached, so reach()
+ * is cheap enough to be called from the sample path.
+ */
+class BootProfiler {
+ public:
+  static void reach(BootMilestone milestone);
+  static int64_t elapsed_us(BootMilestone milestone);
+  static void report();
+
+ private:
+  static int64_t reached_us[(size_t)BootMilestone::count];
+};
+
+}  // namespace sensesp
+
+#endif
@@ -0,0 +1,311 @@
+#include "system/config_store.h"
+
+#include <SPIFFS.h>
+#include <rom/crc.h>
+
+#include <utility>
+
+#include "sensesp.h"
+
+namespace sensesp {
+
+static const char* const STORE_FILES[] = {"/cfgA.bin", "/cfgB.bin"};
+
+uint8_t* ConfigStore::blob = nullptr;
+uint8_t ConfigStore::active = 1;
+uint32_t ConfigStore::seq = 0;
+bool ConfigStore::booted = false;
+Configurable* ConfigStore::pending[CONFIG_STORE_MAX_PENDING] = {};
+size_t ConfigStore::pending_count = 0;
+uint16_t ConfigStore::store_loads = 0;
+uint16_t ConfigStore::json_loads = 0;
+uint32_t ConfigStore::store_us = 0;
+uint32_t ConfigStore::json_us = 0;
+
+static uint32_t fnv1a(const String& text) {
+  uint32_t hash = 2166136261UL;
+  for (size_t i = 0; i < text.length(); i++) {
+    hash ^= (uint8_t)text[i];
+    hash *= 16777619UL;
+  }
+  return hash;
+}
+
+static uint32_t checksum(const uint8_t* data, size_t length) {
+  return crc32_le(0, data, length);
+}
+
+// Entries start with the length-prefixed config path
+static bool same_path(const uint8_t* entry, const uint8_t* other) {
+  return entry[0] == other[0] && memcmp(entry + 1, other + 1, entry[0]) == 0;
+}
+
+static bool entry_is(const uint8_t* entry, const String& path) {
+  return entry[0] == path.length() &&
+         memcmp(entry + 1, path.c_str(), entry[0]) == 0;
+}
+
+void ConfigStore::load(Configurable* object) {
+  const String& path = object->config_path_;
+  if (path == "") {
+    return;
+  }
+  uint32_t start = micros();
+  open();
+  const uint8_t* data;
+  size_t length;
+  if (find(path, &data, &length)) {
+    DynamicJsonDocument doc(CONFIG_STORE_DOC_BYTES);
+    if (!deserializeMsgPack(doc, data, length)) {
+      object->set_configuration(doc.as<JsonObject>());
+      store_loads++;
+      store_us += micros() - start;
+      return;
+    }
+  }
+
+  // not in the store yet: its JSON file, if there is one
+  object->Configurable::load_configuration();
+  json_loads++;
+  json_us += micros() - start;
+  if (booted) {
+    save(object);
+  } else if (pending_count < CONFIG_STORE_MAX_PENDING) {
+    pending[pending_count++] = object;
+  }
+}
+
+void ConfigStore::save(Configurable* object) {
+  if (object->config_path_ == "") {
+    return;
+  }
+  open();
+  write(&object, 1);
+  if (booted) {
+    release();
+  }
+}
+
+void ConfigStore::commit() {
+  if (pending_count > 0) {
+    open();
+    write(pending, pending_count);
+    pending_count = 0;
+  }
+  release();
+  booted = true;
+}
+
+void ConfigStore::report() {
+  debugI("Config: %u objects from the store in %lu us, %u from JSON files in "
+         "%lu us",
+         store_loads, (unsigned long)store_us, json_loads,
+         (unsigned long)json_us);
+}
+
+// Read the newest valid store file into RAM, unless that's done already
+void ConfigStore::open() {
+  if (blob != nullptr) {
+    return;
+  }
+  uint32_t seqs[2] = {0, 0};
+  for (uint8_t i = 0; i < 2; i++) {
+    if (!SPIFFS.exists(STORE_FILES[i])) {
+      continue;
+    }
+    File file = SPIFFS.open(STORE_FILES[i], FILE_READ);
+    ConfigHeader header;
+    if (file.read((uint8_t*)&header, sizeof(header)) == sizeof(header)) {
+      seqs[i] = header.seq;
+    }
+    file.close();
+  }
+  uint8_t newest = seqs[1] > seqs[0] ? 1 : 0;
+  if (!read_file(newest) && !read_file(newest ^ 1)) {
+    // nothing stored yet: the first write goes to /cfgA.bin
+    active = 1;
+    seq = 0;
+  }
+}
+
+void ConfigStore::release() {
+  free(blob);
+  blob = nullptr;
+}
+
+bool ConfigStore::read_file(uint8_t file_index) {
+  if (!SPIFFS.exists(STORE_FILES[file_index])) {
+    return false;
+  }
+  File file = SPIFFS.open(STORE_FILES[file_index], FILE_READ);
+  ConfigHeader header;
+  bool ok = file.read((uint8_t*)&header, sizeof(header)) == sizeof(header) &&
+            memcmp(header.magic, "CFGS", 4) == 0 && header.version == 1 &&
+            header.length == file.size() &&
+            sizeof(header) + header.count * sizeof(ConfigIndexEntry) <=
+                header.length;
+  uint8_t* data = ok ? (uint8_t*)malloc(header.length) : nullptr;
+  if (data != nullptr) {
+    size_t rest = header.length - sizeof(header);
+    memcpy(data, &header, sizeof(header));
+    ok = file.read(data + sizeof(header), rest) == rest &&
+         checksum(data + sizeof(header), rest) == header.crc;
+  }
+  file.close();
+  if (data == nullptr || !ok) {
+    debugW("Config store: %s is damaged", STORE_FILES[file_index]);
+    free(data);
+    return false;
+  }
+  blob = data;
+  active = file_index;
+  seq = header.seq;
+  return true;
+}
+
+// Binary search of the index; entries with the same hash are compared by path
+bool ConfigStore::find(const String& path, const uint8_t** data,
+                       size_t* length) {
+  if (blob == nullptr) {
+    return false;
+  }
+  const ConfigHeader* header = (const ConfigHeader*)blob;
+  const ConfigIndexEntry* index =
+      (const ConfigIndexEntry*)(blob + sizeof(ConfigHeader));
+  uint32_t hash = fnv1a(path);
+  size_t low = 0;
+  size_t high = header->count;
+  while (low < high) {
+    size_t mid = (low + high) / 2;
+    if (index[mid].hash < hash) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  for (; low < header->count && index[low].hash == hash; low++) {
+    const uint8_t* entry = blob + index[low].offset;
+    if (entry_is(entry, path)) {
+      *data = entry + 1 + entry[0];
+      *length = index[low].length - 1 - entry[0];
+      return true;
+    }
+  }
+  return false;
+}
+
+// Write the store with the objects' current configuration to the other
+// file, and make that the current one.
+bool ConfigStore::write(Configurable* const* objects, size_t count) {
+  struct Item {
+    uint32_t hash;
+    const uint8_t* data;
+    uint16_t length;
+  };
+  Item* items = new Item[CONFIG_STORE_MAX_ENTRIES];
+  uint8_t** fresh = new uint8_t*[count]();
+  size_t item_count = 0;
+
+  // the new entries
+  DynamicJsonDocument doc(CONFIG_STORE_DOC_BYTES);
+  for (size_t i = 0; i < count && item_count < CONFIG_STORE_MAX_ENTRIES; i++) {
+    const String& path = objects[i]->config_path_;
+    doc.clear();
+    JsonObject root = doc.to<JsonObject>();
+    objects[i]->get_configuration(root);
+    size_t packed = measureMsgPack(doc);
+    size_t length = 1 + path.length() + packed;
+    if (path.length() > 0xFF || length > 0xFFFF) {
+      debugE("Config store: %s doesn't fit", path.c_str());
+      continue;
+    }
+    fresh[i] = (uint8_t*)malloc(length);
+    if (fresh[i] == nullptr) {
+      continue;
+    }
+    fresh[i][0] = path.length();
+    memcpy(fresh[i] + 1, path.c_str(), path.length());
+    serializeMsgPack(doc, fresh[i] + 1 + path.length(), packed);
+    bool duplicate = false;
+    for (size_t k = 0; k < item_count; k++) {
+      duplicate |= same_path(items[k].data, fresh[i]);
+    }
+    if (!duplicate) {
+      items[item_count++] = {fnv1a(path), fresh[i], (uint16_t)length};
+    }
+  }
+  size_t fresh_count = item_count;
+
+  // and the old ones they don't replace
+  if (blob != nullptr) {
+    const ConfigHeader* header = (const ConfigHeader*)blob;
+    const ConfigIndexEntry* index =
+        (const ConfigIndexEntry*)(blob + sizeof(ConfigHeader));
+    for (size_t j = 0; j < header->count; j++) {
+      const uint8_t* entry = blob + index[j].offset;
+      bool replaced = false;
+      for (size_t k = 0; k < fresh_count && !replaced; k++) {
+        replaced = items[k].hash == index[j].hash &&
+                   same_path(items[k].data, entry);
+      }
+      if (!replaced && item_count < CONFIG_STORE_MAX_ENTRIES) {
+        items[item_count++] = {index[j].hash, entry, index[j].length};
+      }
+    }
+  }
+
+  for (size_t i = 1; i < item_count; i++) {
+    for (size_t j = i; j > 0 && items[j].hash < items[j - 1].hash; j--) {
+      std::swap(items[j], items[j - 1]);
+    }
+  }
+
+  size_t total = sizeof(ConfigHeader) + item_count * sizeof(ConfigIndexEntry);
+  for (size_t i = 0; i < item_count; i++) {
+    total += items[i].length;
+  }
+  uint8_t* next_blob = total <= 0xFFFF ? (uint8_t*)malloc(total) : nullptr;
+  bool ok = next_blob != nullptr;
+  if (ok) {
+    ConfigHeader* header = (ConfigHeader*)next_blob;
+    ConfigIndexEntry* index =
+        (ConfigIndexEntry*)(next_blob + sizeof(ConfigHeader));
+    size_t offset = sizeof(ConfigHeader) + item_count * sizeof(ConfigIndexEntry);
+    for (size_t i = 0; i < item_count; i++) {
+      index[i] = {items[i].hash, (uint16_t)offset, items[i].length};
+      memcpy(next_blob + offset, items[i].data, items[i].length);
+      offset += items[i].length;
+    }
+    memcpy(header->magic, "CFGS", 4);
+    header->version = 1;
+    header->reserved = 0;
+    header->count = item_count;
+    header->seq = seq + 1;
+    header->length = total;
+    header->crc = checksum(next_blob + sizeof(ConfigHeader),
+                           total - sizeof(ConfigHeader));
+
+    File file = SPIFFS.open(STORE_FILES[active ^ 1], FILE_WRITE);
+    ok = file && file.write(next_blob, total) == total;
+    file.close();
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    free(fresh[i]);
+  }
+  delete[] fresh;
+  delete[] items;
+
+  if (!ok) {
+    debugE("Config store: can't write %s", STORE_FILES[active ^ 1]);
+    free(next_blob);
+    return false;
+  }
+  free(blob);
+  blob = next_blob;
+  active ^= 1;
+  seq++;
+  return true;
+}
+
+}  // namespace sensesp
@@ -0,0 +1,97 @@
+#ifndef _config_store_H_
+#define _config_store_H_
+
+#include <Arduino.h>
+
+#include "sensesp/system/configurable.h"
+
+// objects the store can hold
+#define CONFIG_STORE_MAX_ENTRIES 96
+// objects migrated from their JSON files during one boot
+#define CONFIG_STORE_MAX_PENDING 64
+// largest configuration of one object, as a JSON document
+#define CONFIG_STORE_DOC_BYTES 1024
+
+namespace sensesp {
+
+/// Start of a store file, 20 bytes
+struct ConfigHeader {
+  char magic[4];     // "CFGS"
+  uint8_t version;   // 1
+  uint8_t reserved;
+  uint16_t count;    // index entries
+  uint32_t seq;      // the valid file with the highest seq is the current one
+  uint32_t length;   // of the whole file, header included
+  uint32_t crc;      // CRC-32 of everything after the header
+};
+
+/// Index entry, sorted by hash; the data is a length-prefixed config path
+/// followed by the configuration as MessagePack
+struct ConfigIndexEntry {
+  uint32_t hash;     // FNV-1a of the config path
+  uint16_t offset;   // from the start of the file
+  uint16_t length;
+};
+
+/**
+ * @brief All of the board's configuration in one binary file
+ *
+ * SensESP keeps every Configurable in a JSON file of its own, so each object
+ * opens and parses a file at boot, and a save rewrites the file in place.
+ * The classes of this repo instead call load() and save() from their
+ * load_configuration() and save_configuration() overrides:
+ *
+ *  - at the first load(), the current store file is read into RAM in one go
+ *    and its CRC checked; each object then finds its entry with a binary
+ *    search of the index and decodes only that
+ *  - a save() writes the whole store, with the object's new entry, to the
+ *    other of two files, /cfgA.bin and /cfgB.bin, with the next sequence
+ *    number. The previous file is left alone, so a reset during the write
+ *    leaves the old configuration in place: the torn file fails its CRC.
+ *
+ * An object that isn't in the store yet is loaded from its JSON file as
+ * before, and added to the store by commit() at the end of setup(), which
+ * also frees the RAM copy. Library objects (1-Wire sensors, SK outputs)
+ * keep their JSON files.
+ *
+ * The time spent in load() is logged by report(), split between objects
+ * found in the store and objects loaded from JSON files, so the first boot
+ * after an upgrade shows the old cost and the next ones the new.
+ */
+class ConfigStore {
+ public:
+  /// Restore an object's configuration
+  static void load(Configurable* object);
+
+  /// Store an object's configuration
+  static void save(Configurable* object);
+
+  /// Add the objects loaded from JSON files to the store, free the RAM copy
+  static void commit();
+
+  static void report();
+
+ private:
+  static uint8_t* blob;  // the current file, while open
+  static uint8_t active; // 0 for /cfgA.bin, 1 for /cfgB.bin
+  static uint32_t seq;
+  static bool booted;
+
+  static Configurable* pending[CONFIG_STORE_MAX_PENDING];
+  static size_t pending_count;
+
+  static uint16_t store_loads;
+  static uint16_t json_loads;
+  static uint32_t store_us;
+  static uint32_t json_us;
+
+  static void open();
+  static void release();
+  static bool read_file(uint8_t file);
+  static bool find(const String& path, const uint8_t** data, size_t* length);
+  static bool write(Configurable* const* objects, size_t count);
+};
+
+}  // namespace sensesp
+
+#endif
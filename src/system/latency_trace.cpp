@@ -0,0 +1,69 @@
+#ifdef LATENCY_TRACE
+
+#include "system/latency_trace.h"
+
+#include "sensesp.h"
+
+// bucket i holds ages below 2^i microseconds, the last one everything above
+#define LATENCY_BUCKETS 26
+
+namespace sensesp {
+
+static const char* const SINK_NAMES[] = {"N2K", "Signal K", "display", "UDP"};
+
+uint32_t LatencyTrace::acquired_us = 0;
+
+static uint32_t histogram[(size_t)LatencySink::count][LATENCY_BUCKETS];
+static uint32_t worst_us[(size_t)LatencySink::count];
+
+void LatencyTrace::record(LatencySink sink, uint32_t acquired) {
+  if (acquired == 0) {
+    return;
+  }
+  uint32_t age = micros() - acquired;
+  size_t bucket = age == 0 ? 0 : 32 - __builtin_clz(age);
+  if (bucket >= LATENCY_BUCKETS) {
+    bucket = LATENCY_BUCKETS - 1;
+  }
+  histogram[(size_t)sink][bucket]++;
+  if (age > worst_us[(size_t)sink]) {
+    worst_us[(size_t)sink] = age;
+  }
+}
+
+// upper bound of the bucket holding the given fraction of the samples
+static uint32_t percentile(const uint32_t* buckets, uint32_t total,
+                           float fraction) {
+  uint32_t target = (uint32_t)(fraction * total);
+  uint32_t seen = 0;
+  for (size_t i = 0; i < LATENCY_BUCKETS; i++) {
+    seen += buckets[i];
+    if (seen > target) {
+      return 1UL << i;
+    }
+  }
+  return 1UL << (LATENCY_BUCKETS - 1);
+}
+
+void LatencyTrace::report() {
+  for (size_t s = 0; s < (size_t)LatencySink::count; s++) {
+    uint32_t* buckets = histogram[s];
+    uint32_t total = 0;
+    for (size_t i = 0; i < LATENCY_BUCKETS; i++) {
+      total += buckets[i];
+    }
+    if (total == 0) {
+      continue;
+    }
+    debugI("Latency %-8s n=%u p50<%u p90<%u p99<%u max=%u us", SINK_NAMES[s],
+           total, percentile(buckets, total, 0.5f),
+           percentile(buckets, total, 0.9f), percentile(buckets, total, 0.99f),
+           worst_us[s]);
+    memset(buckets, 0, sizeof(histogram[s]));
+    worst_us[s] = 0;
+  }
+}
+
+}  // namespace sensesp
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef _latency_trace_H_
+#define _latency_trace_H_
+
+#include <Arduino.h>
+
+#include "sensesp/transforms/transform.h"
+
+namespace sensesp {
+
+/// Where a value leaves the board
+enum class LatencySink : uint8_t {
+  n2k,      // handed to the CAN driver by the N2kTxQueue
+  signalk,  // handed to SKOutput (SensESP's delta queue is not traced)
+  display,  // painted on the OLED
+  udp,      // broadcast by UDPBroadcast
+  count
+};
+
+/**
+ * @brief Debug-build tracing of the age of values when they leave the board
+ *
+ * Values travel through SensESP as bare floats, but a sample travels from
+ * the sensor's emit() to the sinks within one call chain. Every place a chain
+ * starts, a sensor read, a scheduler task that emits, a message from the bus,
+ * holds a LatencyChain for as long as it emits; everything downstream reads
+ * the acquisition time back with current() and keeps it next to the value
+ * wherever the value is held (N2K fields waiting for the scheduler, the
+ * transmit queue, the UDP buffer, the display pages). When the value finally
+ * leaves, record() adds its age to the sink's log2 histogram; report() logs
+ * the percentiles. Outside a chain current() is 0, so a value emitted from
+ * an untraced origin is left out rather than given another sample's age.
+ *
+ * Only active with -D LATENCY_TRACE (see the esp32dev_latency_trace
+ * environment in platformio.ini); otherwise every call compiles to nothing
+ * and current() is 0, which record() ignores.
+ */
+class LatencyTrace {
+ public:
+#ifdef LATENCY_TRACE
+  static uint32_t current() { return acquired_us; }
+  static void record(LatencySink sink, uint32_t acquired);
+  static void report();
+
+ private:
+  static uint32_t acquired_us;
+
+  friend class LatencyChain;
+#else
+  static uint32_t current() { return 0; }
+  static void record(LatencySink, uint32_t) {}
+  static void report() {}
+#endif
+};
+
+/// The values emitted while it lives were acquired at acquired_us; a chain
+/// it interrupts gets its own time back afterwards
+class LatencyChain {
+ public:
+#ifdef LATENCY_TRACE
+  explicit LatencyChain(uint32_t acquired_us = micros())
+      : outer_us{LatencyTrace::acquired_us} {
+    LatencyTrace::acquired_us = acquired_us;
+  }
+  ~LatencyChain() { LatencyTrace::acquired_us = outer_us; }
+
+ private:
+  uint32_t outer_us;
+#else
+  explicit LatencyChain(uint32_t = 0) {}
+#endif
+};
+
+/// Starts a chain for a sensor we can't change, e.g. the 1-Wire sensors
+class LatencyOrigin : public FloatTransform {
+ public:
+  LatencyOrigin() : FloatTransform("") {}
+
+  virtual void set_input(float input, uint8_t input_channel = 0) override {
+    LatencyChain chain;
+    this->emit(input);
+  }
+};
+
+}  // namespace sensesp
+
+#endif
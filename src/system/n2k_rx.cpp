@@ -0,0 +1,221 @@
+#include "system/n2k_rx.h"
+
+#include <ESP32_CAN_regdef.h>
+#include <freertos/FreeRTOS.h>
+#include <N2kMessages.h>
+
+#include "sensesp.h"
+
+namespace sensesp {
+
+constexpr CanFilter NETWORK_FILTER = can_filter(N2K_RX_NETWORK_PGNS);
+constexpr CanFilter DATA_FILTER = can_filter(N2K_RX_DATA_PGNS);
+
+static_assert(NETWORK_FILTER.mask != 0xFFFF && DATA_FILTER.mask != 0xFFFF,
+              "a receive filter accepts everything");
+
+bool N2kEngineDynamic::parse(const tN2kMsg& msg, N2kEngineDynamic& value) {
+  unsigned char instance;
+  double coolant_pressure, fuel_pressure;
+  int8_t load, torque;
+  tN2kEngineDiscreteStatus1 status1;
+  tN2kEngineDiscreteStatus2 status2;
+  if (!ParseN2kEngineDynamicParam(
+          msg, instance, value.oil_pressure, value.oil_temperature,
+          value.coolant_temperature, value.alternator_voltage,
+          value.fuel_rate, value.hours, coolant_pressure, fuel_pressure, load,
+          torque, status1, status2)) {
+    return false;
+  }
+  value.instance = instance;
+  return true;
+}
+
+bool N2kBatteryStatus::parse(const tN2kMsg& msg, N2kBatteryStatus& value) {
+  unsigned char instance, sid;
+  if (!ParseN2kBatteryStatus(msg, instance, value.voltage, value.current,
+                             value.temperature, sid)) {
+    return false;
+  }
+  value.instance = instance;
+  return true;
+}
+
+N2kRx::N2kRx(tNMEA2000* nmea2000, N2kTxQueue* n2k_tx, String config_path)
+    : Configurable(config_path), nmea2000{nmea2000}, n2k_tx{n2k_tx} {
+  load_configuration();
+}
+
+void N2kRx::add(uint32_t pgn, std::function<void(const tN2kMsg&)> callback) {
+  size_t index = 0;
+  while (index < N2K_RX_DATA_COUNT && N2K_RX_DATA_PGNS[index] != pgn) {
+    index++;
+  }
+  if (index == N2K_RX_DATA_COUNT) {
+    debugE("N2K RX: PGN %lu is not in N2K_RX_DATA_PGNS, the filter drops it",
+           (unsigned long)pgn);
+    return;
+  }
+  if (handler_count == N2K_RX_MAX_HANDLERS) {
+    debugE("N2K RX: no room for another handler");
+    return;
+  }
+  handlers[handler_count++] = {(uint8_t)index, callback};
+}
+
+void N2kRx::start() {
+  // tell the other nodes what we listen to, in the PGN list
+  static unsigned long receive_pgns[N2K_RX_DATA_COUNT + 1] = {};
+  for (size_t i = 0; i < N2K_RX_DATA_COUNT; i++) {
+    receive_pgns[i] = N2K_RX_DATA_PGNS[i];
+  }
+  nmea2000->ExtendReceiveMessages(receive_pgns);
+
+  if (!filter) {
+    return;
+  }
+  ReactESP::app->onDelay(N2K_RX_OPEN_MS, [this]() { close_filter(); });
+}
+
+void N2kRx::parse() {
+  uint32_t start = micros();
+  nmea2000->ParseMessages();
+  uint32_t elapsed = micros() - start;
+  if (open) {
+    open_us += elapsed;
+    open_calls++;
+  } else {
+    filtered_us += elapsed;
+    filtered_calls++;
+  }
+}
+
+void N2kRx::dispatch(const tN2kMsg& msg) {
+  n2k_tx->count_rx(msg);
+  size_t index = 0;
+  while (index < N2K_RX_DATA_COUNT && N2K_RX_DATA_PGNS[index] != msg.PGN) {
+    index++;
+  }
+  if (index == N2K_RX_DATA_COUNT) {
+    other++;
+    return;
+  }
+  received[index]++;
+  for (size_t i = 0; i < handler_count; i++) {
+    if (handlers[i].pgn_index == index) {
+      handlers[i].callback(msg);
+    }
+  }
+}
+
+void N2kRx::close_filter() {
+  if (!set_filter_when_idle()) {
+    debugW("N2K RX: bus never idle for the filter, trying again");
+    ReactESP::app->onDelay(N2K_RX_RETRY_MS, [this]() { close_filter(); });
+    return;
+  }
+  open = false;
+  n2k_tx->set_rx_filtered(true);
+  report();
+  ReactESP::app->onRepeat(N2K_RX_REPORT_MS, [this]() { report(); });
+}
+
+static bool controller_idle() {
+  return MODULE_CAN->SR.B.TBS && MODULE_CAN->SR.B.TCS && !MODULE_CAN->SR.B.TS &&
+         !MODULE_CAN->SR.B.RS && !MODULE_CAN->SR.B.RBS;
+}
+
+// The SJA1000 compatible controller only takes a new filter in reset mode,
+// and entering it aborts the frame being sent or received and clears the
+// receive FIFO. So the switch waits for the transmit buffer to be free, the
+// last transmission complete, nothing coming in and nothing left unread.
+// Only this loop hands frames to the library, through the transmit queue's
+// pump and ParseMessages(), so nothing new is queued meanwhile. Idle on two
+// polls in a row, with interrupts on in between, also means a pending
+// interrupt has run: the receive one emptied the FIFO, the transmit one had
+// nothing left to load.
+bool N2kRx::set_filter_when_idle() {
+  uint32_t start = micros();
+  bool was_idle = false;
+  while (micros() - start < N2K_RX_IDLE_WAIT_US) {
+    bool idle = controller_idle();
+    if (idle && was_idle) {
+      portDISABLE_INTERRUPTS();
+      if (controller_idle()) {
+        MODULE_CAN->MOD.B.RM = 1;
+        MODULE_CAN->MOD.B.AFM = 0;
+        MODULE_CAN->MBX_CTRL.ACC.CODE[0] = NETWORK_FILTER.code >> 8;
+        MODULE_CAN->MBX_CTRL.ACC.CODE[1] = NETWORK_FILTER.code & 0xFF;
+        MODULE_CAN->MBX_CTRL.ACC.CODE[2] = DATA_FILTER.code >> 8;
+        MODULE_CAN->MBX_CTRL.ACC.CODE[3] = DATA_FILTER.code & 0xFF;
+        MODULE_CAN->MBX_CTRL.ACC.MASK[0] = NETWORK_FILTER.mask >> 8;
+        MODULE_CAN->MBX_CTRL.ACC.MASK[1] = NETWORK_FILTER.mask & 0xFF;
+        MODULE_CAN->MBX_CTRL.ACC.MASK[2] = DATA_FILTER.mask >> 8;
+        MODULE_CAN->MBX_CTRL.ACC.MASK[3] = DATA_FILTER.mask & 0xFF;
+        MODULE_CAN->MOD.B.RM = 0;
+        portENABLE_INTERRUPTS();
+        return true;
+      }
+      portENABLE_INTERRUPTS();
+      idle = false;
+    }
+    was_idle = idle;
+    // a few bit times at 250 kbit/s
+    delayMicroseconds(10);
+  }
+  return false;
+}
+
+void N2kRx::report() const {
+  uint32_t open_mean = open_calls > 0 ? open_us / open_calls : 0;
+  uint32_t filtered_mean = filtered_calls > 0 ? filtered_us / filtered_calls : 0;
+  debugI("N2K RX: ParseMessages %lu us per call with all traffic, %lu us "
+         "filtered",
+         (unsigned long)open_mean, (unsigned long)filtered_mean);
+  for (size_t i = 0; i < N2K_RX_DATA_COUNT; i++) {
+    debugI("N2K RX: PGN %lu received %lu", (unsigned long)N2K_RX_DATA_PGNS[i],
+           (unsigned long)received[i]);
+  }
+  debugI("N2K RX: %lu other messages", (unsigned long)other);
+}
+
+void N2kRx::get_configuration(JsonObject& root) {
+  root["filter"] = filter;
+  root["parse_open"] = (uint32_t)(open_calls > 0 ? open_us / open_calls : 0);
+  root["parse_filtered"] =
+      (uint32_t)(filtered_calls > 0 ? filtered_us / filtered_calls : 0);
+  String counts;
+  for (size_t i = 0; i < N2K_RX_DATA_COUNT; i++) {
+    counts += String(i > 0 ? ", " : "") + N2K_RX_DATA_PGNS[i] + ": " +
+              received[i];
+  }
+  root["received"] = counts;
+  root["other"] = other;
+}
+
+static const char SCHEMA[] PROGMEM = R"###({
+    "type": "object",
+    "properties": {
+        "filter": { "title": "Receive filter", "type": "boolean", "description": "Let only the node's own and the subscribed PGNs through to the library" },
+        "parse_open": { "title": "Parse time, all traffic", "type": "integer", "description": "Per call, in microseconds", "readOnly": true },
+        "parse_filtered": { "title": "Parse time, filtered", "type": "integer", "description": "Per call, in microseconds", "readOnly": true },
+        "received": { "title": "Received per PGN", "type": "string", "readOnly": true },
+        "other": { "title": "Other messages", "type": "integer", "readOnly": true }
+    }
+  })###";
+
+String N2kRx::get_config_schema() { return FPSTR(SCHEMA); }
+
+// applied after a restart
+bool N2kRx::set_configuration(const JsonObject& config) {
+  String expected[] = {"filter"};
+  for (auto str : expected) {
+    if (!config.containsKey(str)) {
+      return false;
+    }
+  }
+  filter = config["filter"];
+  return true;
+}
+
+}  // namespace sensesp
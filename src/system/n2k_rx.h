@@ -0,0 +1,183 @@
+#ifndef _n2k_rx_H_
+#define _n2k_rx_H_
+
+#include <NMEA2000.h>
+
+#include <functional>
+
+#include "sensesp/system/configurable.h"
+#include "system/config_store.h"
+#include "system/n2k_tx_queue.h"
+
+// handlers the registry can hold
+#define N2K_RX_MAX_HANDLERS 8
+// all traffic reaches the library this long after start(), so the transmit
+// queue can calibrate its bus load estimate
+#define N2K_RX_OPEN_MS 10000
+// how long to wait for an idle controller, and how often to try again
+#define N2K_RX_IDLE_WAIT_US 20000
+#define N2K_RX_RETRY_MS 1000
+#define N2K_RX_REPORT_MS 60000
+
+namespace sensesp {
+
+/// One half of the CAN controller's dual acceptance filter. It sees bits
+/// 28..13 of the identifier: priority, reserved, data page, PDU format and
+/// the top 3 bits of PDU specific. A mask bit set means don't care.
+struct CanFilter {
+  uint16_t code;
+  uint16_t mask;
+};
+
+/// Identifier bits 28..13 of a PGN
+constexpr uint16_t can_filter_code(uint32_t pgn) {
+  return (uint16_t)((((pgn >> 16) & 0x1) << 11) | (((pgn >> 8) & 0xFF) << 3) |
+                    ((pgn >> 5) & 0x7));
+}
+
+/// Bits that never matter for a PGN: priority, the reserved bit and, for PDU1
+/// (PDU format below 240), PDU specific, which is the destination address
+constexpr uint16_t can_filter_mask(uint32_t pgn) {
+  return 0xF000 | (((pgn >> 8) & 0xFF) < 240 ? 0x0007 : 0x0000);
+}
+
+constexpr uint16_t can_filter_spread(const uint32_t* pgns, size_t count,
+                                     uint16_t code) {
+  return count == 0 ? 0
+                    : (uint16_t)(can_filter_mask(pgns[0]) |
+                                 (can_filter_code(pgns[0]) ^ code) |
+                                 can_filter_spread(pgns + 1, count - 1, code));
+}
+
+/// The narrowest filter that accepts all of pgns
+template <size_t N>
+constexpr CanFilter can_filter(const uint32_t (&pgns)[N]) {
+  return CanFilter{can_filter_code(pgns[0]),
+                   can_filter_spread(pgns, N, can_filter_code(pgns[0]))};
+}
+
+constexpr bool can_filter_accepts(CanFilter filter, uint32_t pgn) {
+  return ((can_filter_code(pgn) ^ filter.code) &
+          ~(filter.mask | can_filter_mask(pgn)) & 0xFFFF) == 0;
+}
+
+// What the node itself needs: ISO acknowledgement, request and transport
+// protocol, address claim and group function. They merge into PDU formats
+// 0xE8 to 0xEF.
+constexpr uint32_t N2K_RX_NETWORK_PGNS[] = {59392, 59904, 60160,
+                                            60416, 60928, 126208};
+// Inbound data with handlers: Engine Parameters, Dynamic and Battery Status.
+// They merge into 127488 to 127519.
+constexpr uint32_t N2K_RX_DATA_PGNS[] = {127489, 127508};
+constexpr size_t N2K_RX_DATA_COUNT =
+    sizeof(N2K_RX_DATA_PGNS) / sizeof(N2K_RX_DATA_PGNS[0]);
+
+/// PGN 127489 Engine Parameters, Dynamic, from another node such as the ECU
+struct N2kEngineDynamic {
+  static constexpr uint32_t PGN = 127489;
+  uint8_t instance;
+  double oil_pressure;         // Pa
+  double oil_temperature;      // K
+  double coolant_temperature;  // K
+  double alternator_voltage;   // V
+  double fuel_rate;            // l/h
+  double hours;                // s
+
+  static bool parse(const tN2kMsg& msg, N2kEngineDynamic& value);
+};
+
+/// PGN 127508 Battery Status
+struct N2kBatteryStatus {
+  static constexpr uint32_t PGN = 127508;
+  uint8_t instance;
+  double voltage;      // V
+  double current;      // A
+  double temperature;  // K
+
+  static bool parse(const tN2kMsg& msg, N2kBatteryStatus& value);
+};
+
+/**
+ * @brief Receive only the PGNs somebody uses, and hand them out decoded
+ *
+ * The library reassembles and parses every frame on the backbone, although
+ * nothing here reads most of them. start() puts the CAN controller's
+ * acceptance filter in dual mode. The first half is built from
+ * N2K_RX_NETWORK_PGNS, which the node needs for address claiming and
+ * requests. The second half is built from N2K_RX_DATA_PGNS. Both are computed
+ * at compile time. Frames outside both ranges never reach the library.
+ *
+ * subscribe<T>() registers a handler for a message type with a PGN and a
+ * parse(); dispatch(), called from the library's message handler, decodes
+ * only the subscribed PGNs and counts them per PGN.
+ *
+ * The filter is set once, N2K_RX_OPEN_MS after start(), and only while the
+ * controller neither sends nor receives: reset mode, which a new filter
+ * needs, aborts a frame on the wire. Until then the transmit queue calibrates
+ * its bus load estimate on all traffic, see N2kTxQueue::watch_rx_pin(). The
+ * time spent in ParseMessages() is measured separately before and after;
+ * the per-call times and the per-PGN counters are logged every
+ * N2K_RX_REPORT_MS.
+ */
+class N2kRx : public Configurable {
+ public:
+  N2kRx(tNMEA2000* nmea2000, N2kTxQueue* n2k_tx, String config_path = "");
+
+  /// Call handler with every received message of type T
+  template <typename T>
+  void subscribe(std::function<void(const T&)> handler) {
+    add(T::PGN, [handler](const tN2kMsg& msg) {
+      T value;
+      if (T::parse(msg, value)) {
+        handler(value);
+      }
+    });
+  }
+
+  /// Register the PGNs with the library and schedule the acceptance filter;
+  /// the library must have opened the CAN controller
+  void start();
+
+  /// Run the library's ParseMessages(), timed
+  void parse();
+
+  /// For the library's message handler
+  void dispatch(const tN2kMsg& msg);
+
+  void report() const;
+
+  virtual void load_configuration() override { ConfigStore::load(this); }
+  virtual void save_configuration() override { ConfigStore::save(this); }
+  virtual void get_configuration(JsonObject& root) override;
+  virtual bool set_configuration(const JsonObject& config) override;
+  virtual String get_config_schema() override;
+
+ private:
+  struct Handler {
+    uint8_t pgn_index;  // into N2K_RX_DATA_PGNS
+    std::function<void(const tN2kMsg&)> callback;
+  };
+
+  tNMEA2000* nmea2000;
+  N2kTxQueue* n2k_tx;
+  bool filter = true;
+
+  bool open = true;
+  Handler handlers[N2K_RX_MAX_HANDLERS];
+  size_t handler_count = 0;
+  uint32_t received[N2K_RX_DATA_COUNT] = {};
+  uint32_t other = 0;
+
+  uint64_t open_us = 0;
+  uint32_t open_calls = 0;
+  uint64_t filtered_us = 0;
+  uint32_t filtered_calls = 0;
+
+  void add(uint32_t pgn, std::function<void(const tN2kMsg&)> callback);
+  void close_filter();
+  bool set_filter_when_idle();
+};
+
+}  // namespace sensesp
+
+#endif
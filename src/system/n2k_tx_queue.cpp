@@ -0,0 +1,184 @@
+#include "system/n2k_tx_queue.h"
+
+#include "sensesp.h"
+#include "system/latency_trace.h"
+
+#define N2K_BITRATE 250000
+#define N2K_LOAD_WINDOW_MS 1000
+
+namespace sensesp {
+
+// Bits on the wire for a message: single frame up to 8 bytes, fast packet
+// above, 6 bytes in the first frame and 7 in the others. An extended frame
+// with 8 data bytes is 128 bits plus about 10 % stuffing.
+static uint32_t message_bits(const tN2kMsg& msg) {
+  uint32_t frames = msg.DataLen <= 8 ? 1 : 1 + (msg.DataLen - 6 + 6) / 7;
+  return frames * 140;
+}
+
+N2kTxQueue::N2kTxQueue(tNMEA2000* nmea2000, String config_path)
+    : Configurable(config_path), nmea2000{nmea2000} {
+  load_configuration();
+}
+
+void N2kTxQueue::start() {
+  ReactESP::app->onTick([this]() { this->pump(); });
+  if (rx_pin >= 0) {
+    // read only, the CAN driver has set the pin up
+    ReactESP::app->onTick([this]() { this->sample_rx_pin(); });
+  }
+  ReactESP::app->onRepeat(N2K_LOAD_WINDOW_MS, [this]() { this->update_load(); });
+}
+
+void N2kTxQueue::send(const tN2kMsg& msg, uint8_t instance,
+                      uint32_t acquired_us) {
+  uint32_t key = (msg.PGN << 8) | instance;
+  Slot* free_slot = nullptr;
+  Slot* victim = nullptr;
+  for (Slot& slot : slots) {
+    if (!slot.used) {
+      free_slot = free_slot ? free_slot : &slot;
+      continue;
+    }
+    if (slot.key == key) {
+      // keep the queueing time, so a steady stream isn't starved by its updates
+      slot.msg = msg;
+      slot.acquired_us = acquired_us;
+      replaced++;
+      return;
+    }
+    // the least important waiting message, the oldest among equals
+    if (victim == nullptr || slot.msg.Priority > victim->msg.Priority ||
+        (slot.msg.Priority == victim->msg.Priority &&
+         slot.queued_ms < victim->queued_ms)) {
+      victim = &slot;
+    }
+  }
+  if (free_slot == nullptr) {
+    dropped++;
+    if (victim == nullptr || victim->msg.Priority <= msg.Priority) {
+      return;
+    }
+    free_slot = victim;
+  }
+  free_slot->msg = msg;
+  free_slot->key = key;
+  free_slot->queued_ms = millis();
+  free_slot->acquired_us = acquired_us;
+  free_slot->used = true;
+}
+
+// The waiting message to send now: most important first, oldest within a
+// priority, skipping low priority messages that are backing off.
+N2kTxQueue::Slot* N2kTxQueue::next(uint32_t now) {
+  bool congested = bus_load > high_load;
+  Slot* best = nullptr;
+  for (Slot& slot : slots) {
+    if (!slot.used) {
+      continue;
+    }
+    if (congested && slot.msg.Priority >= low_priority &&
+        now - slot.queued_ms < backoff_ms) {
+      continue;
+    }
+    if (best == nullptr || slot.msg.Priority < best->msg.Priority ||
+        (slot.msg.Priority == best->msg.Priority &&
+         slot.queued_ms < best->queued_ms)) {
+      best = &slot;
+    }
+  }
+  return best;
+}
+
+void N2kTxQueue::pump() {
+  uint32_t now = millis();
+  Slot* slot;
+  while ((slot = next(now)) != nullptr) {
+    if (!nmea2000->SendMsg(slot->msg)) {
+      return;  // the library's buffer is full, try again next tick
+    }
+    if (bus_load > high_load && slot->msg.Priority >= low_priority) {
+      deferred++;
+    }
+    LatencyTrace::record(LatencySink::n2k, slot->acquired_us);
+    window_bits += message_bits(slot->msg);
+    slot->used = false;
+    sent++;
+  }
+}
+
+void N2kTxQueue::count_rx(const tN2kMsg& msg) { rx_bits += message_bits(msg); }
+
+// The ticks don't keep time with the bus, so over a window the samples fall
+// on frames in proportion to the time the bus is busy.
+void N2kTxQueue::sample_rx_pin() {
+  pin_samples++;
+  if (digitalRead(rx_pin) == LOW) {
+    pin_dominant++;
+  }
+}
+
+void N2kTxQueue::update_load() {
+  float load = (float)(window_bits + rx_bits) * 1000 / N2K_LOAD_WINDOW_MS /
+               N2K_BITRATE;
+  // a window that opened or closed the filter part way counts as filtered
+  bool whole = !rx_filtered && !rx_was_filtered;
+  rx_was_filtered = rx_filtered;
+  if (pin_samples > 0) {
+    float share = (float)pin_dominant / pin_samples;
+    if (whole && load > N2K_TX_CALIBRATION_LOAD) {
+      dominant_per_load = 0.9f * dominant_per_load + 0.1f * share / load;
+    } else if (!whole) {
+      // the pin sees our own frames as well as the ones the filter drops
+      load = constrain(share / dominant_per_load, load, 1.0f);
+    }
+  }
+  window_bits = 0;
+  rx_bits = 0;
+  pin_samples = 0;
+  pin_dominant = 0;
+  // smooth over a few windows, a single burst is not congestion
+  bus_load = 0.7f * bus_load + 0.3f * load;
+}
+
+void N2kTxQueue::get_configuration(JsonObject& root) {
+  root["high_load"] = high_load;
+  root["low_priority"] = low_priority;
+  root["backoff"] = backoff_ms;
+  root["bus_load"] = bus_load;
+  root["sent"] = sent;
+  root["replaced"] = replaced;
+  root["dropped"] = dropped;
+  root["deferred"] = deferred;
+}
+
+static const char SCHEMA[] PROGMEM = R"###({
+    "type": "object",
+    "properties": {
+        "high_load": { "title": "High bus load", "type": "number", "description": "Bus utilisation, 0 to 1, above which low priority messages back off" },
+        "low_priority": { "title": "Low priority", "type": "integer", "description": "N2K priority from which a message is low priority (0 is the highest, 7 the lowest)" },
+        "backoff": { "title": "Backoff", "type": "integer", "description": "Time a low priority message waits on a busy bus, in milliseconds" },
+        "bus_load": { "title": "Bus load", "type": "number", "readOnly": true },
+        "sent": { "title": "Messages sent", "type": "integer", "readOnly": true },
+        "replaced": { "title": "Replaced while waiting", "type": "integer", "readOnly": true },
+        "dropped": { "title": "Dropped, queue full", "type": "integer", "readOnly": true },
+        "deferred": { "title": "Sent after backing off", "type": "integer", "readOnly": true }
+    }
+  })###";
+
+String N2kTxQueue::get_config_schema() { return FPSTR(SCHEMA); }
+
+bool N2kTxQueue::set_configuration(const JsonObject& config) {
+  String expected[] = {"high_load", "low_priority", "backoff"};
+  for (auto str : expected) {
+    if (!config.containsKey(str)) {
+      return false;
+    }
+  }
+  high_load = config["high_load"];
+  low_priority = config["low_priority"];
+  backoff_ms = config["backoff"];
+  return true;
+}
+
+}  // namespace sensesp
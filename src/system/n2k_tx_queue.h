@@ -0,0 +1,111 @@
+#ifndef _n2k_tx_queue_H_
+#define _n2k_tx_queue_H_
+
+#include <NMEA2000.h>
+
+#include "sensesp/system/configurable.h"
+#include "system/config_store.h"
+
+// messages waiting for the CAN driver, one per PGN and instance
+#define N2K_TX_SLOTS 12
+// dominant share of the RX pin per unit of load until calibrated: about half
+// the bits of a frame are dominant, the idle bus is recessive
+#define N2K_TX_DOMINANT_PER_LOAD 0.5f
+// counted load, 0 .. 1, below which a window doesn't calibrate the RX pin
+#define N2K_TX_CALIBRATION_LOAD 0.02f
+
+namespace sensesp {
+
+/**
+ * @brief Priority ordered N2K transmit queue that keeps only the latest value
+ *
+ * Messages are keyed by PGN and instance. A message for a key that is
+ * already waiting replaces the waiting one in place, so a congested bus
+ * never sees stale values, let alone several versions of the same PGN. The
+ * pump hands waiting messages to the library in order of N2K priority
+ * (lowest number first), oldest first within a priority, until the
+ * library's send buffer is full; keep that buffer small, so the ordering
+ * happens here and not in its FIFO.
+ *
+ * Bus load is estimated from the frames we send and the frames seen by the
+ * message handler (call count_rx() from it; the node must be in a listen
+ * mode to see all traffic). A receive filter hides part of the traffic, see
+ * set_rx_filtered(). So the CAN RX pin is sampled every tick as well, see
+ * watch_rx_pin(): the share of dominant samples grows with the load. Windows
+ * that see all traffic calibrate that share against the counted bits;
+ * filtered windows take the load from the share.
+ *
+ * Above high_load, messages of priority low_priority and numerically higher
+ * are held back until they have waited backoff_ms, being replaced by fresher
+ * values in the meantime.
+ */
+class N2kTxQueue : public Configurable {
+ public:
+  N2kTxQueue(tNMEA2000* nmea2000, String config_path = "");
+
+  /// Start the pump and the bus load estimate
+  void start();
+
+  /// Queue a message, replacing a waiting one with the same PGN and instance;
+  /// acquired_us is the LatencyTrace time of its oldest value
+  void send(const tN2kMsg& msg, uint8_t instance = 0, uint32_t acquired_us = 0);
+
+  /// Account for a received message in the bus load
+  void count_rx(const tN2kMsg& msg);
+
+  /// Whether the CAN controller filters what count_rx() sees
+  void set_rx_filtered(bool filtered) { rx_filtered = filtered; }
+
+  /// Sample the CAN RX pin for the load estimate; call before start()
+  void watch_rx_pin(uint8_t pin) { rx_pin = pin; }
+
+  /// Estimated bus utilisation, 0 .. 1
+  float get_bus_load() const { return bus_load; }
+
+  virtual void load_configuration() override { ConfigStore::load(this); }
+  virtual void save_configuration() override { ConfigStore::save(this); }
+  virtual void get_configuration(JsonObject& root) override;
+  virtual bool set_configuration(const JsonObject& config) override;
+  virtual String get_config_schema() override;
+
+ private:
+  struct Slot {
+    tN2kMsg msg;
+    uint32_t key;
+    uint32_t queued_ms;
+    uint32_t acquired_us;
+    bool used;
+  };
+
+  tNMEA2000* nmea2000;
+  Slot slots[N2K_TX_SLOTS] = {};
+
+  float high_load = 0.7;
+  uint8_t low_priority = 6;
+  uint32_t backoff_ms = 1000;
+
+  float bus_load = 0.0f;
+  uint32_t window_bits = 0;
+  uint32_t rx_bits = 0;
+  bool rx_filtered = false;
+  bool rx_was_filtered = false;  // at the start of the window
+
+  int16_t rx_pin = -1;
+  uint32_t pin_samples = 0;
+  uint32_t pin_dominant = 0;
+  float dominant_per_load = N2K_TX_DOMINANT_PER_LOAD;
+
+  uint32_t sent = 0;
+  uint32_t replaced = 0;
+  uint32_t dropped = 0;
+  uint32_t deferred = 0;
+
+  void pump();
+  void sample_rx_pin();
+  void update_load();
+  Slot* next(uint32_t now);
+};
+
+}  // namespace sensesp
+
+#endif
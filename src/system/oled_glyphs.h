@@ -0,0 +1,96 @@
+#ifndef _oled_glyphs_H_
+#define _oled_glyphs_H_
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// a 128x64 SSD1306: 8 pages of 128 one-byte columns, one page per text row
+#define OLED_WIDTH 128
+#define OLED_PAGES 8
+// pixels per character cell, the 5x7 font and a blank column
+#define OLED_CELL 6
+#define OLED_ROW_CELLS (OLED_WIDTH / OLED_CELL)
+// a row can hold two values; the second starts at this cell
+#define OLED_FIELD_CELL 11
+#define OLED_FIELDS 2
+// the characters a value is drawn with
+#define OLED_GLYPHS "0123456789-. "
+#define OLED_GLYPH_COUNT 13
+
+namespace sensesp {
+
+/// The value as "%.1f" would print it, "--" for NaN, into out; returns the
+/// characters, at most 12
+inline size_t format_tenths(float value, char* out) {
+  if (isnan(value)) {
+    out[0] = '-';
+    out[1] = '-';
+    return 2;
+  }
+  float scaled = fabsf(value) * 10.0f + 0.5f;
+  uint32_t tenths = (uint32_t)(scaled < 999999999.0f ? scaled : 999999999.0f);
+  char reversed[12];
+  size_t count = 0;
+  reversed[count++] = '0' + tenths % 10;
+  reversed[count++] = '.';
+  tenths /= 10;
+  do {
+    reversed[count++] = '0' + tenths % 10;
+    tenths /= 10;
+  } while (tenths > 0);
+  if (value < 0) {
+    reversed[count++] = '-';
+  }
+  for (size_t i = 0; i < count; i++) {
+    out[i] = reversed[count - 1 - i];
+  }
+  return count;
+}
+
+/// The index of a character of format_tenths() in OLED_GLYPHS
+inline uint8_t glyph_index(char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  return c == '-' ? 10 : c == '.' ? 11 : 12;
+}
+
+/**
+ * @brief The glyph table of OledPages, and a value drawn into a row with it
+ *
+ * A row image is one display page, OLED_WIDTH one-byte columns. In rotation
+ * 2 the columns run backwards, so cell 0 is at the right end.
+ *
+ * No Arduino dependency, so it can be tested on a host.
+ */
+class OledGlyphs {
+ public:
+  uint8_t table[OLED_GLYPH_COUNT][OLED_CELL];
+  bool flipped = false;
+
+  /// The first column of a cell in the page
+  size_t column(uint8_t cell) const {
+    return flipped ? OLED_WIDTH - (cell + 1) * OLED_CELL : cell * OLED_CELL;
+  }
+
+  /// The cells of a field, first up to end, from the label image, then the
+  /// value from value_cell on; what doesn't fit before end is cut off
+  void draw(uint8_t* image, const uint8_t* label_image, uint8_t first,
+            uint8_t end, uint8_t value_cell, float value) const {
+    for (uint8_t cell = first; cell < end; cell++) {
+      memcpy(image + column(cell), label_image + column(cell), OLED_CELL);
+    }
+    char text[12];
+    size_t count = format_tenths(value, text);
+    uint8_t cell = value_cell;
+    for (size_t i = 0; i < count && cell < end; i++, cell++) {
+      memcpy(image + column(cell), table[glyph_index(text[i])], OLED_CELL);
+    }
+  }
+};
+
+}  // namespace sensesp
+
+#endif
@@ -0,0 +1,187 @@
+#include "system/oled_pages.h"
+
+#include "sensesp.h"
+#include "system/latency_trace.h"
+#include "system/phase_scheduler.h"
+
+// SSD1306 I2C control bytes and addressing commands
+#define SSD1306_CONTROL_COMMANDS 0x00
+#define SSD1306_CONTROL_DATA 0x40
+#define SSD1306_SET_COLUMNS 0x21
+#define SSD1306_SET_PAGES 0x22
+
+namespace sensesp {
+
+OledPages::OledPages(Adafruit_SSD1306* display, TwoWire* i2c, uint8_t address)
+    : display{display},
+      i2c{i2c},
+      address{address},
+      buffer{display->getBuffer()},
+      flipped{display->getRotation() == 2} {
+  glyphs.flipped = flipped;
+  uint8_t image[OLED_WIDTH];
+  render(0, 0, OLED_GLYPHS, image);
+  for (uint8_t i = 0; i < OLED_GLYPH_COUNT; i++) {
+    memcpy(glyphs.table[i], image + column(i), OLED_CELL);
+  }
+}
+
+void OledPages::show(uint8_t row, const char* label, float value,
+                     uint8_t field) {
+  if (row >= OLED_PAGES || field >= OLED_FIELDS) {
+    return;
+  }
+  uint32_t start = ESP.getCycleCount();
+  use_label(row, field, label, false);
+  // the other field of the row stays as it is
+  uint8_t image[OLED_WIDTH];
+  memcpy(image, page(row), OLED_WIDTH);
+  glyphs.draw(image, label_images[row], field == 0 ? 0 : OLED_FIELD_CELL,
+              field_end(row, field), label_cells[row][field], value);
+  compose(row, image, LatencyTrace::current());
+
+  uint32_t cycles = ESP.getCycleCount() - start;
+  updates++;
+  update_cycles += cycles;
+  update_max_cycles = max(update_max_cycles, cycles);
+}
+
+void OledPages::show(uint8_t row, const char* label) {
+  if (row >= OLED_PAGES) {
+    return;
+  }
+  use_label(row, 0, label, true);
+  compose(row, label_images[row]);
+}
+
+void OledPages::clear_row(uint8_t row) {
+  if (row >= OLED_PAGES) {
+    return;
+  }
+  static const uint8_t blank[OLED_WIDTH] = {};
+  compose(row, blank);
+}
+
+void OledPages::clear() {
+  for (uint8_t row = 0; row < OLED_PAGES; row++) {
+    clear_row(row);
+  }
+}
+
+void OledPages::start() {
+  // the panel's RAM holds whatever it powered up with, send every page once
+  dirty = 0xFF;
+  PhaseScheduler::add("display", OLED_FLUSH_MS, [this]() { flush(); });
+}
+
+void OledPages::report() const {
+  debugI("Display: %lu row updates, %lu cycles mean, %lu max; %lu pages sent, "
+         "%lu us max",
+         (unsigned long)updates,
+         (unsigned long)(updates > 0 ? update_cycles / updates : 0),
+         (unsigned long)update_max_cycles, (unsigned long)pages_sent,
+         (unsigned long)flush_max_us);
+}
+
+// Draw text from a cell on a blank row with the GFX font and copy the page
+// out; the buffer is left as it was
+void OledPages::render(uint8_t row, uint8_t cell, const char* text,
+                       uint8_t* image) {
+  char line[OLED_ROW_CELLS + 1];
+  snprintf(line, sizeof(line) - cell, "%s", text);
+  uint8_t* target = page(row);
+  uint8_t saved[OLED_WIDTH];
+  memcpy(saved, target, OLED_WIDTH);
+  memset(target, 0, OLED_WIDTH);
+  display->setCursor(cell * OLED_CELL, 8 * row);
+  display->print(line);
+  memcpy(image, target, OLED_WIDTH);
+  memcpy(target, saved, OLED_WIDTH);
+}
+
+void OledPages::use_label(uint8_t row, uint8_t field, const char* label,
+                          bool only) {
+  if (labels[row][field] == label && label_only[row] == only) {
+    return;
+  }
+  if (only) {
+    // a label on its own takes the whole row
+    labels[row][1] = nullptr;
+  }
+  uint8_t first = field == 0 ? 0 : OLED_FIELD_CELL;
+  char text[OLED_ROW_CELLS + 1];
+  snprintf(text, sizeof(text) - first, only ? "%s" : "%s: ", label);
+  // into the field's cells only, the other field's label stays
+  uint8_t image[OLED_WIDTH];
+  render(row, first, text, image);
+  for (uint8_t cell = first; cell < field_end(row, field); cell++) {
+    memcpy(label_images[row] + column(cell), image + column(cell), OLED_CELL);
+  }
+  labels[row][field] = label;
+  label_only[row] = only;
+  label_cells[row][field] = first + strlen(text);
+}
+
+void OledPages::compose(uint8_t row, const uint8_t* image,
+                        uint32_t acquired_us) {
+  uint8_t* target = page(row);
+  if (memcmp(target, image, OLED_WIDTH) != 0) {
+    memcpy(target, image, OLED_WIDTH);
+    dirty |= 1 << page_of(row);
+#ifdef LATENCY_TRACE
+    acquired[page_of(row)] = acquired_us;
+#endif
+  }
+}
+
+// Send one changed page, round robin, so a fast row can't hold up the others
+void OledPages::flush() {
+  for (uint8_t i = 0; i < OLED_PAGES && dirty != 0; i++) {
+    uint8_t page = (next_page + i) % OLED_PAGES;
+    if (dirty & (1 << page)) {
+      dirty &= ~(1 << page);
+      if (!send_page(page)) {
+        dirty |= 1 << page;
+      }
+      next_page = (page + 1) % OLED_PAGES;
+      return;
+    }
+  }
+}
+
+bool OledPages::send_page(uint8_t page) {
+  uint32_t start = micros();
+  uint32_t clock = i2c->getClock();
+  i2c->setClock(OLED_I2C_CLOCK);
+
+  static const uint8_t columns[] = {SSD1306_SET_COLUMNS, 0, OLED_WIDTH - 1};
+  i2c->beginTransmission(address);
+  i2c->write(SSD1306_CONTROL_COMMANDS);
+  i2c->write(columns, sizeof(columns));
+  i2c->write(SSD1306_SET_PAGES);
+  i2c->write(page);
+  i2c->write(page);
+  bool ok = i2c->endTransmission() == 0;
+
+  const uint8_t* data = buffer + page * OLED_WIDTH;
+  for (size_t sent = 0; ok && sent < OLED_WIDTH; sent += OLED_I2C_CHUNK) {
+    i2c->beginTransmission(address);
+    i2c->write(SSD1306_CONTROL_DATA);
+    i2c->write(data + sent, OLED_I2C_CHUNK);
+    ok = i2c->endTransmission() == 0;
+  }
+
+  i2c->setClock(clock);
+  if (ok) {
+    pages_sent++;
+#ifdef LATENCY_TRACE
+    // the value is on the panel only now
+    LatencyTrace::record(LatencySink::display, acquired[page]);
+    acquired[page] = 0;
+#endif
+  }
+  flush_max_us = max(flush_max_us, micros() - start);
+  return ok;
+}
+
+}  // namespace sensesp
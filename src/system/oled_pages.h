@@ -0,0 +1,107 @@
+#ifndef _oled_pages_H_
+#define _oled_pages_H_
+
+#include <Adafruit_SSD1306.h>
+#include <Arduino.h>
+#include <Wire.h>
+
+#include "system/oled_glyphs.h"
+
+// one changed page is sent this often
+#define OLED_FLUSH_MS 20
+#define OLED_I2C_CLOCK 400000
+// page data bytes per I2C transaction
+#define OLED_I2C_CHUNK 32
+
+namespace sensesp {
+
+/**
+ * @brief Text rows on the SSD1306, without the GFX text renderer on the
+ * sample path
+ *
+ * Each text row is one page of the display buffer. The first time a row shows
+ * a label, "label: " is drawn once with the GFX font and the page kept as the
+ * row's label image. The digits, sign and decimal point are drawn once in the
+ * constructor into a glyph table, in the display's rotation. An update copies
+ * the label image, formats the value with one decimal and copies in one
+ * 6-byte glyph per character; no GFX call, no printf.
+ *
+ * A page that comes out the same as before isn't touched. Changed pages are
+ * marked, and start() sends one of them every OLED_FLUSH_MS, oldest row
+ * first, instead of the whole 1 KB buffer for every value. A row updated at
+ * 10 Hz then costs one 128-byte I2C write per update.
+ *
+ * Two values can share a row: field 1 starts at OLED_FIELD_CELL, and field 0
+ * then ends there instead of at the end of the row. Each field keeps its own
+ * label in the row's label image.
+ *
+ * Only rotations 0 and 2 are handled: in both, a text row is exactly a page.
+ * report() logs the CPU cycles per row update and the flush times. With
+ * LATENCY_TRACE, each page keeps the acquisition time of its value and the
+ * display latency is recorded once the page has been written to the panel.
+ */
+class OledPages {
+ public:
+  OledPages(Adafruit_SSD1306* display, TwoWire* i2c, uint8_t address = 0x3C);
+
+  /// "label: value" on a text row, in field 0 or, on a shared row, field 1.
+  /// The label is drawn once per field, keyed by its pointer, so it must be
+  /// a literal or a buffer that doesn't change.
+  void show(uint8_t row, const char* label, float value, uint8_t field = 0);
+
+  /// Just the label on a text row
+  void show(uint8_t row, const char* label);
+
+  void clear_row(uint8_t row);
+  void clear();
+
+  /// Start sending the changed pages
+  void start();
+
+  void report() const;
+
+ private:
+  Adafruit_SSD1306* display;
+  TwoWire* i2c;
+  uint8_t address;
+  uint8_t* buffer;
+  bool flipped;
+
+  OledGlyphs glyphs;
+  const char* labels[OLED_PAGES][OLED_FIELDS] = {};
+  bool label_only[OLED_PAGES] = {};
+  uint8_t label_cells[OLED_PAGES][OLED_FIELDS] = {};  // where the value starts
+  uint8_t label_images[OLED_PAGES][OLED_WIDTH] = {};
+
+  uint8_t dirty = 0;  // one bit per page
+  uint8_t next_page = 0;
+#ifdef LATENCY_TRACE
+  uint32_t acquired[OLED_PAGES] = {};  // of the value on the page, 0 if none
+#endif
+
+  uint32_t updates = 0;
+  uint64_t update_cycles = 0;
+  uint32_t update_max_cycles = 0;
+  uint32_t pages_sent = 0;
+  uint32_t flush_max_us = 0;
+
+  uint8_t page_of(uint8_t row) const {
+    return flipped ? OLED_PAGES - 1 - row : row;
+  }
+  uint8_t* page(uint8_t row) { return buffer + page_of(row) * OLED_WIDTH; }
+  size_t column(uint8_t cell) const { return glyphs.column(cell); }
+
+  void render(uint8_t row, uint8_t cell, const char* text, uint8_t* image);
+  void use_label(uint8_t row, uint8_t field, const char* label, bool only);
+  uint8_t field_end(uint8_t row, uint8_t field) const {
+    return field == 0 && labels[row][1] != nullptr ? OLED_FIELD_CELL
+                                                   : OLED_ROW_CELLS;
+  }
+  void compose(uint8_t row, const uint8_t* image, uint32_t acquired_us = 0);
+  void flush();
+  bool send_page(uint8_t page);
+};
+
+}  // namespace sensesp
+
+#endif
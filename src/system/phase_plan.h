@@ -0,0 +1,146 @@
+#ifndef _phase_plan_H_
+#define _phase_plan_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// periodic tasks the scheduler can hold
+#define PHASE_MAX_TASKS 32
+// longest hyperperiod the offsets are planned over, in slots
+#define PHASE_MAX_SLOTS 200
+// offset of a task that doesn't count towards the load yet
+#define PHASE_UNPLACED 0xFFFF
+
+namespace sensesp {
+
+struct PhaseTask {
+  uint16_t period;   // in slots
+  uint16_t offset;   // in slots, < period
+  uint32_t cost_us;  // worst-case run time
+  bool fixed;        // placed once, stagger() doesn't move it
+};
+
+/**
+ * @brief The offsets of PhaseScheduler's tasks
+ *
+ * Every task runs in the slots where slot % period == offset. The plan puts
+ * each task at the offset that keeps the highest slot load over the
+ * hyperperiod lowest, given the tasks placed before it.
+ *
+ * No Arduino dependency, so it can be tested on a host.
+ */
+class PhasePlan {
+ public:
+  PhaseTask tasks[PHASE_MAX_TASKS];
+  size_t count = 0;
+
+  /// A new task at offset 0, or -1 when the plan is full
+  int add(uint16_t period, uint32_t cost_us = 0, bool fixed = false) {
+    if (count == PHASE_MAX_TASKS) {
+      return -1;
+    }
+    tasks[count] = PhaseTask{period, 0, cost_us, fixed};
+    return count++;
+  }
+
+  /// The least common multiple of the task periods, as far as it fits.
+  /// Tasks with a period that doesn't divide it are planned approximately.
+  uint32_t hyperperiod() const {
+    uint32_t slots = 1;
+    for (size_t i = 0; i < count; i++) {
+      uint32_t lcm = slots / gcd(slots, tasks[i].period) * tasks[i].period;
+      if (lcm <= PHASE_MAX_SLOTS) {
+        slots = lcm;
+      }
+    }
+    return slots;
+  }
+
+  /// Give a task the offset with the lowest peak slot load
+  void place(size_t index) {
+    uint32_t slots = hyperperiod();
+    load(index, slots);
+    PhaseTask& task = tasks[index];
+    uint32_t span = task.period < slots ? task.period : slots;
+    uint32_t best_peak = UINT32_MAX;
+    uint16_t best_offset = 0;
+    for (uint32_t offset = 0; offset < span; offset++) {
+      uint32_t peak = 0;
+      for (uint32_t s = offset; s < slots; s += task.period) {
+        peak = loads[s] > peak ? loads[s] : peak;
+      }
+      if (peak < best_peak) {
+        best_peak = peak;
+        best_offset = offset;
+      }
+    }
+    task.offset = best_offset;
+  }
+
+  /// Place all tasks that aren't fixed, most expensive first, around the
+  /// fixed ones
+  void stagger() {
+    size_t order[PHASE_MAX_TASKS];
+    size_t n = 0;
+    for (size_t i = 0; i < count; i++) {
+      if (tasks[i].fixed) {
+        continue;
+      }
+      // a task counts towards the load only once it has been placed
+      tasks[i].offset = PHASE_UNPLACED;
+      order[n] = i;
+      for (size_t j = n; j > 0 && tasks[order[j]].cost_us >
+                                      tasks[order[j - 1]].cost_us; j--) {
+        size_t t = order[j];
+        order[j] = order[j - 1];
+        order[j - 1] = t;
+      }
+      n++;
+    }
+    for (size_t i = 0; i < n; i++) {
+      place(order[i]);
+    }
+  }
+
+  /// The highest slot load over the hyperperiod, in us
+  uint32_t peak() {
+    uint32_t slots = hyperperiod();
+    load(count, slots);
+    uint32_t peak = 0;
+    for (uint32_t s = 0; s < slots; s++) {
+      peak = loads[s] > peak ? loads[s] : peak;
+    }
+    return peak;
+  }
+
+ private:
+  uint32_t loads[PHASE_MAX_SLOTS];
+
+  static uint32_t gcd(uint32_t a, uint32_t b) {
+    while (b != 0) {
+      uint32_t t = a % b;
+      a = b;
+      b = t;
+    }
+    return a;
+  }
+
+  // The load of every slot from the placed tasks, except the one at skip
+  void load(size_t skip, uint32_t slots) {
+    memset(loads, 0, sizeof(loads));
+    for (size_t i = 0; i < count; i++) {
+      const PhaseTask& task = tasks[i];
+      if (i == skip || task.offset == PHASE_UNPLACED) {
+        continue;
+      }
+      for (uint32_t s = task.offset % slots; s < slots; s += task.period) {
+        loads[s] += task.cost_us;
+      }
+    }
+  }
+};
+
+}  // namespace sensesp
+
+#endif
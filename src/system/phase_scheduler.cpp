@@ -0,0 +1,144 @@
+#include "system/phase_scheduler.h"
+
+#include "sensesp.h"
+
+namespace sensesp {
+
+PhaseScheduler::Task PhaseScheduler::tasks[PHASE_MAX_TASKS];
+PhasePlan PhaseScheduler::plan;
+bool PhaseScheduler::staggered = false;
+uint32_t PhaseScheduler::slot_now = 0;
+uint32_t PhaseScheduler::last_ms = 0;
+uint32_t PhaseScheduler::worst_us = 0;
+uint32_t PhaseScheduler::aligned_worst_us = 0;
+
+static uint16_t to_slots(uint32_t period_ms) {
+  return (uint16_t)constrain((period_ms + PHASE_SLOT_MS / 2) / PHASE_SLOT_MS,
+                             1UL, 0xFFFFUL);
+}
+
+int PhaseScheduler::add(const char* name, uint32_t period_ms,
+                        std::function<void()> callback) {
+  int index = plan.add(to_slots(period_ms));
+  if (index < 0) {
+    debugE("Phase scheduler full, %s runs unstaggered", name);
+    ReactESP::app->onRepeat(period_ms, callback);
+    return -1;
+  }
+  Task& task = tasks[index];
+  task.name = name;
+  task.callback = callback;
+  task.once = false;
+  if (staggered) {
+    plan.place(index);
+  }
+  task.next_slot = align(index, slot_now);
+  return index;
+}
+
+int PhaseScheduler::add_started(const char* name, uint32_t period_ms,
+                                uint32_t cost_us,
+                                std::function<void()> start) {
+  int index = plan.add(to_slots(period_ms), cost_us, true);
+  if (index < 0) {
+    debugE("Phase scheduler full, %s starts unstaggered", name);
+    start();
+    return -1;
+  }
+  Task& task = tasks[index];
+  task.name = name;
+  task.callback = start;
+  task.once = true;
+  plan.place(index);
+  task.next_slot = align(index, slot_now);
+  return index;
+}
+
+void PhaseScheduler::set_period(int task, uint32_t period_ms) {
+  if (task < 0 || (size_t)task >= plan.count || tasks[task].once) {
+    return;
+  }
+  plan.tasks[task].period = to_slots(period_ms);
+  plan.tasks[task].offset = 0;
+  if (staggered) {
+    plan.place(task);
+  }
+  tasks[task].next_slot = align(task, slot_now);
+}
+
+void PhaseScheduler::start() {
+  last_ms = millis();
+  ReactESP::app->onRepeat(PHASE_SLOT_MS, []() { tick(); });
+  ReactESP::app->onDelay(PHASE_LEARN_MS, []() {
+    aligned_worst_us = worst_us;
+    worst_us = 0;
+    stagger();
+    ReactESP::app->onDelay(PHASE_LEARN_MS, []() { report(); });
+  });
+}
+
+// The first slot at or after from that the task runs in
+uint32_t PhaseScheduler::align(size_t index, uint32_t from) {
+  const PhaseTask& task = plan.tasks[index];
+  return from + (task.offset + task.period - from % task.period) % task.period;
+}
+
+void PhaseScheduler::tick() {
+  // count slots from the clock, so a late tick (or a light sleep) doesn't
+  // stretch the periods
+  uint32_t now = millis();
+  uint32_t slots = (now - last_ms) / PHASE_SLOT_MS;
+  slot_now += slots;
+  last_ms += slots * PHASE_SLOT_MS;
+
+  uint32_t tick_start = micros();
+  for (size_t i = 0; i < plan.count; i++) {
+    Task& task = tasks[i];
+    if (!task.callback || (int32_t)(slot_now - task.next_slot) < 0) {
+      continue;
+    }
+    if (task.once) {
+      // from here on the reaction repeats by itself, at this phase
+      task.callback();
+      task.callback = nullptr;
+      continue;
+    }
+    uint32_t start = micros();
+    task.callback();
+    uint32_t cost = micros() - start;
+    if (cost > plan.tasks[i].cost_us) {
+      plan.tasks[i].cost_us = cost;
+    }
+    // run once, however many slots were missed
+    task.next_slot = align(i, slot_now + 1);
+  }
+  uint32_t elapsed = micros() - tick_start;
+  if (elapsed > worst_us) {
+    worst_us = elapsed;
+  }
+}
+
+// Place the measured tasks around the started ones
+void PhaseScheduler::stagger() {
+  staggered = true;
+  plan.stagger();
+  for (size_t i = 0; i < plan.count; i++) {
+    if (!plan.tasks[i].fixed) {
+      tasks[i].next_slot = align(i, slot_now);
+    }
+  }
+}
+
+void PhaseScheduler::report() {
+  for (size_t i = 0; i < plan.count; i++) {
+    const PhaseTask& task = plan.tasks[i];
+    debugI("Phase: %-14s every %5lu ms at +%4lu ms, %6lu us", tasks[i].name,
+           (unsigned long)task.period * PHASE_SLOT_MS,
+           (unsigned long)task.offset * PHASE_SLOT_MS,
+           (unsigned long)task.cost_us);
+  }
+  debugI("Phase: worst tick %lu us aligned, %lu us staggered",
+         (unsigned long)aligned_worst_us, (unsigned long)worst_us);
+}
+
+}  // namespace sensesp
@@ -0,0 +1,88 @@
+#ifndef _phase_scheduler_H_
+#define _phase_scheduler_H_
+
+#include <Arduino.h>
+
+#include <functional>
+
+#include "system/phase_plan.h"
+
+// scheduling granularity
+#define PHASE_SLOT_MS 10
+// how long costs are measured before the offsets are assigned, and again
+// afterwards for the report
+#define PHASE_LEARN_MS 10000
+
+namespace sensesp {
+
+/**
+ * @brief Spread the periodic tasks of the board over their periods
+ *
+ * Most sensors run on round periods, 100, 200, 500 or 1000 ms, and all of them
+ * start at boot, so without offsets they all fire on the same loop tick every
+ * second and leave the ticks in between idle. The scheduler runs its tasks
+ * from a single PHASE_SLOT_MS reaction instead of one onRepeat each. Every
+ * task runs in the slots where slot % period == offset.
+ *
+ * For the first PHASE_LEARN_MS after start() all offsets are 0, the old
+ * behaviour, and the scheduler records the worst-case cost of every task and
+ * of every slot. It then places the tasks, most expensive first, at the offset
+ * that keeps the highest slot load over the hyperperiod lowest, measures
+ * another PHASE_LEARN_MS and logs both worst-case slot durations and the
+ * offsets with report().
+ *
+ * A reaction that library code registers by itself, e.g. the 1-Wire
+ * temperature sensor's, can still be given a phase with add_started(): its
+ * start is deferred to the slot of its offset, and it keeps that phase from
+ * then on. Its cost is declared, it can't be measured. SensESP's own
+ * reactions are outside the scheduler.
+ */
+class PhaseScheduler {
+ public:
+  /// Run callback every period_ms; returns the task, or -1 when the
+  /// scheduler is full and the task was handed to ReactESP instead
+  static int add(const char* name, uint32_t period_ms,
+                 std::function<void()> callback);
+
+  /// Call start once, in the slot of an offset of its own, for a reaction
+  /// that repeats every period_ms from when it is started and costs cost_us.
+  /// It is placed at once and stays there; when the scheduler is full it is
+  /// started right away.
+  static int add_started(const char* name, uint32_t period_ms,
+                         uint32_t cost_us, std::function<void()> start);
+
+  /// Change the period of a task, e.g. for a power profile
+  static void set_period(int task, uint32_t period_ms);
+
+  /// Start running the tasks; offsets are assigned after PHASE_LEARN_MS
+  static void start();
+
+  /// Longest slot since the offsets were assigned, in us
+  static uint32_t worst_tick_us() { return worst_us; }
+
+  static void report();
+
+ private:
+  struct Task {
+    const char* name;
+    std::function<void()> callback;
+    uint32_t next_slot;
+    bool once;  // a deferred start, callback is cleared once it has run
+  };
+
+  static Task tasks[PHASE_MAX_TASKS];
+  static PhasePlan plan;  // periods, offsets and costs, by task
+  static bool staggered;
+  static uint32_t slot_now;
+  static uint32_t last_ms;
+  static uint32_t worst_us;
+  static uint32_t aligned_worst_us;
+
+  static void tick();
+  static void stagger();
+  static uint32_t align(size_t index, uint32_t from);
+};
+
+}  // namespace sensesp
+
+#endif
@@ -0,0 +1,168 @@
+#ifdef STRESS_TEST
+
+#include "system/stress_test.h"
+
+#include <N2kMessages.h>
+
+#include "sensesp.h"
+#include "sensesp/sensors/sensor.h"
+#include "sensesp/signalk/signalk_output.h"
+#include "sensesp/system/lambda_consumer.h"
+#include "sensesp/transforms/linear.h"
+#include "system/boot_arena.h"
+
+// N2K temperature instances of the synthetic sources start here, clear of
+// the real ones
+#define STRESS_N2K_INSTANCE 16
+
+namespace sensesp {
+
+StressTest::StressTest(N2kTxQueue* n2k_tx, String config_path)
+    : Configurable(config_path), n2k_tx{n2k_tx} {
+  load_configuration();
+}
+
+void StressTest::start() {
+  ReactESP::app->onTick([this]() {
+    uint32_t now = micros();
+    if (last_tick_us != 0) {
+      uint32_t gap = now - last_tick_us;
+      tick_max_us = max(tick_max_us, gap);
+      tick_sum_us += gap;
+      tick_count++;
+    }
+    last_tick_us = now;
+  });
+  ReactESP::app->onRepeat(100, [this]() {
+    heap_free_min = min(heap_free_min, ESP.getFreeHeap());
+  });
+  ReactESP::app->onRepeat(step_ms, [this]() {
+    if (done) {
+      return;
+    }
+    if (sources > 0) {
+      end_step();
+    }
+    if (done || sources >= max_sources) {
+      done = true;
+      report();
+      return;
+    }
+    add_sources(min(step_sources, (uint16_t)(max_sources - sources)));
+  });
+  add_sources(step_sources);
+}
+
+// Sources are created after the app has started, so they're started here;
+// like every object made after boot, they live on the heap.
+void StressTest::add_sources(uint16_t count) {
+  for (uint16_t i = 0; i < count; i++) {
+    uint16_t n = sources++;
+    auto* sensor = new RepeatSensor<float>(period_ms, [n]() {
+      // a slow wave, different for every source
+      return 300.0f + 10.0f * sinf((millis() + 97 * n) / 1000.0f);
+    });
+    auto* linear = new Linear(1.0, 0.0, "");
+    sensor->connect_to(linear);
+    linear->connect_to(new SKOutputFloat(String("stress.") + n, ""));
+    linear->connect_to(new LambdaConsumer<float>([this, n](float value) {
+      emissions++;
+      tN2kMsg N2kMsg;
+      SetN2kTemperature(N2kMsg, 1, (STRESS_N2K_INSTANCE + n) & 0xFF,
+                        N2kts_EngineRoomTemperature, value);
+      n2k_tx->send(N2kMsg, (STRESS_N2K_INSTANCE + n) & 0xFF);
+    }));
+    sensor->start();
+  }
+  // the next step starts from here
+  emissions = 0;
+  tick_max_us = 0;
+  tick_sum_us = 0;
+  tick_count = 0;
+  heap_free_min = ESP.getFreeHeap();
+  step_started_ms = millis();
+}
+
+void StressTest::end_step() {
+  StressStep step;
+  uint32_t elapsed_ms = max(millis() - step_started_ms, 1UL);
+  step.sources = sources;
+  step.emissions_per_s = (uint64_t)emissions * 1000 / elapsed_ms;
+  step.tick_max_us = tick_max_us;
+  step.tick_mean_us = tick_count > 0 ? tick_sum_us / tick_count : 0;
+  step.heap_free_min = heap_free_min;
+  step.heap_low_water = ESP.getMinFreeHeap();
+  debugI("Stress: %3u sources %6lu values/s, tick max %7lu us mean %5lu us, "
+         "heap min %6lu low water %6lu",
+         step.sources, (unsigned long)step.emissions_per_s,
+         (unsigned long)step.tick_max_us, (unsigned long)step.tick_mean_us,
+         (unsigned long)step.heap_free_min,
+         (unsigned long)step.heap_low_water);
+  if (step_count < STRESS_MAX_STEPS) {
+    steps[step_count++] = step;
+  }
+  if (step.heap_free_min < HEAP_FLOOR_BYTES) {
+    debugW("Stress: free heap below the floor, sweep ends");
+    done = true;
+  } else if (step.tick_max_us > tick_limit_ms * 1000) {
+    debugW("Stress: loop tick above the limit, sweep ends");
+    done = true;
+  }
+}
+
+// The capacity curve, one line per step
+void StressTest::report() const {
+  debugI("Stress: sources values/s tick max us tick mean us heap min low water");
+  for (size_t i = 0; i < step_count; i++) {
+    const StressStep& step = steps[i];
+    debugI("Stress: %7u %8lu %11lu %12lu %8lu %9lu", step.sources,
+           (unsigned long)step.emissions_per_s,
+           (unsigned long)step.tick_max_us, (unsigned long)step.tick_mean_us,
+           (unsigned long)step.heap_free_min,
+           (unsigned long)step.heap_low_water);
+  }
+}
+
+void StressTest::get_configuration(JsonObject& root) {
+  root["period"] = period_ms;
+  root["step_sources"] = step_sources;
+  root["max_sources"] = max_sources;
+  root["step"] = step_ms;
+  root["tick_limit"] = tick_limit_ms;
+  root["sources"] = sources;
+}
+
+static const char SCHEMA[] PROGMEM = R"###({
+    "type": "object",
+    "properties": {
+        "period": { "title": "Source period", "type": "integer", "description": "Time between values of one synthetic source, in milliseconds" },
+        "step_sources": { "title": "Sources per step", "type": "integer" },
+        "max_sources": { "title": "Maximum sources", "type": "integer" },
+        "step": { "title": "Step duration", "type": "integer", "description": "In milliseconds" },
+        "tick_limit": { "title": "Tick limit", "type": "integer", "description": "The sweep ends when a loop tick takes longer, in milliseconds" },
+        "sources": { "title": "Sources now", "type": "integer", "readOnly": true }
+    }
+  })###";
+
+String StressTest::get_config_schema() { return FPSTR(SCHEMA); }
+
+// applied after a restart, the sweep starts at boot
+bool StressTest::set_configuration(const JsonObject& config) {
+  String expected[] = {"period", "step_sources", "max_sources", "step",
+                       "tick_limit"};
+  for (auto str : expected) {
+    if (!config.containsKey(str)) {
+      return false;
+    }
+  }
+  period_ms = config["period"];
+  step_sources = max((int)config["step_sources"], 1);
+  max_sources = config["max_sources"];
+  step_ms = config["step"];
+  tick_limit_ms = config["tick_limit"];
+  return true;
+}
+
+}  // namespace sensesp
+
+#endif
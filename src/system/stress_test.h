@@ -0,0 +1,88 @@
+#ifndef _stress_test_H_
+#define _stress_test_H_
+
+#include <Arduino.h>
+
+#include "sensesp/system/configurable.h"
+#include "system/config_store.h"
+#include "system/n2k_tx_queue.h"
+
+// steps of the sweep kept for the final report
+#define STRESS_MAX_STEPS 32
+
+namespace sensesp {
+
+/// What one step of the sweep measured
+struct StressStep {
+  uint16_t sources;
+  uint32_t emissions_per_s;  // values that made it through to the consumers
+  uint32_t tick_max_us;      // longest time between two loop ticks
+  uint32_t tick_mean_us;
+  uint32_t heap_free_min;    // lowest free heap seen during the step
+  uint32_t heap_low_water;   // lowest free heap since boot
+};
+
+/**
+ * @brief Synthetic load, to find how many channels the board can carry
+ *
+ * Only built with -D STRESS_TEST (see the esp32dev_stress_test environment
+ * in platformio.ini). Every step_ms the sweep adds step_sources synthetic
+ * sensors, each a RepeatSensor emitting every period_ms into the same kind of
+ * graph a real channel has: a Linear transform, an SKOutputFloat on
+ * stress.<n>, and a LambdaConsumer that sends PGN 130312 through the N2K
+ * transmit queue.
+ *
+ * During each step the loop tick interval, the free heap and the values
+ * reaching the consumers are recorded, and one line per step is logged. The
+ * sweep ends at max_sources, or early once the free heap drops below
+ * HEAP_FLOOR_BYTES or a tick takes longer than tick_limit_ms; the whole curve
+ * is logged again at the end.
+ *
+ * test/test_stress runs the same sweep on the host, in [env:native]: the
+ * sources go through StageChain, UDPPacket and a PGN 130312 frame instead of
+ * the SensESP graph.
+ */
+class StressTest : public Configurable {
+ public:
+  StressTest(N2kTxQueue* n2k_tx, String config_path = "");
+
+  /// Start the sweep; needs the SensESP app
+  void start();
+
+  virtual void load_configuration() override { ConfigStore::load(this); }
+  virtual void save_configuration() override { ConfigStore::save(this); }
+  virtual void get_configuration(JsonObject& root) override;
+  virtual bool set_configuration(const JsonObject& config) override;
+  virtual String get_config_schema() override;
+
+ private:
+  N2kTxQueue* n2k_tx;
+  uint32_t period_ms = 100;
+  uint16_t step_sources = 8;
+  uint16_t max_sources = 128;
+  uint32_t step_ms = 30000;
+  uint32_t tick_limit_ms = 100;
+
+  uint16_t sources = 0;
+  bool done = false;
+
+  // the current step
+  uint32_t emissions = 0;
+  uint32_t last_tick_us = 0;
+  uint32_t tick_max_us = 0;
+  uint64_t tick_sum_us = 0;
+  uint32_t tick_count = 0;
+  uint32_t heap_free_min = UINT32_MAX;
+  uint32_t step_started_ms = 0;
+
+  StressStep steps[STRESS_MAX_STEPS];
+  size_t step_count = 0;
+
+  void add_sources(uint16_t count);
+  void end_step();
+  void report() const;
+};
+
+}  // namespace sensesp
+
+#endif
@@ -0,0 +1,143 @@
+// AlarmState, the debounce and hysteresis behind EngineAlarms::evaluate()
+#include <unity.h>
+
+#include <chrono>
+#include <stdio.h>
+
+#include "engine/alarm_state.h"
+
+using namespace sensesp;
+
+// the parameters of two rules in ALARM_RULES: coolantHigh and chargeLow
+const float COOLANT_HIGH = 368.15f;
+const float COOLANT_HYSTERESIS = 3.0f;
+const uint8_t COOLANT_DEBOUNCE = 1;
+const float CHARGE_LOW = 13.0f;
+const float CHARGE_HYSTERESIS = 0.3f;
+const uint8_t CHARGE_DEBOUNCE = 3;
+
+AlarmState state;
+
+void setUp(void) { state = AlarmState(); }
+
+void tearDown(void) {}
+
+bool coolant(float value) {
+  return state.update(value, true, COOLANT_HIGH, COOLANT_HYSTERESIS,
+                      COOLANT_DEBOUNCE);
+}
+
+bool charge(float value) {
+  return state.update(value, false, CHARGE_LOW, CHARGE_HYSTERESIS,
+                      CHARGE_DEBOUNCE);
+}
+
+void test_raised_by_the_crossing_sample(void) {
+  TEST_ASSERT_FALSE(coolant(360.0f));
+  TEST_ASSERT_FALSE(coolant(COOLANT_HIGH));
+  TEST_ASSERT_FALSE(state.active);
+  TEST_ASSERT_TRUE(coolant(COOLANT_HIGH + 0.1f));
+  TEST_ASSERT_TRUE(state.active);
+  // and only reported once
+  TEST_ASSERT_FALSE(coolant(COOLANT_HIGH + 1.0f));
+}
+
+void test_held_within_the_hysteresis(void) {
+  coolant(370.0f);
+  TEST_ASSERT_FALSE(coolant(COOLANT_HIGH - 1.0f));
+  TEST_ASSERT_FALSE(coolant(COOLANT_HIGH - COOLANT_HYSTERESIS + 0.1f));
+  TEST_ASSERT_TRUE(state.active);
+  TEST_ASSERT_TRUE(coolant(COOLANT_HIGH - COOLANT_HYSTERESIS - 0.1f));
+  TEST_ASSERT_FALSE(state.active);
+}
+
+void test_no_chatter_around_the_threshold(void) {
+  int flips = 0;
+  for (int i = 0; i < 100; i++) {
+    float noise = (i % 2 == 0 ? 1.0f : -1.0f) * 0.4f * COOLANT_HYSTERESIS;
+    flips += coolant(COOLANT_HIGH + 0.5f + noise) ? 1 : 0;
+  }
+  TEST_ASSERT_EQUAL(1, flips);
+  TEST_ASSERT_TRUE(state.active);
+}
+
+void test_debounce_needs_consecutive_samples(void) {
+  TEST_ASSERT_FALSE(charge(12.5f));
+  TEST_ASSERT_FALSE(charge(12.5f));
+  // one sample back on the right side starts the count again
+  TEST_ASSERT_FALSE(charge(13.5f));
+  TEST_ASSERT_FALSE(charge(12.5f));
+  TEST_ASSERT_FALSE(charge(12.5f));
+  TEST_ASSERT_FALSE(state.active);
+  TEST_ASSERT_TRUE(charge(12.5f));
+  TEST_ASSERT_TRUE(state.active);
+}
+
+void test_debounce_and_hysteresis_to_clear(void) {
+  for (int i = 0; i < CHARGE_DEBOUNCE; i++) {
+    charge(12.0f);
+  }
+  TEST_ASSERT_TRUE(state.active);
+  // above the threshold, but not by the hysteresis
+  for (int i = 0; i < 10; i++) {
+    TEST_ASSERT_FALSE(charge(CHARGE_LOW + 0.2f));
+  }
+  TEST_ASSERT_FALSE(charge(14.0f));
+  TEST_ASSERT_FALSE(charge(14.0f));
+  TEST_ASSERT_TRUE(charge(14.0f));
+  TEST_ASSERT_FALSE(state.active);
+}
+
+void test_set_resets_the_count(void) {
+  charge(12.0f);
+  charge(12.0f);
+  state.set(false);
+  TEST_ASSERT_FALSE(charge(12.0f));
+  TEST_ASSERT_FALSE(charge(12.0f));
+  TEST_ASSERT_TRUE(charge(12.0f));
+}
+
+// The status bits change, and EngineInstance::update() sends PGN 127489, in
+// the call that sees the debounce-th sample beyond the threshold. So the
+// latency from the crossing to the CAN frame is debounce - 1 sample periods
+// plus the evaluation itself, which is timed here.
+void test_crossing_to_status_latency(void) {
+  const uint8_t debounces[] = {1, 2, 3, 5};
+  for (uint8_t debounce : debounces) {
+    AlarmState alarm;
+    int samples = 0;
+    while (!alarm.update(COOLANT_HIGH + 1.0f, true, COOLANT_HIGH,
+                         COOLANT_HYSTERESIS, debounce)) {
+      samples++;
+      TEST_ASSERT_LESS_THAN(debounce, samples);
+    }
+    TEST_ASSERT_EQUAL(debounce - 1, samples);
+  }
+
+  const int rounds = 1000000;
+  int flips = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < rounds; i++) {
+    float value = (i / 50) % 2 == 0 ? 360.0f : 375.0f;
+    flips += coolant(value) ? 1 : 0;
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  double ns = std::chrono::duration<double, std::nano>(elapsed).count() / rounds;
+  // one flip at the start of every block of 50 but the first
+  TEST_ASSERT_EQUAL(rounds / 50 - 1, flips);
+  char message[80];
+  snprintf(message, sizeof(message), "%.1f ns per evaluation on the host", ns);
+  TEST_MESSAGE(message);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_raised_by_the_crossing_sample);
+  RUN_TEST(test_held_within_the_hysteresis);
+  RUN_TEST(test_no_chatter_around_the_threshold);
+  RUN_TEST(test_debounce_needs_consecutive_samples);
+  RUN_TEST(test_debounce_and_hysteresis_to_clear);
+  RUN_TEST(test_set_resets_the_count);
+  RUN_TEST(test_crossing_to_status_latency);
+  return UNITY_END();
+}
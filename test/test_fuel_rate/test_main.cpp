@@ -0,0 +1,125 @@
+// fuel_table_lookup(), the grid interpolation behind FuelRate::lookup()
+#include <unity.h>
+
+#include <chrono>
+#include <stdio.h>
+
+#include "sensori/fuel_table.h"
+
+using namespace sensesp;
+
+const float RPM_MAX = 3600.0f;
+const float RPM_STEP = RPM_MAX / (FUEL_RPM_POINTS - 1);
+const float LOAD_STEP = 1.0f / (FUEL_LOAD_POINTS - 1);
+
+float rates[FUEL_LOAD_POINTS * FUEL_RPM_POINTS];
+
+float& rate(int load_point, int rpm_point) {
+  return rates[load_point * FUEL_RPM_POINTS + rpm_point];
+}
+
+float lookup(float load, float rpm) {
+  return fuel_table_lookup(rates, RPM_MAX, load, rpm);
+}
+
+// no two points the same and a different slope in every cell, so a wrong
+// cell or a swapped axis shows
+void setUp(void) {
+  for (int l = 0; l < FUEL_LOAD_POINTS; l++) {
+    for (int r = 0; r < FUEL_RPM_POINTS; r++) {
+      rate(l, r) = 0.3f + 0.1f * r * r + 1.7f * l + 0.05f * l * l * r;
+    }
+  }
+}
+
+void tearDown(void) {}
+
+void test_corners(void) {
+  const int last_load = FUEL_LOAD_POINTS - 1;
+  const int last_rpm = FUEL_RPM_POINTS - 1;
+  TEST_ASSERT_FLOAT_WITHIN(1e-5f, rate(0, 0), lookup(0.0f, 0.0f));
+  TEST_ASSERT_FLOAT_WITHIN(1e-5f, rate(0, last_rpm), lookup(0.0f, RPM_MAX));
+  TEST_ASSERT_FLOAT_WITHIN(1e-5f, rate(last_load, 0), lookup(1.0f, 0.0f));
+  TEST_ASSERT_FLOAT_WITHIN(1e-5f, rate(last_load, last_rpm),
+                           lookup(1.0f, RPM_MAX));
+}
+
+void test_every_grid_point(void) {
+  for (int l = 0; l < FUEL_LOAD_POINTS; l++) {
+    for (int r = 0; r < FUEL_RPM_POINTS; r++) {
+      TEST_ASSERT_FLOAT_WITHIN(1e-4f, rate(l, r),
+                               lookup(l * LOAD_STEP, r * RPM_STEP));
+    }
+  }
+}
+
+void test_midpoints(void) {
+  for (int l = 0; l < FUEL_LOAD_POINTS - 1; l++) {
+    for (int r = 0; r < FUEL_RPM_POINTS - 1; r++) {
+      float load = (l + 0.5f) * LOAD_STEP;
+      float rpm = (r + 0.5f) * RPM_STEP;
+      // between two RPM points, two load points, and in the cell's middle
+      TEST_ASSERT_FLOAT_WITHIN(1e-4f, 0.5f * (rate(l, r) + rate(l, r + 1)),
+                               lookup(l * LOAD_STEP, rpm));
+      TEST_ASSERT_FLOAT_WITHIN(1e-4f, 0.5f * (rate(l, r) + rate(l + 1, r)),
+                               lookup(load, r * RPM_STEP));
+      TEST_ASSERT_FLOAT_WITHIN(1e-4f,
+                               0.25f * (rate(l, r) + rate(l, r + 1) +
+                                        rate(l + 1, r) + rate(l + 1, r + 1)),
+                               lookup(load, rpm));
+    }
+  }
+}
+
+void test_quarter_point(void) {
+  // a quarter into the cell at 1/8 rated RPM and 25 % load
+  float expected = 0.75f * 0.75f * rate(1, 1) + 0.75f * 0.25f * rate(1, 2) +
+                   0.25f * 0.75f * rate(2, 1) + 0.25f * 0.25f * rate(2, 2);
+  TEST_ASSERT_FLOAT_WITHIN(1e-4f, expected,
+                           lookup(1.25f * LOAD_STEP, 1.25f * RPM_STEP));
+}
+
+void test_clamped_beyond_the_axes(void) {
+  const int last_load = FUEL_LOAD_POINTS - 1;
+  const int last_rpm = FUEL_RPM_POINTS - 1;
+  TEST_ASSERT_FLOAT_WITHIN(1e-5f, rate(0, last_rpm),
+                           lookup(0.0f, 1.2f * RPM_MAX));
+  TEST_ASSERT_FLOAT_WITHIN(1e-5f, rate(last_load, last_rpm),
+                           lookup(1.0f, 10.0f * RPM_MAX));
+  TEST_ASSERT_FLOAT_WITHIN(1e-5f, rate(last_load, last_rpm),
+                           lookup(1.5f, 1.2f * RPM_MAX));
+  TEST_ASSERT_FLOAT_WITHIN(1e-5f, rate(0, 0), lookup(-0.2f, -100.0f));
+  // halfway in load, beyond rpm_max: interpolated along the last column only
+  TEST_ASSERT_FLOAT_WITHIN(
+      1e-4f, 0.5f * (rate(1, last_rpm) + rate(2, last_rpm)),
+      lookup(1.5f * LOAD_STEP, 2.0f * RPM_MAX));
+}
+
+// Every sample costs one lookup; report what that is on the host
+void test_benchmark(void) {
+  const int rounds = 1000000;
+  volatile float sink = 0.0f;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < rounds; i++) {
+    float load = (i % 1009) / 1000.0f;
+    float rpm = (i % 4001) * 1.0f;
+    sink = sink + lookup(load, rpm);
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  double ns = std::chrono::duration<double, std::nano>(elapsed).count() / rounds;
+  TEST_ASSERT_GREATER_THAN(0.0f, sink);
+  char message[80];
+  snprintf(message, sizeof(message), "%.1f ns per lookup on the host", ns);
+  TEST_MESSAGE(message);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_corners);
+  RUN_TEST(test_every_grid_point);
+  RUN_TEST(test_midpoints);
+  RUN_TEST(test_quarter_point);
+  RUN_TEST(test_clamped_beyond_the_axes);
+  RUN_TEST(test_benchmark);
+  return UNITY_END();
+}
@@ -0,0 +1,102 @@
+// goertzel() on synthetic alternator waveforms, as AlternatorRipple sees them
+#include <unity.h>
+
+#include <math.h>
+
+#include "sensori/goertzel.h"
+
+using namespace sensesp;
+
+// the capture in AlternatorRipple: 256 samples every 150 us, 1.25 mV per LSB
+const size_t SAMPLES = 256;
+const float SAMPLE_RATE = 1e6f / 150.0f;
+const float VOLTS_PER_LSB = 0.00125f;
+const float PI = 3.14159265359f;
+
+struct Component {
+  float harmonic;
+  float volts;
+  float phase;
+};
+
+int16_t samples[SAMPLES];
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+// battery voltage plus ripple components, quantized like the INA226 does
+void generate(float electrical_hz, const Component* components, size_t count) {
+  for (size_t i = 0; i < SAMPLES; i++) {
+    float volts = 14.2f;
+    for (size_t c = 0; c < count; c++) {
+      volts += components[c].volts *
+               cosf(2.0f * PI * components[c].harmonic * electrical_hz * i /
+                        SAMPLE_RATE +
+                    components[c].phase);
+    }
+    samples[i] = (int16_t)lroundf(volts / VOLTS_PER_LSB);
+  }
+}
+
+GoertzelResult measure(float hz) {
+  float mean = sample_mean(samples, SAMPLES);
+  GoertzelResult result = goertzel(samples, SAMPLES, mean, hz / SAMPLE_RATE);
+  result.amplitude *= VOLTS_PER_LSB;
+  return result;
+}
+
+void assert_component(float electrical_hz, const Component& component) {
+  GoertzelResult result = measure(component.harmonic * electrical_hz);
+  TEST_ASSERT_FLOAT_WITHIN(0.03f * component.volts + 0.001f, component.volts,
+                           result.amplitude);
+  TEST_ASSERT_FLOAT_WITHIN(0.05f, 0.0f,
+                           remainderf(result.phase - component.phase, 2 * PI));
+}
+
+// A healthy alternator: the 6x ripple of the three-phase bridge only
+void test_six_pulse_ripple(void) {
+  const Component components[] = {{6.0f, 0.15f, 0.7f}};
+  generate(200.0f, components, 1);
+  assert_component(200.0f, components[0]);
+  TEST_ASSERT_LESS_THAN(0.002f, measure(200.0f).amplitude);
+  TEST_ASSERT_LESS_THAN(0.002f, measure(400.0f).amplitude);
+}
+
+// A failed diode adds 1x and 2x, each with its own phase
+void test_ripple_with_low_harmonics(void) {
+  const Component components[] = {
+      {1.0f, 0.05f, -1.2f}, {2.0f, 0.03f, 2.0f}, {6.0f, 0.15f, 0.3f}};
+  // an electrical frequency that doesn't fall on a bin of the 256 samples
+  const float hz = 173.0f;
+  generate(hz, components, 3);
+  for (const Component& component : components) {
+    assert_component(hz, component);
+  }
+}
+
+void test_phase_all_around(void) {
+  for (int step = -7; step <= 7; step++) {
+    const Component component = {1.0f, 0.1f, step * 0.42f};
+    generate(310.0f, &component, 1);
+    assert_component(310.0f, component);
+  }
+}
+
+void test_flat_input(void) {
+  generate(200.0f, nullptr, 0);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.0f, measure(1200.0f).amplitude);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.0f,
+                           goertzel_amplitude(samples, SAMPLES,
+                                              sample_mean(samples, SAMPLES),
+                                              1200.0f / SAMPLE_RATE));
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_six_pulse_ripple);
+  RUN_TEST(test_ripple_with_low_harmonics);
+  RUN_TEST(test_phase_all_around);
+  RUN_TEST(test_flat_input);
+  return UNITY_END();
+}
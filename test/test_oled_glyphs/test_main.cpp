@@ -0,0 +1,166 @@
+// OledGlyphs, the row updates of OledPages, and what they cost on the host
+#include <unity.h>
+
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+
+#include "system/oled_glyphs.h"
+
+using namespace sensesp;
+
+const int UPDATES = 1000000;
+
+OledGlyphs glyphs;
+uint8_t label_image[OLED_WIDTH];
+
+void setUp(void) {
+  // every glyph column tells its character and column apart
+  for (uint8_t i = 0; i < OLED_GLYPH_COUNT; i++) {
+    for (uint8_t x = 0; x < OLED_CELL; x++) {
+      glyphs.table[i][x] = 0x80 | i << 3 | x;
+    }
+  }
+  glyphs.flipped = false;
+  for (size_t x = 0; x < OLED_WIDTH; x++) {
+    label_image[x] = 0x40 | x % OLED_CELL;
+  }
+}
+
+void tearDown(void) {}
+
+std::string tenths(float value) {
+  char text[12];
+  return std::string(text, format_tenths(value, text));
+}
+
+// The characters drawn into a field, read back through the glyph table;
+// '?' where a cell holds no glyph
+std::string drawn(const uint8_t* image, uint8_t first, uint8_t end) {
+  std::string text;
+  for (uint8_t cell = first; cell < end; cell++) {
+    const uint8_t* at = image + glyphs.column(cell);
+    char c = '?';
+    for (uint8_t i = 0; i < OLED_GLYPH_COUNT; i++) {
+      if (memcmp(at, glyphs.table[i], OLED_CELL) == 0) {
+        c = OLED_GLYPHS[i];
+      }
+    }
+    text += c;
+  }
+  return text;
+}
+
+void test_tenths_as_printf(void) {
+  char expected[32];
+  for (int i = -20000; i <= 20000; i += 7) {
+    // clear of the halfway points, where float rounding may go either way
+    float value = i / 10.0f + 0.03f;
+    snprintf(expected, sizeof(expected), "%.1f", value);
+    TEST_ASSERT_EQUAL_STRING(expected, tenths(value).c_str());
+  }
+  TEST_ASSERT_EQUAL_STRING("0.0", tenths(0.0f).c_str());
+  TEST_ASSERT_EQUAL_STRING("-0.0", tenths(-0.02f).c_str());
+  TEST_ASSERT_EQUAL_STRING("1850.0", tenths(1850.0f).c_str());
+  TEST_ASSERT_EQUAL_STRING("--", tenths(NAN).c_str());
+  // clamped, and still within 12 characters
+  TEST_ASSERT_EQUAL_STRING("-100000000.0", tenths(-1e12f).c_str());
+}
+
+void test_value_after_the_label(void) {
+  uint8_t image[OLED_WIDTH] = {};
+  glyphs.draw(image, label_image, 0, OLED_ROW_CELLS, 5, -12.34f);
+  // the label cells as they were, then the value, then the rest of the label
+  // image, which is blank on the display
+  TEST_ASSERT_EQUAL_MEMORY(label_image, image, 5 * OLED_CELL);
+  TEST_ASSERT_EQUAL_STRING("-12.3", drawn(image, 5, 10).c_str());
+  TEST_ASSERT_EQUAL_MEMORY(label_image + 10 * OLED_CELL,
+                           image + 10 * OLED_CELL,
+                           (OLED_ROW_CELLS - 10) * OLED_CELL);
+}
+
+// In rotation 2 cell 0 is at the right end, and the glyphs come mirrored
+// from the display already
+void test_flipped(void) {
+  glyphs.flipped = true;
+  uint8_t image[OLED_WIDTH] = {};
+  glyphs.draw(image, label_image, 0, OLED_ROW_CELLS, 2, 7.0f);
+  TEST_ASSERT_EQUAL_STRING("7.0", drawn(image, 2, 5).c_str());
+  TEST_ASSERT_EQUAL_MEMORY(glyphs.table[7], image + OLED_WIDTH - 3 * OLED_CELL,
+                           OLED_CELL);
+}
+
+// Field 0 ends where field 1 starts: a long value is cut off there and field
+// 1 stays as it was
+void test_fields_keep_apart(void) {
+  uint8_t image[OLED_WIDTH];
+  memset(image, 0x11, sizeof(image));
+  glyphs.draw(image, label_image, 0, OLED_FIELD_CELL, 4, 123456.7f);
+  TEST_ASSERT_EQUAL_STRING("123456.",
+                           drawn(image, 4, OLED_FIELD_CELL).c_str());
+  for (size_t x = OLED_FIELD_CELL * OLED_CELL; x < OLED_WIDTH; x++) {
+    TEST_ASSERT_EQUAL_HEX8(0x11, image[x]);
+  }
+  glyphs.draw(image, label_image, OLED_FIELD_CELL, OLED_ROW_CELLS,
+              OLED_FIELD_CELL + 3, 82.5f);
+  TEST_ASSERT_EQUAL_STRING("123456.",
+                           drawn(image, 4, OLED_FIELD_CELL).c_str());
+  TEST_ASSERT_EQUAL_STRING(
+      "82.5", drawn(image, OLED_FIELD_CELL + 3, OLED_FIELD_CELL + 7).c_str());
+}
+
+// One row update as OledPages::show() does it, from the page to the compare
+// with what the display buffer holds; the RPM row at 10 Hz, on every update
+// a different value
+void test_row_update_cost(void) {
+  uint8_t page[OLED_WIDTH] = {};
+  uint32_t changed = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < UPDATES; i++) {
+    uint8_t image[OLED_WIDTH];
+    memcpy(image, page, OLED_WIDTH);
+    glyphs.draw(image, label_image, 0, OLED_ROW_CELLS, 5,
+                1850.0f + (i % 400) * 0.1f);
+    if (memcmp(page, image, OLED_WIDTH) != 0) {
+      memcpy(page, image, OLED_WIDTH);
+      changed++;
+    }
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  double update_ns =
+      std::chrono::duration<double, std::nano>(elapsed).count() / UPDATES;
+  TEST_ASSERT_TRUE(changed > 0);
+
+  // what the row used to start with, the text through printf
+  char text[32];
+  size_t length = 0;
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < UPDATES; i++) {
+    length += snprintf(text, sizeof(text), "%s: %.1f", "RPM",
+                       1850.0f + (i % 400) * 0.1f);
+  }
+  elapsed = std::chrono::steady_clock::now() - start;
+  double printf_ns =
+      std::chrono::duration<double, std::nano>(elapsed).count() / UPDATES;
+  TEST_ASSERT_TRUE(length > 0);
+
+  char message[160];
+  snprintf(message, sizeof(message),
+           "%.1f ns per row update, %.1f ns for the printf alone, on the "
+           "host",
+           update_ns, printf_ns);
+  TEST_MESSAGE(message);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_tenths_as_printf);
+  RUN_TEST(test_value_after_the_label);
+  RUN_TEST(test_flipped);
+  RUN_TEST(test_fields_keep_apart);
+  RUN_TEST(test_row_update_cost);
+  return UNITY_END();
+}
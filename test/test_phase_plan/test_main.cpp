@@ -0,0 +1,152 @@
+// PhasePlan, the offsets of PhaseScheduler, on the tasks of a two-engine board
+#include <unity.h>
+
+#include <stdio.h>
+
+#include "system/phase_plan.h"
+
+using namespace sensesp;
+
+// PHASE_SLOT_MS
+const uint32_t SLOT_MS = 10;
+// ONEWIRE_READ_COST_US
+const uint32_t ONEWIRE_US = 12000;
+
+struct Cost {
+  const char* name;
+  uint32_t period_ms;
+  uint32_t cost_us;
+};
+
+// measured worst cases, rounded
+const Cost ENGINE_TASKS[] = {
+    {"EdgeTimer", 200, 400},     {"roughness", 1000, 1500},
+    {"INA226 volts", 1000, 1800}, {"INA226 amps", 1000, 1800},
+    {"burst recorder", 50, 600},
+};
+const Cost BOARD_TASKS[] = {
+    {"UDP", 1000, 3000},      {"SK spill", 1000, 2500},
+    {"SK replay", 250, 1200}, {"N2K dynamic", 100, 900},
+    {"power", 1000, 300},     {"display", 20, 2000},
+    {"hostname", 500, 100},
+};
+const int ENGINES = 2;
+const int ONEWIRE_SENSORS = 4;
+
+PhasePlan plan;
+
+void setUp(void) { plan = PhasePlan(); }
+
+void tearDown(void) {}
+
+// The tasks in the order the board adds them: the 1-Wire sensors are placed
+// as soon as SensESP starts them, when nothing has been measured yet, the
+// others after the learning phase
+void add_board(bool staggered) {
+  const Cost* measured[PHASE_MAX_TASKS];
+  for (int e = 0; e < ENGINES; e++) {
+    for (const Cost& task : ENGINE_TASKS) {
+      measured[plan.add(task.period_ms / SLOT_MS)] = &task;
+    }
+  }
+  for (const Cost& task : BOARD_TASKS) {
+    measured[plan.add(task.period_ms / SLOT_MS)] = &task;
+  }
+  size_t learned = plan.count;
+  for (int i = 0; i < ENGINES * ONEWIRE_SENSORS; i++) {
+    int index = plan.add(1000 / SLOT_MS, ONEWIRE_US, staggered);
+    if (staggered) {
+      plan.place(index);
+    }
+  }
+  for (size_t i = 0; i < learned; i++) {
+    plan.tasks[i].cost_us = measured[i]->cost_us;
+  }
+  if (staggered) {
+    plan.stagger();
+  }
+}
+
+void test_hyperperiod(void) {
+  plan.add(20);
+  plan.add(5);
+  plan.add(100);
+  TEST_ASSERT_EQUAL(100, plan.hyperperiod());
+  // 100 * 3 doesn't fit, 7 is planned approximately
+  plan.add(3);
+  plan.add(7);
+  TEST_ASSERT_EQUAL(100, plan.hyperperiod());
+}
+
+void test_place_avoids_the_load(void) {
+  plan.add(10, 500);
+  plan.add(10, 500);
+  plan.place(1);
+  TEST_ASSERT_EQUAL(1, plan.tasks[1].offset);
+  TEST_ASSERT_EQUAL(500, plan.peak());
+  // every slot taken: the one with the lowest load wins
+  PhasePlan full;
+  for (int i = 0; i < 4; i++) {
+    full.add(4, 1000 - i * 100);
+    full.place(i);
+  }
+  int index = full.add(4, 50);
+  full.place(index);
+  TEST_ASSERT_EQUAL(3, full.tasks[index].offset);
+  TEST_ASSERT_EQUAL(1000, full.peak());
+}
+
+// The 1-Wire reads each get a slot of their own, and stagger() leaves them
+// where they are
+void test_onewire_reads_are_spread(void) {
+  add_board(true);
+  uint16_t offsets[ENGINES * ONEWIRE_SENSORS];
+  size_t n = 0;
+  for (size_t i = 0; i < plan.count; i++) {
+    if (plan.tasks[i].fixed) {
+      offsets[n++] = plan.tasks[i].offset;
+    }
+  }
+  TEST_ASSERT_EQUAL(ENGINES * ONEWIRE_SENSORS, n);
+  for (size_t i = 0; i < n; i++) {
+    for (size_t j = i + 1; j < n; j++) {
+      TEST_ASSERT_NOT_EQUAL(offsets[i], offsets[j]);
+    }
+  }
+  plan.stagger();
+  n = 0;
+  for (size_t i = 0; i < plan.count; i++) {
+    if (plan.tasks[i].fixed) {
+      TEST_ASSERT_EQUAL(offsets[n++], plan.tasks[i].offset);
+    }
+  }
+}
+
+// The worst slot before and after: all tasks at offset 0, as they were, and
+// placed
+void test_worst_slot(void) {
+  add_board(false);
+  uint32_t aligned = plan.peak();
+  setUp();
+  add_board(true);
+  uint32_t staggered = plan.peak();
+
+  char message[80];
+  snprintf(message, sizeof(message),
+           "worst slot %lu us aligned, %lu us staggered",
+           (unsigned long)aligned, (unsigned long)staggered);
+  TEST_MESSAGE(message);
+  // one 1-Wire read, with at most the tasks too frequent to avoid it: the
+  // display, the burst recorder and the N2K sender
+  TEST_ASSERT_TRUE(staggered <= ONEWIRE_US + 2000 + 600 + 900);
+  TEST_ASSERT_TRUE(staggered * 4 < aligned);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_hyperperiod);
+  RUN_TEST(test_place_avoids_the_load);
+  RUN_TEST(test_onewire_reads_are_spread);
+  RUN_TEST(test_worst_slot);
+  return UNITY_END();
+}
@@ -0,0 +1,239 @@
+// StageChain, the fused pipeline, against the object graph it replaces
+#include <unity.h>
+
+#include <chrono>
+#include <forward_list>
+#include <functional>
+#include <new>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "sensori/stage_chain.h"
+
+using namespace sensesp;
+
+// bytes handed out by new, to size the graph
+size_t allocated = 0;
+
+void* operator new(size_t size) {
+  allocated += size;
+  void* p = malloc(size);
+  if (p == nullptr) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+// millis(), advanced by the test
+uint32_t clock_ms = 0;
+
+// RPM from the pulse count every 200 ms, as in EngineInstance::build()
+const float MULTIPLIER = 1.0f / 13.23f;
+const float SCALE = 60.0f;
+const int SAMPLES = 1000000;
+
+float sunk = 0;
+void sink(float value) { sunk = value; }
+
+// The stages of FrequencyStage and LinearStage, without their configuration
+
+struct HostFrequency {
+  float multiplier;
+  uint32_t last_update = 0;
+
+  explicit HostFrequency(float multiplier) : multiplier{multiplier} {}
+
+  float operator()(float count) {
+    uint32_t now = clock_ms;
+    uint32_t elapsed = now - last_update;
+    last_update = now;
+    return elapsed == 0 ? 0.0f : multiplier * 1000.0f * count / elapsed;
+  }
+};
+
+struct HostLinear {
+  float multiplier;
+  float offset;
+
+  explicit HostLinear(float multiplier, float offset = 0)
+      : multiplier{multiplier}, offset{offset} {}
+
+  float operator()(float value) const { return multiplier * value + offset; }
+};
+
+// SensESP's object graph, reduced to what a sample goes through: an observer
+// list of std::function per producer and a virtual set_input() per consumer.
+// The real transforms are Configurables as well, so they are larger still.
+
+class Observable {
+ public:
+  void notify() {
+    for (auto& observer : observers) {
+      observer();
+    }
+  }
+  void attach(std::function<void()> observer) { observers.push_front(observer); }
+
+ private:
+  std::forward_list<std::function<void()>> observers;
+};
+
+template <typename T>
+class ValueConsumer {
+ public:
+  virtual ~ValueConsumer() {}
+  virtual void set_input(T input, uint8_t input_channel = 0) = 0;
+};
+
+template <typename T>
+class ValueProducer : public Observable {
+ public:
+  T output = 0;
+
+  void emit(T value) {
+    output = value;
+    notify();
+  }
+
+  template <typename C>
+  C* connect_to(C* consumer) {
+    attach([this, consumer]() { consumer->set_input(this->output); });
+    return consumer;
+  }
+};
+
+template <typename In, typename Out>
+class Transform : public ValueConsumer<In>, public ValueProducer<Out> {};
+
+class Frequency : public Transform<int, float> {
+ public:
+  explicit Frequency(float multiplier) : stage{multiplier} {}
+  virtual void set_input(int count, uint8_t input_channel = 0) override {
+    emit(stage((float)count));
+  }
+
+ private:
+  HostFrequency stage;
+};
+
+class Linear : public Transform<float, float> {
+ public:
+  Linear(float multiplier, float offset) : stage{multiplier, offset} {}
+  virtual void set_input(float value, uint8_t input_channel = 0) override {
+    emit(stage(value));
+  }
+
+ private:
+  HostLinear stage;
+};
+
+class LambdaConsumer : public ValueConsumer<float> {
+ public:
+  explicit LambdaConsumer(std::function<void(float)> function)
+      : function{function} {}
+  virtual void set_input(float value, uint8_t input_channel = 0) override {
+    function(value);
+  }
+
+ private:
+  std::function<void(float)> function;
+};
+
+// Pipe<int, FrequencyStage, LinearStage, Tap<sink>>: one virtual call at the
+// entry, the stages inlined behind it
+class Pipe : public Transform<int, float> {
+ public:
+  Pipe() : chain(HostFrequency{MULTIPLIER}, HostLinear{SCALE}) {}
+  virtual void set_input(int count, uint8_t input_channel = 0) override {
+    emit(chain((float)count));
+  }
+
+ private:
+  StageChain<HostFrequency, HostLinear, Tap<sink>> chain;
+};
+
+ValueProducer<int>* counter = nullptr;
+
+void setUp(void) {
+  clock_ms = 0;
+  counter = new ValueProducer<int>();
+}
+
+void tearDown(void) {}
+
+size_t build_graph() {
+  size_t before = allocated;
+  counter->connect_to(new Frequency(MULTIPLIER))
+      ->connect_to(new Linear(SCALE, 0))
+      ->connect_to(new LambdaConsumer(sink));
+  return allocated - before;
+}
+
+size_t build_pipe() {
+  size_t before = allocated;
+  counter->connect_to(new Pipe());
+  return allocated - before;
+}
+
+// 4 to 30 pulses per 200 ms, 1400 to 6800 RPM
+int pulses(int i) { return 4 + (i * 7) % 27; }
+
+double run(int samples) {
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < samples; i++) {
+    clock_ms += 200;
+    counter->emit(pulses(i));
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  return std::chrono::duration<double, std::nano>(elapsed).count() / samples;
+}
+
+void test_same_values(void) {
+  ValueProducer<int>* graph_counter = counter;
+  build_graph();
+  setUp();
+  build_pipe();
+  ValueProducer<int>* pipe_counter = counter;
+  uint32_t time = 0;
+  for (int i = 0; i < 100; i++) {
+    time += 200;
+    clock_ms = time;
+    graph_counter->emit(pulses(i));
+    float expected = sunk;
+    pipe_counter->emit(pulses(i));
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, expected, sunk);
+    TEST_ASSERT_FLOAT_WITHIN(
+        1e-2f, pulses(i) * 5.0f * MULTIPLIER * SCALE, sunk);
+  }
+}
+
+void test_benchmark(void) {
+  size_t graph_bytes = build_graph();
+  double graph_ns = run(SAMPLES);
+  setUp();
+  size_t pipe_bytes = build_pipe();
+  double pipe_ns = run(SAMPLES);
+
+  char message[120];
+  snprintf(message, sizeof(message),
+           "%.1f ns per sample through the graph, %.1f ns through the pipe, "
+           "on the host",
+           graph_ns, pipe_ns);
+  TEST_MESSAGE(message);
+  snprintf(message, sizeof(message),
+           "%u bytes for the graph, %u bytes for the pipe",
+           (unsigned)graph_bytes, (unsigned)pipe_bytes);
+  TEST_MESSAGE(message);
+  TEST_ASSERT_TRUE(pipe_bytes < graph_bytes);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_same_values);
+  RUN_TEST(test_benchmark);
+  return UNITY_END();
+}
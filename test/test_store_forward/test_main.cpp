@@ -0,0 +1,280 @@
+// StoreForwardQueue and ReplayDelta, replayed to a Signal K server stand-in
+#include <unity.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "engine/store_forward_queue.h"
+
+using namespace sensesp;
+
+// STORE_FORWARD_REPLAY_MS
+const uint32_t REPLAY_MS = 250;
+
+// The spill files, in memory
+class MemorySpill : public SpillStorage {
+ public:
+  std::vector<uint8_t> files[2];
+  bool present[2] = {false, false};
+  bool failing = false;
+
+  virtual bool exists(uint8_t file) override { return present[file]; }
+  virtual uint32_t size(uint8_t file) override { return files[file].size(); }
+  virtual bool append(uint8_t file, const uint8_t* data,
+                      size_t bytes) override {
+    if (failing) {
+      return false;
+    }
+    present[file] = true;
+    files[file].insert(files[file].end(), data, data + bytes);
+    return true;
+  }
+  virtual size_t read(uint8_t file, uint32_t offset, uint8_t* data,
+                      size_t bytes) override {
+    if (offset >= files[file].size()) {
+      return 0;
+    }
+    size_t n = files[file].size() - offset;
+    n = n < bytes ? n : bytes;
+    memcpy(data, files[file].data() + offset, n);
+    return n;
+  }
+  virtual void remove(uint8_t file) override {
+    files[file].clear();
+    present[file] = false;
+  }
+};
+
+// What the Signal K server receives over the websocket: the deltas, and
+// the values they carry in order
+struct Server {
+  std::vector<std::string> deltas;
+  std::vector<float> values;
+  std::vector<uint32_t> received_ms;
+
+  void receive(const char* text, uint32_t now_ms) {
+    deltas.push_back(text);
+    received_ms.push_back(now_ms);
+    for (const char* p = strstr(text, "\"value\":"); p != nullptr;
+         p = strstr(p + 1, "\"value\":")) {
+      values.push_back(strtof(p + 8, nullptr));
+    }
+  }
+};
+
+MemorySpill spill;
+StoreForwardQueue* queue = nullptr;
+Server server;
+ReplayDelta<STORE_FORWARD_DELTA_SIZE> delta;
+uint32_t pushed = 0;
+
+void setUp(void) {
+  spill = MemorySpill();
+  delete queue;
+  queue = new StoreForwardQueue(spill);
+  server = Server();
+  pushed = 0;
+}
+
+void tearDown(void) {}
+
+// What SKStoreForward::record() and its spill task do with one value; the
+// value is its sequence number
+void record() {
+  StoredValue* stored = queue->push();
+  if (stored != nullptr) {
+    stored->stamp = 1700000000UL + pushed;
+    stored->boot_id = 0;
+    stored->engine = 0;
+    stored->channel = 0;
+    stored->value = (float)pushed;
+  }
+  pushed++;
+  if (queue->spill_due()) {
+    queue->spill();
+  }
+}
+
+// What SKStoreForward::replay() does every REPLAY_MS; false once empty
+bool replay(uint32_t now_ms) {
+  StoredValue batch[STORE_FORWARD_BATCH];
+  size_t count = queue->next_batch(batch);
+  if (count == 0) {
+    return false;
+  }
+  delta.clear();
+  for (size_t i = 0; i < count; i++) {
+    char timestamp[24];
+    snprintf(timestamp, sizeof(timestamp), "%lu",
+             (unsigned long)batch[i].stamp);
+    TEST_ASSERT_TRUE(delta.add(
+        timestamp, "propulsion.port.coolantTemperature", batch[i].value));
+  }
+  delta.end();
+  server.receive(delta.data(), now_ms);
+  return true;
+}
+
+uint32_t replay_all() {
+  uint32_t now_ms = 0;
+  while (replay(now_ms)) {
+    now_ms += REPLAY_MS;
+  }
+  return now_ms;
+}
+
+void assert_in_order() {
+  for (size_t i = 1; i < server.values.size(); i++) {
+    TEST_ASSERT_TRUE(server.values[i] > server.values[i - 1]);
+  }
+}
+
+void test_replay_order(void) {
+  // three spills and some left in RAM
+  for (int i = 0; i < 3 * STORE_FORWARD_RING / 2 + 30; i++) {
+    record();
+  }
+  TEST_ASSERT_TRUE(spill.present[0]);
+  replay_all();
+  TEST_ASSERT_EQUAL(pushed, server.values.size());
+  assert_in_order();
+  TEST_ASSERT_EQUAL(0, queue->dropped_full);
+  TEST_ASSERT_FALSE(spill.present[0] || spill.present[1]);
+}
+
+// Values recorded while a replay is under way, e.g. from a channel whose
+// connection hasn't been noticed yet, come after the older ones
+void test_recording_during_replay(void) {
+  for (int i = 0; i < 200; i++) {
+    record();
+  }
+  for (uint32_t now_ms = 0; replay(now_ms); now_ms += REPLAY_MS) {
+    if (now_ms < 100 * REPLAY_MS) {
+      record();
+      record();
+    }
+  }
+  TEST_ASSERT_EQUAL(pushed, server.values.size());
+  assert_in_order();
+}
+
+// A flash budget of four spills: the oldest data goes, the newest arrives
+void test_flash_full_drops_the_oldest(void) {
+  queue->max_bytes = 4 * STORE_FORWARD_RING * sizeof(StoredValue);
+  for (int i = 0; i < 40 * STORE_FORWARD_RING; i++) {
+    record();
+  }
+  replay_all();
+  TEST_ASSERT_TRUE(queue->dropped_full > 0);
+  TEST_ASSERT_EQUAL(pushed, server.values.size() + queue->dropped_full);
+  assert_in_order();
+  TEST_ASSERT_EQUAL_FLOAT((float)(pushed - 1), server.values.back());
+  // never more than the budget
+  TEST_ASSERT_TRUE((spill.files[0].size() + spill.files[1].size()) <=
+                   queue->max_bytes + STORE_FORWARD_RING * sizeof(StoredValue));
+}
+
+// The spill task falls behind, or the flash can't be written
+void test_ring_full_and_spill_failure(void) {
+  for (int i = 0; i < STORE_FORWARD_RING + 10; i++) {
+    TEST_ASSERT_EQUAL(i < STORE_FORWARD_RING, queue->push() != nullptr);
+  }
+  TEST_ASSERT_EQUAL(10, queue->dropped_full);
+  spill.failing = true;
+  TEST_ASSERT_FALSE(queue->spill());
+  TEST_ASSERT_EQUAL(10 + STORE_FORWARD_RING, queue->dropped_full);
+  StoredValue batch[STORE_FORWARD_BATCH];
+  TEST_ASSERT_EQUAL(0, queue->next_batch(batch));
+}
+
+// STORE_FORWARD_BATCH values per delta, one delta per REPLAY_MS
+void test_pacing(void) {
+  for (int i = 0; i < 500; i++) {
+    record();
+  }
+  uint32_t elapsed_ms = replay_all();
+  // full batches, but for one where the spill file ends
+  size_t batches = (500 + STORE_FORWARD_BATCH - 1) / STORE_FORWARD_BATCH;
+  TEST_ASSERT_EQUAL(500, server.values.size());
+  TEST_ASSERT_TRUE(server.deltas.size() <= batches + 1);
+  for (size_t i = 0; i < server.deltas.size(); i++) {
+    const std::string& text = server.deltas[i];
+    TEST_ASSERT_EQUAL(0, text.find("{\"updates\":[{\"timestamp\":"));
+    TEST_ASSERT_EQUAL(text.size() - 2, text.rfind("]}"));
+    TEST_ASSERT_TRUE(text.size() < STORE_FORWARD_DELTA_SIZE);
+    size_t values = 0;
+    for (size_t p = text.find("\"value\":"); p != std::string::npos;
+         p = text.find("\"value\":", p + 1)) {
+      values++;
+    }
+    TEST_ASSERT_TRUE(values <= STORE_FORWARD_BATCH);
+    if (i > 0) {
+      TEST_ASSERT_EQUAL(REPLAY_MS,
+                        server.received_ms[i] - server.received_ms[i - 1]);
+    }
+  }
+  char message[80];
+  snprintf(message, sizeof(message),
+           "%u values in %u deltas over %lu ms, %lu values/s",
+           (unsigned)server.values.size(), (unsigned)server.deltas.size(),
+           (unsigned long)elapsed_ms,
+           (unsigned long)(1000UL * STORE_FORWARD_BATCH / REPLAY_MS));
+  TEST_MESSAGE(message);
+}
+
+void test_resume_the_smaller_file(void) {
+  uint8_t bytes[2 * sizeof(StoredValue)] = {};
+  spill.append(0, bytes, sizeof(bytes));
+  spill.append(1, bytes, sizeof(StoredValue));
+  queue->resume();
+  for (int i = 0; i < STORE_FORWARD_RING / 2; i++) {
+    record();
+  }
+  TEST_ASSERT_EQUAL(2 * sizeof(StoredValue), spill.files[0].size());
+  TEST_ASSERT_EQUAL((1 + STORE_FORWARD_RING / 2) * sizeof(StoredValue),
+                    spill.files[1].size());
+}
+
+void test_dating(void) {
+  uint32_t stamp = 0;
+  StoredValue dated = {1700000000UL, 0, 0, 0, 1.0f};
+  TEST_ASSERT_TRUE(stored_time(dated, 77, 1700000500UL, 900000, stamp));
+  TEST_ASSERT_EQUAL(1700000000UL, stamp);
+  // recorded at 300 s into this boot, now 900 s into it
+  StoredValue this_boot = {300000, 77, 0, 0, 1.0f};
+  TEST_ASSERT_TRUE(stored_time(this_boot, 77, 1700000500UL, 900000, stamp));
+  TEST_ASSERT_EQUAL(1700000500UL - 600, stamp);
+  StoredValue earlier_boot = {300000, 12, 0, 0, 1.0f};
+  TEST_ASSERT_FALSE(
+      stored_time(earlier_boot, 77, 1700000500UL, 900000, stamp));
+}
+
+void test_delta_refuses_what_doesnt_fit(void) {
+  ReplayDelta<160> small;
+  TEST_ASSERT_TRUE(small.add("2024-05-01T10:00:00Z", "a.b", 1.5f));
+  TEST_ASSERT_FALSE(small.add("2024-05-01T10:00:01Z",
+                              "propulsion.port.exhaustTemperature.long", 2.5f));
+  small.end();
+  TEST_ASSERT_EQUAL(1, small.count());
+  TEST_ASSERT_EQUAL_STRING(
+      "{\"updates\":[{\"timestamp\":\"2024-05-01T10:00:00Z\",\"values\":"
+      "[{\"path\":\"a.b\",\"value\":1.5}]}]}",
+      small.data());
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_replay_order);
+  RUN_TEST(test_recording_during_replay);
+  RUN_TEST(test_flash_full_drops_the_oldest);
+  RUN_TEST(test_ring_full_and_spill_failure);
+  RUN_TEST(test_pacing);
+  RUN_TEST(test_resume_the_smaller_file);
+  RUN_TEST(test_dating);
+  RUN_TEST(test_delta_refuses_what_doesnt_fit);
+  return UNITY_END();
+}
@@ -0,0 +1,214 @@
+// The load of StressTest on the host: synthetic sources through StageChain,
+// UDPPacket and an N2K frame each
+#include <unity.h>
+
+#include <chrono>
+#include <math.h>
+#include <new>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "engine/udp_packet.h"
+#include "sensori/stage_chain.h"
+
+using namespace sensesp;
+
+// bytes handed out by new, none should be on the value path
+size_t allocated = 0;
+
+void* operator new(size_t size) {
+  allocated += size;
+  void* p = malloc(size);
+  if (p == nullptr) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+// The defaults of StressTest
+const uint32_t PERIOD_MS = 100;
+const uint16_t STEP_SOURCES = 8;
+const uint16_t MAX_SOURCES = 128;
+// simulated time per step, one loop tick per millisecond
+const uint32_t STEP_MS = 10000;
+const size_t PACKET_SIZE = 1400;  // UDP_PACKET_SIZE
+const uint8_t N2K_INSTANCE = 16;  // STRESS_N2K_INSTANCE
+
+// millis(), advanced by the loop
+uint32_t clock_ms = 0;
+
+// The consumers of the value being emitted
+uint16_t current = 0;
+uint32_t emissions = 0;
+UDPPacket<PACKET_SIZE> packet;
+uint32_t datagrams = 0;
+char sent[PACKET_SIZE];  // the last datagram that went out
+uint8_t frames[256][8];  // the latest PGN 130312 per instance
+uint32_t frames_sent = 0;
+
+// What LambdaConsumer does with SetN2kTemperature(): SID, instance, source,
+// the temperature in 0.01 K, the set temperature not available
+void n2k_temperature(uint8_t* data, uint8_t instance, float value) {
+  uint16_t actual = (uint16_t)(value * 100.0f + 0.5f);
+  data[0] = 1;
+  data[1] = instance;
+  data[2] = 3;  // N2kts_EngineRoomTemperature
+  data[3] = actual & 0xFF;
+  data[4] = actual >> 8;
+  data[5] = 0xFF;
+  data[6] = 0xFF;
+  data[7] = 0xFF;
+}
+
+// The SKOutputFloat and the LambdaConsumer behind every source's Linear
+void consume(float value) {
+  emissions++;
+  char path[16];
+  snprintf(path, sizeof(path), "stress.%u", current);
+  if (!packet.add_value(path, value)) {
+    packet.end_delta();
+    memcpy(sent, packet.data(), packet.size() + 1);
+    datagrams++;
+    packet.clear();
+    packet.add_value(path, value);
+  }
+  uint8_t instance = (N2K_INSTANCE + current) & 0xFF;
+  n2k_temperature(frames[instance], instance, value);
+  frames_sent++;
+}
+
+struct HostLinear {
+  float multiplier;
+  float offset;
+
+  HostLinear(float multiplier = 1.0f, float offset = 0.0f)
+      : multiplier{multiplier}, offset{offset} {}
+
+  float operator()(float value) const { return multiplier * value + offset; }
+};
+
+// One RepeatSensor and what it is connected to
+struct Source {
+  uint32_t next_ms;
+  StageChain<HostLinear, Tap<consume>> chain;
+};
+
+Source sources[MAX_SOURCES];
+
+// A slow wave, different for every source, as in StressTest::add_sources()
+float wave(uint16_t n) {
+  return 300.0f + 10.0f * sinf((clock_ms + 97 * n) / 1000.0f);
+}
+
+struct Step {
+  uint16_t sources;
+  uint32_t emissions;
+  double values_per_s;  // of host time
+  double tick_max_ns;
+  double tick_mean_ns;
+  size_t allocated;
+};
+
+// One step of the sweep: every loop tick, the sources that are due
+Step run_step(uint16_t count) {
+  for (uint16_t n = 0; n < count; n++) {
+    sources[n].next_ms = clock_ms;
+  }
+  emissions = 0;
+  size_t allocated_before = allocated;
+  double tick_max_ns = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t tick = 0; tick < STEP_MS; tick++, clock_ms++) {
+    auto tick_start = std::chrono::steady_clock::now();
+    for (uint16_t n = 0; n < count; n++) {
+      if ((int32_t)(clock_ms - sources[n].next_ms) >= 0) {
+        sources[n].next_ms += PERIOD_MS;
+        current = n;
+        sources[n].chain(wave(n));
+      }
+    }
+    double tick_ns = std::chrono::duration<double, std::nano>(
+                         std::chrono::steady_clock::now() - tick_start)
+                         .count();
+    tick_max_ns = tick_ns > tick_max_ns ? tick_ns : tick_max_ns;
+  }
+  double elapsed_ns = std::chrono::duration<double, std::nano>(
+                          std::chrono::steady_clock::now() - start)
+                          .count();
+  Step step;
+  step.sources = count;
+  step.emissions = emissions;
+  step.values_per_s = emissions / (elapsed_ns / 1e9);
+  step.tick_max_ns = tick_max_ns;
+  step.tick_mean_ns = elapsed_ns / STEP_MS;
+  step.allocated = allocated - allocated_before;
+  return step;
+}
+
+void setUp(void) {
+  clock_ms = 0;
+  packet.clear();
+  datagrams = 0;
+  sent[0] = '\0';
+  frames_sent = 0;
+  memset(frames, 0, sizeof(frames));
+}
+
+void tearDown(void) {}
+
+// Every source emits once per period, and the last value of each reaches
+// Signal K, in the open datagram or the one sent before, and N2K as it left
+// the source
+void test_every_value_arrives(void) {
+  Step step = run_step(STEP_SOURCES);
+  TEST_ASSERT_EQUAL(STEP_SOURCES * STEP_MS / PERIOD_MS, step.emissions);
+  TEST_ASSERT_EQUAL(step.emissions, frames_sent);
+
+  packet.end_delta();
+  char value[48];
+  for (uint16_t n = 0; n < STEP_SOURCES; n++) {
+    uint32_t last_ms = sources[n].next_ms - PERIOD_MS;
+    float expected = 300.0f + 10.0f * sinf((last_ms + 97 * n) / 1000.0f);
+    snprintf(value, sizeof(value), "{\"path\":\"stress.%u\",\"value\":%g}", n,
+             expected);
+    TEST_ASSERT_TRUE(strstr(packet.data(), value) != nullptr ||
+                     strstr(sent, value) != nullptr);
+
+    const uint8_t* frame = frames[N2K_INSTANCE + n];
+    TEST_ASSERT_EQUAL(N2K_INSTANCE + n, frame[1]);
+    TEST_ASSERT_EQUAL((uint16_t)(expected * 100.0f + 0.5f),
+                      frame[3] | frame[4] << 8);
+  }
+}
+
+// N swept upward as on the board, one line of the capacity curve per step.
+// The value path allocates nothing, whatever N.
+void test_sweep(void) {
+  TEST_MESSAGE("sources, values/s, tick max ns, tick mean ns, on the host");
+  char message[120];
+  for (uint16_t count = STEP_SOURCES; count <= MAX_SOURCES;
+       count += STEP_SOURCES) {
+    Step step = run_step(count);
+    TEST_ASSERT_EQUAL(count * STEP_MS / PERIOD_MS, step.emissions);
+    TEST_ASSERT_EQUAL(0, step.allocated);
+    snprintf(message, sizeof(message), "%7u %10.0f %12.0f %13.1f",
+             step.sources, step.values_per_s, step.tick_max_ns,
+             step.tick_mean_ns);
+    TEST_MESSAGE(message);
+  }
+  snprintf(message, sizeof(message), "%u UDP datagrams over the sweep",
+           (unsigned)datagrams);
+  TEST_MESSAGE(message);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_every_value_arrives);
+  RUN_TEST(test_sweep);
+  return UNITY_END();
+}
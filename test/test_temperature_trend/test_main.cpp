@@ -0,0 +1,239 @@
+// SlidingRegression and TemperatureFilter, behind TemperatureTrend
+#include <unity.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "sensori/sliding_regression.h"
+#include "sensori/temperature_filter.h"
+
+using namespace sensesp;
+
+// the 1-Wire sensors are read once a second
+const uint32_t PERIOD_MS = 1000;
+
+float noise() { return (rand() % 2001 - 1000) / 1000.0f; }
+
+void setUp(void) { srand(1); }
+
+void tearDown(void) {}
+
+// Least squares over the given samples, the slow way, in double
+double reference_slope(const uint32_t* times, const float* values, size_t n) {
+  double mx = 0, my = 0;
+  for (size_t i = 0; i < n; i++) {
+    mx += (double)(uint32_t)(times[i] - times[0]) / 1000.0;
+    my += values[i];
+  }
+  mx /= n;
+  my /= n;
+  double sxy = 0, sxx = 0;
+  for (size_t i = 0; i < n; i++) {
+    double x = (double)(uint32_t)(times[i] - times[0]) / 1000.0 - mx;
+    sxy += x * (values[i] - my);
+    sxx += x * x;
+  }
+  return sxy / sxx;
+}
+
+void test_slope_of_a_line(void) {
+  SlidingRegression regression(60);
+  for (uint32_t i = 0; i < 60; i++) {
+    regression.add(i * PERIOD_MS, 350.0f + 0.25f * i);
+  }
+  TEST_ASSERT_FLOAT_WITHIN(1e-5f, 0.25f, regression.slope());
+  TEST_ASSERT_FLOAT_WITHIN(1e-3f, 350.0f + 0.25f * 70,
+                           regression.fitted(70 * PERIOD_MS));
+}
+
+// Once the window has wrapped, only the last window samples count: a rise
+// that turns into a fall shows as a fall one window later
+void test_wrap_around(void) {
+  SlidingRegression regression(20);
+  uint32_t t = 0;
+  float value = 330.0f;
+  for (int i = 0; i < 50; i++, t += PERIOD_MS) {
+    value += 0.5f;
+    regression.add(t, value);
+  }
+  TEST_ASSERT_FLOAT_WITHIN(1e-4f, 0.5f, regression.slope());
+  for (int i = 0; i < 10; i++, t += PERIOD_MS) {
+    value -= 0.2f;
+    regression.add(t, value);
+  }
+  // half and half
+  TEST_ASSERT_TRUE(regression.slope() < 0.5f && regression.slope() > -0.2f);
+  for (int i = 0; i < 10; i++, t += PERIOD_MS) {
+    value -= 0.2f;
+    regression.add(t, value);
+  }
+  TEST_ASSERT_EQUAL(20, regression.count());
+  TEST_ASSERT_FLOAT_WITHIN(1e-4f, -0.2f, regression.slope());
+}
+
+// Many turns of the window, uneven sample times, millis() wrapping on the
+// way, a large base value: every slope matches the two-pass reference over
+// the same window and the line passes through the samples
+void test_rebasing_keeps_the_precision(void) {
+  const uint8_t window = 120;
+  SlidingRegression regression(window);
+  uint32_t times[window];
+  float values[window];
+  uint32_t t = 0xFFFFFFFFUL - 3600000UL;
+  for (uint32_t i = 0; i < 20000; i++) {
+    t += PERIOD_MS + rand() % 50;
+    float value = 360.0f + 10.0f * sinf(i / 2000.0f) + 0.05f * noise();
+    regression.add(t, value);
+    // the window, oldest first
+    if (i < window) {
+      times[i] = t;
+      values[i] = value;
+    } else {
+      for (uint8_t j = 1; j < window; j++) {
+        times[j - 1] = times[j];
+        values[j - 1] = values[j];
+      }
+      times[window - 1] = t;
+      values[window - 1] = value;
+    }
+    if (i >= window && i % 97 == 0) {
+      double expected = reference_slope(times, values, window);
+      TEST_ASSERT_FLOAT_WITHIN(2e-5f, expected, regression.slope());
+      TEST_ASSERT_FLOAT_WITHIN(0.05f, 360.0f + 10.0f * sinf(i / 2000.0f),
+                               regression.fitted(t));
+    }
+  }
+}
+
+void test_flat_and_too_few(void) {
+  SlidingRegression regression(10);
+  TEST_ASSERT_TRUE(isnan(regression.fitted(0)));
+  regression.add(5000, 300.0f);
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, regression.slope());
+  TEST_ASSERT_EQUAL_FLOAT(300.0f, regression.fitted(9000));
+  for (int i = 1; i < 30; i++) {
+    regression.add(5000 + i * PERIOD_MS, 300.0f);
+  }
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, regression.slope());
+}
+
+// What TemperatureTrend::set_input() does with the two
+struct Trend {
+  TemperatureFilter filter;
+  SlidingRegression regression{120};
+  uint32_t now = 0;
+  uint32_t rejected = 0;
+
+  void read(float temperature) {
+    now += PERIOD_MS;
+    if (!filter.accept(now, temperature, regression.slope())) {
+      rejected++;
+      return;
+    }
+    if (filter.new_level()) {
+      regression.resize(120);
+      for (uint8_t i = 0; i < filter.run_length(); i++) {
+        regression.add(filter.run_time(i), filter.run_value(i));
+      }
+    }
+    regression.add(now, temperature);
+  }
+};
+
+// Raw water lost: the exhaust climbs faster than max_jump per reading. The
+// trend follows after TREND_NEW_LEVEL readings and then rejects nothing.
+void test_fast_rise_is_followed(void) {
+  Trend trend;
+  for (int i = 0; i < 60; i++) {
+    trend.read(318.0f + 0.05f * noise());
+  }
+  TEST_ASSERT_EQUAL(0, trend.rejected);
+  float value = 318.0f;
+  for (int i = 0; i < 30; i++) {
+    value += 6.0f;
+    trend.read(value + 0.05f * noise());
+  }
+  TEST_ASSERT_EQUAL(TREND_NEW_LEVEL - 1, trend.rejected);
+  TEST_ASSERT_FLOAT_WITHIN(0.05f, 6.0f, trend.regression.slope());
+  TEST_ASSERT_FLOAT_WITHIN(0.5f, value, trend.regression.fitted(trend.now));
+}
+
+// The rise also holds when it doesn't start at once: 3, then 7 K per reading
+void test_accelerating_rise(void) {
+  Trend trend;
+  for (int i = 0; i < 30; i++) {
+    trend.read(318.0f);
+  }
+  float value = 318.0f;
+  for (int i = 0; i < 10; i++) {
+    value += 3.0f;
+    trend.read(value);
+  }
+  for (int i = 0; i < 20; i++) {
+    value += 7.0f;
+    trend.read(value);
+  }
+  TEST_ASSERT_TRUE(trend.rejected <= 2 * (TREND_NEW_LEVEL - 1));
+  TEST_ASSERT_FLOAT_WITHIN(0.1f, 7.0f, trend.regression.slope());
+}
+
+void test_step_to_a_new_level(void) {
+  Trend trend;
+  for (int i = 0; i < 30; i++) {
+    trend.read(340.0f);
+  }
+  for (int i = 0; i < 10; i++) {
+    trend.read(352.0f);
+  }
+  TEST_ASSERT_EQUAL(TREND_NEW_LEVEL - 1, trend.rejected);
+  TEST_ASSERT_FLOAT_WITHIN(1e-3f, 352.0f, trend.regression.fitted(trend.now));
+  TEST_ASSERT_FLOAT_WITHIN(1e-4f, 0.0f, trend.regression.slope());
+}
+
+void test_glitches_are_rejected(void) {
+  Trend trend;
+  // the power-on value first
+  trend.read(DS18B20_POWER_ON_K);
+  TEST_ASSERT_EQUAL(1, trend.rejected);
+  for (int i = 0; i < 30; i++) {
+    trend.read(330.0f + 0.1f * i);
+  }
+  // a failed read, a single spike, two unrelated spikes, the power-on value
+  const float glitches[] = {DS18B20_ERROR_K, 371.0f, 333.2f, 300.0f,
+                            390.0f,          333.4f, DS18B20_POWER_ON_K,
+                            333.5f};
+  for (float glitch : glitches) {
+    trend.read(glitch);
+  }
+  TEST_ASSERT_EQUAL(1 + 5, trend.rejected);
+  TEST_ASSERT_FLOAT_WITHIN(0.02f, 0.1f, trend.regression.slope());
+}
+
+// Sub-zero is real, and so is 85 °C when the engine got there by itself
+void test_real_extremes_pass(void) {
+  Trend cold;
+  for (int i = 0; i < 10; i++) {
+    cold.read(265.0f);
+  }
+  Trend hot;
+  for (int i = 0; i < 20; i++) {
+    hot.read(DS18B20_POWER_ON_K - 4.0f + 0.2f * i);
+  }
+  TEST_ASSERT_EQUAL(0, cold.rejected);
+  TEST_ASSERT_EQUAL(0, hot.rejected);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_slope_of_a_line);
+  RUN_TEST(test_wrap_around);
+  RUN_TEST(test_rebasing_keeps_the_precision);
+  RUN_TEST(test_flat_and_too_few);
+  RUN_TEST(test_fast_rise_is_followed);
+  RUN_TEST(test_accelerating_rise);
+  RUN_TEST(test_step_to_a_new_level);
+  RUN_TEST(test_glitches_are_rejected);
+  RUN_TEST(test_real_extremes_pass);
+  return UNITY_END();
+}
@@ -0,0 +1,289 @@
+// UDPPacket, the datagrams of UDPBroadcast, sent over the loopback interface
+#include <unity.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <string>
+
+#include "engine/udp_packet.h"
+
+using namespace sensesp;
+
+const size_t PACKET_SIZE = 1400;  // UDP_PACKET_SIZE
+
+int receiver = -1;
+int sender = -1;
+sockaddr_in address;
+
+void setUp(void) {
+  receiver = socket(AF_INET, SOCK_DGRAM, 0);
+  sender = socket(AF_INET, SOCK_DGRAM, 0);
+  memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  address.sin_port = 0;
+  bind(receiver, (sockaddr*)&address, sizeof(address));
+  socklen_t length = sizeof(address);
+  getsockname(receiver, (sockaddr*)&address, &length);
+  timeval timeout = {2, 0};
+  setsockopt(receiver, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+}
+
+void tearDown(void) {
+  close(receiver);
+  close(sender);
+}
+
+// What a listener on the port gets
+std::string loopback(const char* data, size_t size) {
+  ssize_t sent =
+      sendto(sender, data, size, 0, (sockaddr*)&address, sizeof(address));
+  TEST_ASSERT_EQUAL(size, sent);
+  char received[2048];
+  ssize_t count = recv(receiver, received, sizeof(received), 0);
+  TEST_ASSERT_GREATER_THAN(0, count);
+  return std::string(received, count);
+}
+
+size_t occurrences(const std::string& text, const char* part) {
+  size_t count = 0;
+  for (size_t at = text.find(part); at != std::string::npos;
+       at = text.find(part, at + 1)) {
+    count++;
+  }
+  return count;
+}
+
+// brackets and braces balanced outside of strings
+bool balanced(const std::string& text) {
+  int depth = 0;
+  bool in_string = false;
+  for (char c : text) {
+    if (c == '"') {
+      in_string = !in_string;
+    } else if (!in_string && (c == '{' || c == '[')) {
+      depth++;
+    } else if (!in_string && (c == '}' || c == ']')) {
+      depth--;
+    }
+    if (depth < 0) {
+      return false;
+    }
+  }
+  return depth == 0 && !in_string;
+}
+
+void test_delta(void) {
+  UDPPacket<PACKET_SIZE> packet;
+  TEST_ASSERT_TRUE(packet.add_value("propulsion.main.revolutions", 30.5f));
+  TEST_ASSERT_TRUE(packet.add_value("propulsion.main.oilTemperature", 353.15f));
+  packet.end_delta();
+  std::string received = loopback(packet.data(), packet.size());
+  TEST_ASSERT_EQUAL_STRING(
+      "{\"updates\":[{\"values\":["
+      "{\"path\":\"propulsion.main.revolutions\",\"value\":30.5},"
+      "{\"path\":\"propulsion.main.oilTemperature\",\"value\":353.15}]}]}",
+      received.c_str());
+}
+
+void test_empty_delta_is_not_sent(void) {
+  UDPPacket<PACKET_SIZE> packet;
+  packet.end_delta();
+  TEST_ASSERT_EQUAL(0, packet.size());
+}
+
+// A full datagram still closes: the values that fit arrive intact
+void test_full_delta_still_closes(void) {
+  UDPPacket<PACKET_SIZE> packet;
+  size_t added = 0;
+  char path[64];
+  for (;;) {
+    snprintf(path, sizeof(path), "electrical.alternators.engine%u.voltage",
+             (unsigned)added);
+    if (!packet.add_value(path, 14.125f)) {
+      break;
+    }
+    added++;
+  }
+  TEST_ASSERT_GREATER_THAN(10, added);
+  size_t before = packet.size();
+  // a refused value leaves the packet as it was
+  TEST_ASSERT_FALSE(packet.add_value(path, 14.125f));
+  TEST_ASSERT_EQUAL(before, packet.size());
+  packet.end_delta();
+  TEST_ASSERT_LESS_THAN(PACKET_SIZE, packet.size());
+
+  std::string received = loopback(packet.data(), packet.size());
+  TEST_ASSERT_EQUAL(packet.size(), received.size());
+  TEST_ASSERT_EQUAL(0, received.find("{\"updates\":[{\"values\":["));
+  TEST_ASSERT_EQUAL(received.size() - 4, received.rfind("]}]}"));
+  TEST_ASSERT_EQUAL(added, occurrences(received, "\"path\""));
+  TEST_ASSERT_TRUE(balanced(received));
+}
+
+// Every size up to the closing bytes: never a delta that can't be closed
+void test_every_packet_size_closes(void) {
+  for (size_t fill = 0; fill < 80; fill++) {
+    UDPPacket<128> packet;
+    std::string name(fill, 'a');
+    while (packet.add_value(name.c_str(), 1.5f)) {
+      name = "b";
+    }
+    packet.end_delta();
+    if (packet.size() > 0) {
+      std::string text(packet.data(), packet.size());
+      TEST_ASSERT_EQUAL(text.size() - 4, text.rfind("]}]}"));
+      TEST_ASSERT_TRUE(balanced(text));
+    }
+  }
+}
+
+uint8_t checksum(const std::string& sentence) {
+  uint8_t sum = 0;
+  for (size_t i = 1; i < sentence.find('*'); i++) {
+    sum ^= sentence[i];
+  }
+  return sum;
+}
+
+void test_sentences(void) {
+  UDPPacket<PACKET_SIZE> packet;
+  TEST_ASSERT_TRUE(packet.begin_sentence("$ERRPM"));
+  TEST_ASSERT_TRUE(packet.append(",E,%u,%.1f,,A", 0, 1850.0f));
+  packet.end_sentence();
+  TEST_ASSERT_TRUE(packet.begin_sentence("$IIXDR"));
+  TEST_ASSERT_TRUE(packet.append(",%c,%.2f,%c,%s#%u", 'C', 82.5f, 'C',
+                                 "ENGINE", 0));
+  packet.end_sentence();
+
+  std::string received = loopback(packet.data(), packet.size());
+  size_t split = received.find("\r\n") + 2;
+  std::string rpm = received.substr(0, split);
+  std::string xdr = received.substr(split);
+  TEST_ASSERT_EQUAL_STRING("$ERRPM,E,0,1850.0,,A*52\r\n", rpm.c_str());
+  char expected[8];
+  snprintf(expected, sizeof(expected), "*%02X\r\n", checksum(xdr));
+  TEST_ASSERT_EQUAL(xdr.size() - 5, xdr.rfind(expected));
+  TEST_ASSERT_EQUAL(0, xdr.find("$IIXDR,C,82.50,C,ENGINE#0*"));
+}
+
+// Fields that don't fit are refused, the sentence still gets its checksum
+void test_full_sentence_still_closes(void) {
+  UDPPacket<64> packet;
+  TEST_ASSERT_TRUE(packet.begin_sentence("$IIXDR"));
+  size_t fields = 0;
+  while (packet.append(",C,%.2f,C,ALTERNATOR#%u", 71.25f, 0)) {
+    fields++;
+  }
+  TEST_ASSERT_GREATER_THAN(0, fields);
+  packet.end_sentence();
+  std::string received = loopback(packet.data(), packet.size());
+  TEST_ASSERT_LESS_THAN(64, received.size());
+  TEST_ASSERT_EQUAL(received.size() - 2, received.rfind("\r\n"));
+  TEST_ASSERT_EQUAL(fields, occurrences(received, "ALTERNATOR"));
+  char expected[8];
+  snprintf(expected, sizeof(expected), "*%02X\r\n", checksum(received));
+  TEST_ASSERT_EQUAL(received.size() - 5, received.rfind(expected));
+}
+
+void test_dropped_sentence(void) {
+  UDPPacket<PACKET_SIZE> packet;
+  packet.begin_sentence("$ERRPM");
+  packet.append(",E,%u,%.1f,,A", 1, 900.0f);
+  packet.end_sentence();
+  size_t size = packet.size();
+  packet.begin_sentence("$IIXDR");
+  packet.drop_sentence();
+  TEST_ASSERT_EQUAL(size, packet.size());
+  TEST_ASSERT_EQUAL(size, strlen(packet.data()));
+}
+
+// Datagrams sent per burst before the receiver drains them, well within
+// what the loopback socket buffers
+const int BURST = 16;
+const int DATAGRAMS = 20000;
+
+// Paths as UDPBroadcast::format_signalk() builds them for one engine
+const char* const PATHS[] = {
+    "propulsion.main.revolutions",
+    "propulsion.main.oilTemperature",
+    "propulsion.main.coolantTemperature",
+    "propulsion.main.exhaustTemperature",
+    "propulsion.main.fuel.rate",
+    "electrical.alternators.main.voltage",
+    "electrical.alternators.main.current",
+    "electrical.alternators.main.power",
+    "electrical.main.alternators.temperature",
+};
+
+// Full datagrams, formatted, sent and received one burst at a time: what a
+// helm tablet on the same network could take in at most
+void test_loopback_throughput(void) {
+  const size_t path_count = sizeof(PATHS) / sizeof(PATHS[0]);
+  UDPPacket<PACKET_SIZE> packet;
+  char received[2048];
+  size_t next = 0;
+  unsigned long sent_values = 0;
+  unsigned long received_datagrams = 0;
+  unsigned long received_bytes = 0;
+  unsigned long sent_bytes = 0;
+
+  auto start = std::chrono::steady_clock::now();
+  for (int burst = 0; burst < DATAGRAMS / BURST; burst++) {
+    for (int i = 0; i < BURST; i++) {
+      packet.clear();
+      while (packet.add_value(PATHS[next % path_count],
+                              300.0f + 0.01f * (next % 1000))) {
+        next++;
+        sent_values++;
+      }
+      packet.end_delta();
+      ssize_t sent = sendto(sender, packet.data(), packet.size(), 0,
+                            (sockaddr*)&address, sizeof(address));
+      TEST_ASSERT_EQUAL(packet.size(), sent);
+      sent_bytes += sent;
+    }
+    for (int i = 0; i < BURST; i++) {
+      ssize_t count = recv(receiver, received, sizeof(received), 0);
+      TEST_ASSERT_GREATER_THAN(0, count);
+      received_datagrams++;
+      received_bytes += count;
+    }
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  double seconds = std::chrono::duration<double>(elapsed).count();
+
+  TEST_ASSERT_EQUAL(DATAGRAMS / BURST * BURST, received_datagrams);
+  TEST_ASSERT_EQUAL(sent_bytes, received_bytes);
+  // the last datagram arrives intact
+  std::string last(received, packet.size());
+  TEST_ASSERT_EQUAL_STRING(packet.data(), last.c_str());
+  TEST_ASSERT_TRUE(balanced(last));
+
+  char message[160];
+  snprintf(message, sizeof(message),
+           "%.0f datagrams/s, %.0f values/s, %.1f MB/s over loopback on the "
+           "host",
+           received_datagrams / seconds, sent_values / seconds,
+           received_bytes / seconds / 1e6);
+  TEST_MESSAGE(message);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_delta);
+  RUN_TEST(test_empty_delta_is_not_sent);
+  RUN_TEST(test_full_delta_still_closes);
+  RUN_TEST(test_every_packet_size_closes);
+  RUN_TEST(test_sentences);
+  RUN_TEST(test_full_sentence_still_closes);
+  RUN_TEST(test_dropped_sentence);
+  RUN_TEST(test_loopback_throughput);
+  return UNITY_END();
+}
@@ -0,0 +1,185 @@
+// SlidingStats, the running statistics behind WindowStats
+#include <unity.h>
+
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "sensori/sliding_stats.h"
+
+using namespace sensesp;
+
+// what WindowStats uses for the slow channels
+const uint8_t WINDOW = 60;
+
+float history[10000];
+size_t added = 0;
+
+SlidingStats stats;
+
+void setUp(void) {
+  stats.resize(WINDOW);
+  added = 0;
+  srand(1);
+}
+
+void tearDown(void) {}
+
+void add(float value) {
+  history[added++] = value;
+  stats.add(value);
+}
+
+// The statistics of the last window samples, the slow way: two passes in
+// double
+struct Reference {
+  size_t n;
+  float minimum;
+  float maximum;
+  double mean;
+  double stddev;
+};
+
+Reference reference(uint8_t window) {
+  Reference r;
+  r.n = added < window ? added : window;
+  size_t first = added - r.n;
+  r.minimum = r.maximum = history[first];
+  double sum = 0;
+  for (size_t i = first; i < added; i++) {
+    r.minimum = fminf(r.minimum, history[i]);
+    r.maximum = fmaxf(r.maximum, history[i]);
+    sum += history[i];
+  }
+  r.mean = sum / r.n;
+  double m2 = 0;
+  for (size_t i = first; i < added; i++) {
+    m2 += (history[i] - r.mean) * (history[i] - r.mean);
+  }
+  r.stddev = r.n < 2 ? 0 : sqrt(m2 / (r.n - 1));
+  return r;
+}
+
+void assert_matches(uint8_t window) {
+  Reference r = reference(window);
+  TEST_ASSERT_EQUAL(r.n, stats.count());
+  TEST_ASSERT_EQUAL_FLOAT(r.minimum, stats.minimum());
+  TEST_ASSERT_EQUAL_FLOAT(r.maximum, stats.maximum());
+  TEST_ASSERT_FLOAT_WITHIN(1e-4f, r.mean, stats.mean());
+  TEST_ASSERT_FLOAT_WITHIN(1e-3f * r.stddev + 1e-4f, r.stddev, stats.stddev());
+}
+
+float noise() { return (rand() % 2001 - 1000) / 1000.0f; }
+
+void test_window_slides(void) {
+  for (int i = 1; i <= 200; i++) {
+    add((float)i);
+    assert_matches(WINDOW);
+  }
+  // 141 .. 200
+  TEST_ASSERT_EQUAL(WINDOW, stats.count());
+  TEST_ASSERT_EQUAL_FLOAT(141.0f, stats.minimum());
+  TEST_ASSERT_EQUAL_FLOAT(200.0f, stats.maximum());
+  TEST_ASSERT_FLOAT_WITHIN(1e-4f, 170.5f, stats.mean());
+}
+
+// A spike stays the maximum for exactly one window, then the next largest
+// sample takes over
+void test_extremes_leave_the_window(void) {
+  add(400.0f);
+  add(300.0f);
+  for (int i = 0; i < WINDOW - 2; i++) {
+    add(350.0f);
+  }
+  TEST_ASSERT_EQUAL_FLOAT(400.0f, stats.maximum());
+  TEST_ASSERT_EQUAL_FLOAT(300.0f, stats.minimum());
+  add(350.0f);
+  TEST_ASSERT_EQUAL_FLOAT(350.0f, stats.maximum());
+  TEST_ASSERT_EQUAL_FLOAT(300.0f, stats.minimum());
+  add(350.0f);
+  TEST_ASSERT_EQUAL_FLOAT(350.0f, stats.minimum());
+
+  // falling and rising runs, the worst cases of the two deques
+  for (int i = 0; i < 3 * WINDOW; i++) {
+    add(1000.0f - i);
+    assert_matches(WINDOW);
+  }
+  for (int i = 0; i < 3 * WINDOW; i++) {
+    add(500.0f + i);
+    assert_matches(WINDOW);
+  }
+}
+
+// Temperatures in kelvin: a large mean and a small spread, over hundreds of
+// turns of the window, where a running variance would drift
+void test_stddev_against_two_pass(void) {
+  for (size_t i = 0; i < 10000; i++) {
+    add(353.15f + 0.05f * i / WINDOW + 0.8f * noise());
+    assert_matches(WINDOW);
+  }
+}
+
+void test_constant_input(void) {
+  for (int i = 0; i < 3 * WINDOW + 7; i++) {
+    add(13.8f);
+  }
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, stats.stddev());
+  TEST_ASSERT_FLOAT_WITHIN(1e-5f, 13.8f, stats.mean());
+}
+
+void test_every_window_length(void) {
+  for (uint8_t window = 1; window <= WINDOW_STATS_MAX; window += 7) {
+    stats.resize(window);
+    added = 0;
+    for (int i = 0; i < 3 * window + 5; i++) {
+      add(14.0f + noise());
+      assert_matches(window);
+    }
+  }
+  stats.resize(200);
+  added = 0;
+  for (int i = 0; i < 2 * WINDOW_STATS_MAX; i++) {
+    add(noise());
+  }
+  TEST_ASSERT_EQUAL(WINDOW_STATS_MAX, stats.count());
+}
+
+void test_resize_starts_over(void) {
+  for (int i = 0; i < 100; i++) {
+    add(500.0f);
+  }
+  stats.resize(10);
+  added = 0;
+  add(1.0f);
+  add(3.0f);
+  TEST_ASSERT_EQUAL(2, stats.count());
+  TEST_ASSERT_EQUAL_FLOAT(3.0f, stats.maximum());
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 2.0f, stats.mean());
+}
+
+void test_benchmark(void) {
+  const int rounds = 1000000;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < rounds; i++) {
+    stats.add(353.15f + (i % 97) * 0.01f);
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  double ns = std::chrono::duration<double, std::nano>(elapsed).count() / rounds;
+  TEST_ASSERT_EQUAL(WINDOW, stats.count());
+  char message[80];
+  snprintf(message, sizeof(message), "%.1f ns per sample on the host", ns);
+  TEST_MESSAGE(message);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_window_slides);
+  RUN_TEST(test_extremes_leave_the_window);
+  RUN_TEST(test_stddev_against_two_pass);
+  RUN_TEST(test_constant_input);
+  RUN_TEST(test_every_window_length);
+  RUN_TEST(test_resize_starts_over);
+  RUN_TEST(test_benchmark);
+  return UNITY_END();
+}